@@ -0,0 +1,54 @@
+// Measures the time taken to parse a recipe, for the recipes an
+// application typically derives keys from.
+//
+// Usage: bench-recipe-parse [iterations]
+//
+// For each recipe it reports the time per parse for Recipe::tryParse
+// and, as a reference point, for building an nlohmann::json DOM of the
+// same recipe (the first step of the parser Recipe used previously).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "lib-seeded.hpp"
+
+static const char* recipes[] = {
+  "",
+  R"({"type":"SymmetricKey"})",
+  R"({"type":"UnsealingKey","purpose":"backups"})",
+  R"({"type":"Password","lengthInWords":10,"wordList":"EN_1024_words_6_chars_max_ed_4_20200917"})",
+  R"({"type":"Secret","lengthInBytes":64,"hashFunction":"Argon2id","hashFunctionMemoryPasses":2,"hashFunctionMemoryLimitInBytes":67108864})",
+  R"({"type":"UnsealingKey","allow":[{"host":"*.example.com"},{"host":"example.org","paths":["/a","/b"]}],"restrictToClientApplicationsIdPrefixes":["com.dicekeys.client","com.dicekeys.another"]})",
+};
+
+template <typename Parse>
+static double nanosecondsPerParse(const std::string& recipe, const size_t iterations, Parse parse) {
+  size_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    checksum += parse(recipe);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  // Keep the compiler from discarding the parses
+  if (checksum == (size_t) -1) {
+    std::printf("%zu\n", checksum);
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+  const size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+  std::printf("%-10s %-10s recipe\n", "Recipe", "DOM only");
+  for (const char* recipeCString : recipes) {
+    const std::string recipe(recipeCString);
+    const double recipeNs = nanosecondsPerParse(recipe, iterations, [](const std::string& r) -> size_t {
+      return Recipe::tryParse(r).value().lengthInBytes;
+    });
+    const double domNs = nanosecondsPerParse(recipe, iterations, [](const std::string& r) -> size_t {
+      return nlohmann::json::parse(r.size() == 0 ? "{}" : r).size();
+    });
+    std::printf("%7.0f ns %7.0f ns %s\n", recipeNs, domNs, recipe.c_str());
+  }
+  return 0;
+}
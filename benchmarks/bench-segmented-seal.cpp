@@ -0,0 +1,65 @@
+// Measures the throughput of SymmetricKeySegmented seal and unseal
+// of one large message as the number of threads grows, alongside
+// SymmetricKey's single-threaded seal and unseal of the same message.
+//
+// Usage: bench-segmented-seal [megabytes]
+//
+// The message is the given number of megabytes (default: 256).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "lib-seeded.hpp"
+#include "parallel-for.hpp"
+
+template <typename Operation>
+static double megabytesPerSecond(const size_t messageLength, Operation operation) {
+  const auto start = std::chrono::steady_clock::now();
+  operation();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return (double) messageLength / (1024 * 1024) /
+    std::chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char** argv) {
+  const size_t megabytes = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 256;
+  const size_t messageLength = megabytes * 1024 * 1024;
+  const std::string unsealingInstructions = R"({"userMustAcknowledgeThisMessage":"benchmark"})";
+  const SymmetricKey key("A1tB2rC3bD4lE5tF6bG1tH1tI1tJ1tK1tL1tM1tN1tO1tP1tR1tS1tT1tU1tV1tW1tX1tY1tZ1t", R"({"type":"SymmetricKey"})");
+  std::vector<unsigned char> message(messageLength, 'm');
+  std::vector<unsigned char> plaintext(messageLength);
+
+  std::printf("%-20s %-12s %-12s\n", "Threads", "Seal", "Unseal");
+  {
+    std::vector<unsigned char> ciphertext(key.sealedLength(messageLength));
+    const double sealRate = megabytesPerSecond(messageLength, [&]() {
+      key.sealToCiphertextOnly(
+        message.data(), message.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+      );
+    });
+    const double unsealRate = megabytesPerSecond(messageLength, [&]() {
+      key.unseal(ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), unsealingInstructions);
+    });
+    std::printf("%-20s %7.0f MB/s %7.0f MB/s\n", "1 (SymmetricKey)", sealRate, unsealRate);
+  }
+
+  std::vector<unsigned char> ciphertext(SymmetricKeySegmented::sealedLength(messageLength));
+  for (size_t threadCount = 1; threadCount <= defaultThreadCount(); threadCount *= 2) {
+    const double sealRate = megabytesPerSecond(messageLength, [&]() {
+      SymmetricKeySegmented::seal(
+        key, message.data(), message.size(), ciphertext.data(), ciphertext.size(),
+        unsealingInstructions, SymmetricKeySegmented::DefaultSegmentSize, threadCount
+      );
+    });
+    const double unsealRate = megabytesPerSecond(messageLength, [&]() {
+      SymmetricKeySegmented::tryUnseal(
+        key, ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(),
+        unsealingInstructions, threadCount
+      );
+    });
+    std::printf("%-20zu %7.0f MB/s %7.0f MB/s\n", threadCount, sealRate, unsealRate);
+  }
+  return 0;
+}
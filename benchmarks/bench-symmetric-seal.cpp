@@ -0,0 +1,110 @@
+// Measures the throughput of SymmetricKey seal and unseal, for each
+// of the ways a SymmetricKey recipe can configure them, across a range
+// of message sizes.
+//
+// Usage: bench-symmetric-seal [megabytes]
+//
+// AES256GCM recipes are skipped on CPUs without AES-NI and PCLMUL.
+//
+// Each message size is sealed and unsealed repeatedly, into buffers
+// allocated once, until about the given number of megabytes
+// (default: 256) has been processed.
+//
+// Then, for 100-byte messages, compares sealing and unsealing each
+// message with seal/unseal (allocating per message) against doing so
+// in batches of 1024 with sealBatch/unsealBatch.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "lib-seeded.hpp"
+
+static const char* recipes[] = {
+  R"({"type":"SymmetricKey"})",
+  R"({"type":"SymmetricKey","nonceType":"Random"})",
+  R"({"type":"SymmetricKey","algorithm":"XChaCha20Poly1305"})",
+  R"({"type":"SymmetricKey","algorithm":"XChaCha20Poly1305","nonceType":"Random"})",
+  R"({"type":"SymmetricKey","algorithm":"AES256GCM"})",
+  R"({"type":"SymmetricKey","algorithm":"AES256GCM","nonceType":"Random"})",
+};
+
+static const size_t messageLengths[] = { 64, 1024, 16 * 1024, 1024 * 1024 };
+
+template <typename Operation>
+static double megabytesPerSecond(const size_t messageLength, const size_t iterations, Operation operation) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    operation();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return (double) (messageLength * iterations) / (1024 * 1024) /
+    std::chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char** argv) {
+  const size_t megabytes = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 256;
+  const std::string unsealingInstructions = R"({"userMustAcknowledgeThisMessage":"benchmark"})";
+  std::printf("%-10s %-12s %-12s recipe\n", "Length", "Seal", "Unseal");
+  for (const char* recipe : recipes) {
+    const SymmetricKey key("A1tB2rC3bD4lE5tF6bG1tH1tI1tJ1tK1tL1tM1tN1tO1tP1tR1tS1tT1tU1tV1tW1tX1tY1tZ1t", recipe);
+    if (key.algorithm == RecipeJson::Algorithm::AES256GCM && !crypto_aead_aes256gcm_is_available()) {
+      std::printf("(unavailable on this CPU) %s\n", recipe);
+      continue;
+    }
+    for (const size_t messageLength : messageLengths) {
+      const size_t iterations = megabytes * 1024 * 1024 / messageLength;
+      std::vector<unsigned char> message(messageLength, 'm');
+      std::vector<unsigned char> ciphertext(key.sealedLength(messageLength));
+      std::vector<unsigned char> plaintext(messageLength);
+      const double sealRate = megabytesPerSecond(messageLength, iterations, [&]() {
+        key.sealToCiphertextOnly(
+          message.data(), message.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+        );
+      });
+      const double unsealRate = megabytesPerSecond(messageLength, iterations, [&]() {
+        key.unseal(
+          ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+        );
+      });
+      std::printf("%-10zu %7.0f MB/s %7.0f MB/s %s\n", messageLength, sealRate, unsealRate, recipe);
+    }
+  }
+
+  const SymmetricKey key("A1tB2rC3bD4lE5tF6bG1tH1tI1tJ1tK1tL1tM1tN1tO1tP1tR1tS1tT1tU1tV1tW1tX1tY1tZ1t", recipes[0]);
+  const size_t messageLength = 100;
+  const size_t batchSize = 1024;
+  const size_t batches = megabytes * 1024 * 1024 / (messageLength * batchSize);
+  std::vector<unsigned char> messages(messageLength * batchSize, 'm');
+  std::vector<BatchMessage> batch;
+  for (size_t i = 0; i < batchSize; i++) {
+    batch.push_back({messages.data() + i * messageLength, messageLength, &unsealingInstructions});
+  }
+  std::vector<PackagedSealedMessage> packaged;
+  const double sealRate = megabytesPerSecond(messageLength * batchSize, batches, [&]() {
+    packaged.clear();
+    for (const BatchMessage& message : batch) {
+      packaged.push_back(key.seal(message.data, message.length, unsealingInstructions));
+    }
+  });
+  const double unsealRate = megabytesPerSecond(messageLength * batchSize, batches, [&]() {
+    for (const PackagedSealedMessage& message : packaged) {
+      key.unseal(message);
+    }
+  });
+  std::printf("%-10zu %7.0f MB/s %7.0f MB/s seal/unseal, one message at a time\n", messageLength, sealRate, unsealRate);
+  SealedBatch sealed;
+  const double sealBatchRate = megabytesPerSecond(messageLength * batchSize, batches, [&]() {
+    sealed = key.sealBatch(batch.data(), batch.size());
+  });
+  std::vector<BatchMessage> ciphertexts;
+  for (size_t i = 0; i < sealed.size(); i++) {
+    ciphertexts.push_back({sealed.data(i), sealed.length(i), &unsealingInstructions});
+  }
+  const double unsealBatchRate = megabytesPerSecond(messageLength * batchSize, batches, [&]() {
+    key.unsealBatch(ciphertexts.data(), ciphertexts.size());
+  });
+  std::printf("%-10zu %7.0f MB/s %7.0f MB/s sealBatch/unsealBatch of %zu\n", messageLength, sealBatchRate, unsealBatchRate, batchSize);
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Measures draining a queue of small sealed messages with an UnsealingKey:
+// one unseal call per message, unsealBatch starting threads for each batch,
+// and unsealBatch on a WorkerPool whose threads persist between batches.
+//
+// Usage: bench-unsealing-key-batch [messages] [batch size]
+//
+// (default: 20000 messages drained in batches of 1000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "lib-seeded.hpp"
+
+template <typename Drain>
+static double microsecondsPerMessage(const size_t messages, Drain drain) {
+  const auto start = std::chrono::steady_clock::now();
+  drain();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / messages;
+}
+
+int main(int argc, char** argv) {
+  const size_t messageCount = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 20000;
+  const size_t batchSize = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 1000;
+  const std::string unsealingInstructions = R"({"userMustAcknowledgeThisMessage":"benchmark"})";
+  const UnsealingKey key(
+    "A1tB2rC3bD4lE5tF6bG1tH1tI1tJ1tK1tL1tM1tN1tO1tP1tR1tS1tT1tU1tV1tW1tX1tY1tZ1t", R"({"type":"UnsealingKey"})"
+  );
+  const std::vector<unsigned char> message(64, 'm');
+  std::vector<BatchMessage> messages(messageCount, {message.data(), message.size(), &unsealingInstructions});
+  const SealedBatch sealed = key.getSealingKey().sealBatch(messages.data(), messages.size(), 0);
+  std::vector<BatchMessage> ciphertexts;
+  for (size_t i = 0; i < sealed.size(); i++) {
+    ciphertexts.push_back({sealed.data(i), sealed.length(i), &unsealingInstructions});
+  }
+
+  const double oneByOne = microsecondsPerMessage(messageCount, [&]() {
+    for (const BatchMessage& ciphertext : ciphertexts) {
+      key.unseal(ciphertext.data, ciphertext.length, unsealingInstructions);
+    }
+  });
+  const double threadsPerBatch = microsecondsPerMessage(messageCount, [&]() {
+    for (size_t start = 0; start < messageCount; start += batchSize) {
+      key.unsealBatch(ciphertexts.data() + start, std::min(batchSize, messageCount - start), 0);
+    }
+  });
+  WorkerPool pool;
+  const double pooled = microsecondsPerMessage(messageCount, [&]() {
+    for (size_t start = 0; start < messageCount; start += batchSize) {
+      key.unsealBatch(ciphertexts.data() + start, std::min(batchSize, messageCount - start), pool);
+    }
+  });
+
+  std::printf("%zu threads\n", pool.threadCount());
+  std::printf("%-30s %8.1f us/message\n", "unseal, one call per message", oneByOne);
+  std::printf("%-30s %8.1f us/message\n", "unsealBatch, threads per call", threadsPerBatch);
+  std::printf("%-30s %8.1f us/message\n", "unsealBatch, WorkerPool", pooled);
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include <cstring>
+#include <stdexcept>
+#include "authenticated-box.hpp"
+
+namespace AuthenticatedBoxErrors {
+  static const SeededError invalidMessageLength = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Authenticated unseal failed: Invalid message length"
+  };
+  static const SeededError unsealFailed = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Authenticated unseal failed: the message wasn't sealed by the sender for this key, the unsealing instructions do not match those used to seal the message, or the ciphertext was modified/corrupted."
+  };
+}
+
+const size_t AuthenticatedBox::OverheadBytes;
+
+// The context that separates box nonces from other hashes
+static const char nonceContext[] = "AuthenticatedBox";
+
+// The nonce a message is boxed with, salted with the direction it
+// was sent in and its unsealingInstructions
+static void saltNonce(
+  unsigned char* boxNonce,
+  const unsigned char* nonce,
+  const unsigned char* senderPublicKey,
+  const unsigned char* recipientPublicKey,
+  const std::string& unsealingInstructions
+) {
+  crypto_generichash_state st;
+  crypto_generichash_init(&st, NULL, 0, crypto_box_NONCEBYTES);
+  crypto_generichash_update(&st, (const unsigned char*) nonceContext, sizeof nonceContext - 1);
+  crypto_generichash_update(&st, nonce, crypto_box_NONCEBYTES);
+  crypto_generichash_update(&st, senderPublicKey, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, recipientPublicKey, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length());
+  crypto_generichash_final(&st, boxNonce, crypto_box_NONCEBYTES);
+}
+
+AuthenticatedBox::AuthenticatedBox(const UnsealingKey& key, const size_t _cacheCapacity) :
+  unsealingKeyBytes(key.unsealingKeyBytes),
+  sealingKeyBytes(key.sealingKeyBytes),
+  cacheCapacity(_cacheCapacity),
+  sharedKeys(_cacheCapacity * crypto_box_BEFORENMBYTES)
+{
+  if (cacheCapacity == 0) {
+    throw std::invalid_argument("Cache capacity must be at least 1");
+  }
+}
+
+// Copy the shared key with a peer into sharedKey, computing and caching
+// it if it isn't already cached. Returns false if the peer's key is invalid.
+bool AuthenticatedBox::sharedKeyWith(
+  const std::vector<unsigned char>& peerPublicKey,
+  unsigned char* sharedKey
+) {
+  if (peerPublicKey.size() != crypto_box_PUBLICKEYBYTES) {
+    return false;
+  }
+  const std::string peer(peerPublicKey.begin(), peerPublicKey.end());
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const auto cached = peers.find(peer);
+    if (cached != peers.end()) {
+      peersByRecency.splice(peersByRecency.begin(), peersByRecency, cached->second);
+      memcpy(sharedKey, sharedKeys.data + cached->second->second * crypto_box_BEFORENMBYTES, crypto_box_BEFORENMBYTES);
+      return true;
+    }
+  }
+  // Computed without holding the lock, so that messages to and from
+  // cached peers don't wait on the scalar multiplication
+  if (crypto_box_beforenm(sharedKey, peerPublicKey.data(), unsealingKeyBytes.data) != 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (peers.count(peer) > 0) {
+    // Another thread cached it in the meantime
+    return true;
+  }
+  size_t slot = peersByRecency.size();
+  if (slot == cacheCapacity) {
+    slot = peersByRecency.back().second;
+    peers.erase(peersByRecency.back().first);
+    peersByRecency.pop_back();
+  }
+  memcpy(sharedKeys.data + slot * crypto_box_BEFORENMBYTES, sharedKey, crypto_box_BEFORENMBYTES);
+  peersByRecency.emplace_front(peer, slot);
+  peers.emplace(peer, peersByRecency.begin());
+  return true;
+}
+
+size_t AuthenticatedBox::seal(
+  const SealingKey& recipient,
+  const unsigned char* message,
+  const size_t messageLength,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
+  const std::string& unsealingInstructions
+) {
+  if (ciphertextCapacity < sealedLength(messageLength)) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  if (!sharedKeyWith(recipient.sealingKeyBytes, sharedKey)) {
+    throw std::invalid_argument("Invalid key");
+  }
+  unsigned char boxNonce[crypto_box_NONCEBYTES];
+  randombytes_buf(ciphertext, crypto_box_NONCEBYTES);
+  saltNonce(boxNonce, ciphertext, sealingKeyBytes.data(), recipient.sealingKeyBytes.data(), unsealingInstructions);
+  crypto_box_easy_afternm(ciphertext + crypto_box_NONCEBYTES, message, messageLength, boxNonce, sharedKey);
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  return sealedLength(messageLength);
+}
+
+const std::vector<unsigned char> AuthenticatedBox::seal(
+  const SealingKey& recipient,
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions
+) {
+  std::vector<unsigned char> ciphertext(sealedLength(messageLength));
+  seal(recipient, message, messageLength, ciphertext.data(), ciphertext.size(), unsealingInstructions);
+  return ciphertext;
+}
+
+Result<SodiumBuffer> AuthenticatedBox::tryUnseal(
+  const SealingKey& sender,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions
+) {
+  if (ciphertextLength < OverheadBytes) {
+    return AuthenticatedBoxErrors::invalidMessageLength;
+  }
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  if (!sharedKeyWith(sender.sealingKeyBytes, sharedKey)) {
+    return AuthenticatedBoxErrors::unsealFailed;
+  }
+  unsigned char boxNonce[crypto_box_NONCEBYTES];
+  saltNonce(boxNonce, ciphertext, sender.sealingKeyBytes.data(), sealingKeyBytes.data(), unsealingInstructions);
+  Result<SodiumBuffer> plaintext(ResultInPlace(), ciphertextLength - OverheadBytes);
+  const int result = crypto_box_open_easy_afternm(
+    plaintext.value().data,
+    ciphertext + crypto_box_NONCEBYTES, ciphertextLength - crypto_box_NONCEBYTES,
+    boxNonce, sharedKey
+  );
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  if (result != 0) {
+    return AuthenticatedBoxErrors::unsealFailed;
+  }
+  return plaintext;
+}
+
+const SodiumBuffer AuthenticatedBox::unseal(
+  const SealingKey& sender,
+  const std::vector<unsigned char>& ciphertext,
+  const std::string& unsealingInstructions
+) {
+  return tryUnseal(sender, ciphertext.data(), ciphertext.size(), unsealingInstructions).valueOrThrow();
+}
+
+size_t AuthenticatedBox::cachedPeers() const {
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  return peersByRecency.size();
+}
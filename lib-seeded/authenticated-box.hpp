@@ -0,0 +1,174 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "sealing-key.hpp"
+#include "unsealing-key.hpp"
+#include "result.hpp"
+
+/**
+ * @brief Authenticated public-key encryption between long-lived key pairs:
+ * messages sealed with one party's UnsealingKey for another's SealingKey,
+ * which the recipient unseals knowing the sender's SealingKey.
+ *
+ * Unlike SealingKey::seal, which performs an X25519 exchange with a new
+ * ephemeral key for every message, an AuthenticatedBox computes the shared
+ * key with each peer (crypto_box_beforenm) once and caches it, so that
+ * every later message to or from that peer costs only symmetric
+ * encryption (crypto_box_easy_afternm). Since the shared key is the same
+ * in both directions, one cache entry serves sealing to a peer and
+ * unsealing from it.
+ *
+ * The shared keys are cached in locked memory (a SodiumBuffer); when
+ * the cache is full, the least recently used peer's key is overwritten
+ * to make room.
+ *
+ * A sealed message is a random nonce followed by the box:
+ * ```
+ *   <nonce: 24 bytes> <crypto_box_easy_afternm(message): length + 16 bytes>
+ * ```
+ * The box is sealed not with the nonce sent but with one salted with the
+ * parties' public keys and the unsealingInstructions:
+ * ```
+ *   BLAKE2b-192("AuthenticatedBox" <nonce> <sender public key> <recipient public key> <unsealingInstructions>)
+ * ```
+ * so a message only unseals with the instructions it was sealed with, and
+ * can't be reflected back to its sender as if the recipient had sent it.
+ *
+ * Safe to use from any number of threads at once.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class AuthenticatedBox {
+  const SodiumBuffer unsealingKeyBytes;
+  const std::vector<unsigned char> sealingKeyBytes;
+  const size_t cacheCapacity;
+
+  mutable std::mutex cacheMutex;
+  // Shared keys, crypto_box_BEFORENMBYTES each, in slots assigned as peers are added
+  SodiumBuffer sharedKeys;
+  // The cached peers' public keys and slots, the most recently used first
+  std::list<std::pair<std::string, size_t>> peersByRecency;
+  // Peers' public keys to their position in peersByRecency
+  std::unordered_map<std::string, std::list<std::pair<std::string, size_t>>::iterator> peers;
+
+  AuthenticatedBox(const AuthenticatedBox&) = delete;
+  AuthenticatedBox& operator=(const AuthenticatedBox&) = delete;
+
+  bool sharedKeyWith(const std::vector<unsigned char>& peerPublicKey, unsigned char* sharedKey);
+
+public:
+  /**
+   * @brief The number of bytes a sealed message is longer than its plaintext
+   */
+  static const size_t OverheadBytes = crypto_box_NONCEBYTES + crypto_box_MACBYTES;
+
+  /**
+   * @brief The length of a sealed message of a given plaintext length
+   */
+  static size_t sealedLength(const size_t messageLength) { return messageLength + OverheadBytes; }
+
+  /**
+   * @brief Prepare to exchange messages as the owner of a key pair
+   *
+   * @param key This party's key pair, which is copied
+   * @param cacheCapacity The number of peers whose shared keys are cached
+   * (at least 1)
+   */
+  explicit AuthenticatedBox(const UnsealingKey& key, const size_t cacheCapacity = 256);
+
+  /**
+   * @brief Seal a message that only the recipient can unseal, and which
+   * the recipient can verify was sealed by this party.
+   *
+   * @param recipient The recipient's SealingKey
+   * @param message The plaintext to seal
+   * @param messageLength The length of the plaintext
+   * @param ciphertext The buffer to write the sealed message to
+   * @param ciphertextCapacity The size of the ciphertext buffer,
+   * which must be at least sealedLength(messageLength)
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return size_t The length of the sealed message
+   *
+   * @throws std::invalid_argument if the ciphertext buffer is too small
+   * or the recipient's key is invalid
+   */
+  size_t seal(
+    const SealingKey& recipient,
+    const unsigned char* message,
+    const size_t messageLength,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief Seal a message that only the recipient can unseal, and which
+   * the recipient can verify was sealed by this party.
+   *
+   * @param recipient The recipient's SealingKey
+   * @param message The plaintext to seal
+   * @param messageLength The length of the plaintext
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const std::vector<unsigned char> The sealed message
+   *
+   * @throws std::invalid_argument if the recipient's key is invalid
+   */
+  const std::vector<unsigned char> seal(
+    const SealingKey& recipient,
+    const unsigned char* message,
+    const size_t messageLength,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief Unseal a message sealed for this party by a sender,
+   * without throwing.
+   *
+   * @param sender The sender's SealingKey
+   * @param ciphertext The sealed message
+   * @param ciphertextLength The length of the sealed message
+   * @param unsealingInstructions The unsealingInstructions
+   * the message was sealed with, if any
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal
+   * would have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const SealingKey& sender,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief Unseal a message sealed for this party by a sender
+   *
+   * @param sender The sender's SealingKey
+   * @param ciphertext The sealed message
+   * @param unsealingInstructions The unsealingInstructions
+   * the message was sealed with, if any
+   * @return const SodiumBuffer The plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the
+   * message wasn't sealed by the sender for this party with these
+   * unsealingInstructions, or was modified/corrupted.
+   */
+  const SodiumBuffer unseal(
+    const SealingKey& sender,
+    const std::vector<unsigned char>& ciphertext,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief The number of peers whose shared keys are cached
+   */
+  size_t cachedPeers() const;
+};
@@ -33,3 +33,24 @@ const std::vector<unsigned char> hexStrToByteVector(const std::string hexStr)
   }
   return byteVector;
 }
+
+const SeededError hexStrError(const std::string& hexStr)
+{
+  size_t start = 0;
+  while (hexStr.length() >= start + 2 && hexStr[start + 1] == 'x' && hexStr[start] == '0') {
+    // Ignore prefix '0x'
+    start += 2;
+  }
+  if ((hexStr.length() - start) % 2 == 1) {
+    return {SeededErrorCode::InvalidArgument, "Invalid hex string length"};
+  }
+  for (size_t i = start; i < hexStr.length(); i++) {
+    const char c = hexStr[i];
+    if (!(
+      (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')
+    )) {
+      return {SeededErrorCode::InvalidHexCharacter, "Could not parse non-hex character"};
+    }
+  }
+  return {SeededErrorCode::None, NULL};
+}
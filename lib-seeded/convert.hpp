@@ -5,6 +5,7 @@
 #include <vector>
 #include <algorithm>
 #include "sodium-buffer.hpp"
+#include "result.hpp"
 
 
 class InvalidHexCharacterException : public std::invalid_argument
@@ -30,6 +31,13 @@ inline unsigned char parseHexChar(char c) {
 const std::string toHexStr(const std::vector<unsigned char> bytes);
 const std::vector<unsigned char> hexStrToByteVector(const std::string hexStr);
 
+/**
+ * @brief Check a hex string without converting it, returning the error
+ * that hexStrToByteVector (or SodiumBuffer::fromHexString) would throw,
+ * or an error with code SeededErrorCode::None if the string is valid.
+ */
+const SeededError hexStrError(const std::string& hexStr);
+
 inline std::string toUpper(const std::string& a) {
   std::string upper = a;
   std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
@@ -9,6 +9,7 @@
 #include <string.h>
 #include "sodium.h"
 #include "crypto_box_seal_salted.h"
+#include "crypto_fragments.h"
 
 /**
  * Generate a nonce to use for sealing a message sent
@@ -55,7 +56,6 @@ crypto_box_salted_seal(
   const size_t salt_length  
 )
 {
-    unsigned char nonce[crypto_box_NONCEBYTES];
     unsigned char epk[crypto_box_PUBLICKEYBYTES];
     unsigned char esk[crypto_box_SECRETKEYBYTES];
     int           ret;
@@ -64,13 +64,103 @@ crypto_box_salted_seal(
     if (crypto_box_keypair(epk, esk) != 0) {
         return -1; /* LCOV_EXCL_LINE */
     }
+    ret = crypto_box_salted_seal_with_keypair(output_ciphertext, message, message_length,
+                                              recipients_curve22519_public_key, epk, esk,
+                                              salt, salt_length);
+    sodium_memzero(esk, sizeof esk);
+    sodium_memzero(epk, sizeof epk);
+
+    return ret;
+}
+
+/**
+ * As crypto_box_salted_seal, but with an ephemeral keypair
+ * the caller generated in advance (and must use only once).
+ */
+int
+crypto_box_salted_seal_with_keypair(
+  unsigned char *output_ciphertext,
+  const unsigned char *message,
+  unsigned long long message_length,
+  const unsigned char *recipients_curve22519_public_key,
+  const unsigned char *epk,
+  const unsigned char *esk,
+  const char* salt,
+  const size_t salt_length
+)
+{
+    unsigned char nonce[crypto_box_NONCEBYTES];
+    int           ret;
+
     memcpy(output_ciphertext, epk, crypto_box_PUBLICKEYBYTES);
     _crypto_box_seal_nonce_salted(nonce, epk, recipients_curve22519_public_key, salt, salt_length);
     ret = crypto_box_easy(output_ciphertext + crypto_box_PUBLICKEYBYTES,
                           message, message_length,
                           nonce, recipients_curve22519_public_key, esk);
+    sodium_memzero(nonce, sizeof nonce);
+
+    return ret;
+}
+
+/**
+ * The fragmented equivalent of crypto_box_salted_seal.
+ */
+int
+crypto_box_salted_seal_fragments(
+  unsigned char *output_ciphertext,
+  const Fragment *message_fragments,
+  size_t fragment_count,
+  const unsigned char *recipients_curve22519_public_key,
+  const char* salt,
+  const size_t salt_length
+)
+{
+    unsigned char epk[crypto_box_PUBLICKEYBYTES];
+    unsigned char esk[crypto_box_SECRETKEYBYTES];
+    int           ret;
+
+    if (crypto_box_keypair(epk, esk) != 0) {
+        return -1; /* LCOV_EXCL_LINE */
+    }
+    ret = crypto_box_salted_seal_fragments_with_keypair(output_ciphertext, message_fragments, fragment_count,
+                                                        recipients_curve22519_public_key, epk, esk,
+                                                        salt, salt_length);
     sodium_memzero(esk, sizeof esk);
     sodium_memzero(epk, sizeof epk);
+
+    return ret;
+}
+
+/**
+ * The fragmented equivalent of crypto_box_salted_seal_with_keypair.
+ * crypto_box_easy is crypto_box_beforenm followed by
+ * crypto_secretbox_easy with the shared key, so the box
+ * can be sealed one fragment at a time.
+ */
+int
+crypto_box_salted_seal_fragments_with_keypair(
+  unsigned char *output_ciphertext,
+  const Fragment *message_fragments,
+  size_t fragment_count,
+  const unsigned char *recipients_curve22519_public_key,
+  const unsigned char *epk,
+  const unsigned char *esk,
+  const char* salt,
+  const size_t salt_length
+)
+{
+    unsigned char nonce[crypto_box_NONCEBYTES];
+    unsigned char k[crypto_box_BEFORENMBYTES];
+    int           ret;
+
+    memcpy(output_ciphertext, epk, crypto_box_PUBLICKEYBYTES);
+    _crypto_box_seal_nonce_salted(nonce, epk, recipients_curve22519_public_key, salt, salt_length);
+    ret = crypto_box_beforenm(k, recipients_curve22519_public_key, esk);
+    if (ret == 0) {
+        crypto_secretbox_easy_fragments(output_ciphertext + crypto_box_PUBLICKEYBYTES,
+                                        message_fragments, fragment_count, nonce, k);
+    }
+    sodium_memzero(k, sizeof k);
     sodium_memzero(nonce, sizeof nonce);
 
     return ret;
@@ -97,3 +187,20 @@ crypto_box_salted_seal_open(
                                 nonce, c, sk);
 }
 
+/**
+ * Compute the shared key k and the nonce needed to open a salted sealed
+ * box c, without opening it, so that the caller can verify the box
+ * (crypto_secretbox_easy_verify) before allocating space for its plaintext.
+ * The box itself starts at c + crypto_box_PUBLICKEYBYTES.
+ */
+int
+crypto_box_salted_seal_beforenm(
+  unsigned char *k, unsigned char *nonce,
+  const unsigned char *c,
+  const unsigned char *pk, const unsigned char *sk,
+  const char* salt, const size_t salt_length
+)
+{
+    _crypto_box_seal_nonce_salted(nonce, c, pk, salt, salt_length);
+    return crypto_box_beforenm(k, c, sk);
+}
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "fragments.hpp"
+
 int crypto_box_salted_seal(
   unsigned char* c, const unsigned char* m,
   unsigned long long mlen, const unsigned char* pk,
@@ -14,6 +16,41 @@ int crypto_box_salted_seal(
   const size_t salt_length
 );
 
+/**
+ * As crypto_box_salted_seal, but with an ephemeral keypair (epk, esk)
+ * generated in advance, which must never be used for another message.
+ */
+int crypto_box_salted_seal_with_keypair(
+  unsigned char* c, const unsigned char* m,
+  unsigned long long mlen, const unsigned char* pk,
+  const unsigned char* epk, const unsigned char* esk,
+  const char* salt,
+  const size_t salt_length
+);
+
+/**
+ * As crypto_box_salted_seal, but sealing the concatenation of the
+ * fragments m without first copying them together.
+ */
+int crypto_box_salted_seal_fragments(
+  unsigned char* c, const Fragment* m, size_t m_count,
+  const unsigned char* pk,
+  const char* salt,
+  const size_t salt_length
+);
+
+/**
+ * As crypto_box_salted_seal_fragments, but with an ephemeral keypair
+ * generated in advance, which must never be used for another message.
+ */
+int crypto_box_salted_seal_fragments_with_keypair(
+  unsigned char* c, const Fragment* m, size_t m_count,
+  const unsigned char* pk,
+  const unsigned char* epk, const unsigned char* esk,
+  const char* salt,
+  const size_t salt_length
+);
+
 int
 crypto_box_salted_seal_open(
   unsigned char* m, const unsigned char* c,
@@ -21,3 +58,11 @@ crypto_box_salted_seal_open(
   const unsigned char* pk, const unsigned char* sk,
   const char* salt, const size_t salt_length
 );
+
+int
+crypto_box_salted_seal_beforenm(
+  unsigned char* k, unsigned char* nonce,
+  const unsigned char* c,
+  const unsigned char* pk, const unsigned char* sk,
+  const char* salt, const size_t salt_length
+);
@@ -0,0 +1,247 @@
+/************************************
+ * Mirrors crypto_secretbox_xsalsa20poly1305 and
+ * crypto_aead_xchacha20poly1305_ietf in libsodium, but feeds each
+ * fragment through the stream cipher and Poly1305 in turn.
+ *
+ * Both constructions encrypt with a keystream whose first bytes are the
+ * Poly1305 key: the secret box's message starts 32 bytes into the
+ * XSalsa20 keystream, and the AEAD's message starts at the second 64-byte
+ * block of the XChaCha20 keystream. The XChaCha20 keystream libsodium's
+ * IETF AEAD uses (HChaCha20 subkey, 32-bit counter, nonce prefixed with
+ * four zero bytes) is the same as crypto_stream_xchacha20's for any
+ * message short enough for a 32-bit block counter.
+ */
+#include <string.h>
+#include "sodium.h"
+#include "crypto_fragments.h"
+
+typedef int (*stream_xor_ic_function)(
+  unsigned char* c, const unsigned char* m, unsigned long long mlen,
+  const unsigned char* n, uint64_t ic, const unsigned char* k
+);
+
+static const size_t stream_block_bytes = 64U;
+static const size_t aead_message_start = 64U;
+static const unsigned char pad0[16] = { 0 };
+
+// XOR in with the keystream starting keystream_offset bytes in,
+// which needn't fall on a block boundary.
+static void stream_xor_at(
+  stream_xor_ic_function stream_xor_ic,
+  unsigned char* out, const unsigned char* in, size_t length,
+  uint64_t keystream_offset,
+  const unsigned char* n, const unsigned char* k
+) {
+    unsigned char block[stream_block_bytes];
+
+    while (length > 0) {
+        const uint64_t ic = keystream_offset / stream_block_bytes;
+        const size_t within_block = (size_t) (keystream_offset % stream_block_bytes);
+        size_t piece;
+        if (within_block == 0 && length >= stream_block_bytes) {
+            // Whole blocks go straight through the stream cipher
+            piece = length - length % stream_block_bytes;
+            stream_xor_ic(out, in, piece, n, ic, k);
+        } else {
+            piece = stream_block_bytes - within_block < length ?
+              stream_block_bytes - within_block : length;
+            memset(block, 0U, sizeof block);
+            stream_xor_ic(block, block, sizeof block, n, ic, k);
+            for (size_t i = 0; i < piece; i++) {
+                out[i] = in[i] ^ block[within_block + i];
+            }
+        }
+        out += piece;
+        in += piece;
+        length -= piece;
+        keystream_offset += piece;
+    }
+    sodium_memzero(block, sizeof block);
+}
+
+// XOR bytes [offset, offset + length) of the fragments c with the
+// keystream starting keystream_start bytes in, writing the result
+// across the fragments m
+static void stream_xor_fragments_at(
+  stream_xor_ic_function stream_xor_ic,
+  const OutputFragment* m, size_t m_count,
+  const Fragment* c, size_t c_count, size_t offset, size_t length,
+  uint64_t keystream_start,
+  const unsigned char* n, const unsigned char* k
+) {
+    Fragments::forEachPiece(c, c_count, offset, length,
+      [&](const unsigned char* in, const size_t in_length, const size_t in_position) {
+        Fragments::forEachPiece(m, m_count, in_position, in_length,
+          [&](unsigned char* out, const size_t out_length, const size_t out_position) {
+            stream_xor_at(
+              stream_xor_ic, out, in + out_position, out_length,
+              keystream_start + in_position + out_position, n, k
+            );
+          }
+        );
+      }
+    );
+}
+
+static void store64_le(unsigned char out[8], uint64_t value) {
+    for (size_t i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+void crypto_secretbox_easy_fragments(
+  unsigned char* c,
+  const Fragment* m, size_t m_count,
+  const unsigned char* n, const unsigned char* k
+) {
+    unsigned char                     poly1305_key[crypto_onetimeauth_poly1305_KEYBYTES];
+    crypto_onetimeauth_poly1305_state state;
+    unsigned char*                    secret = c + crypto_secretbox_MACBYTES;
+    size_t                            position = 0;
+
+    crypto_stream_xsalsa20(poly1305_key, sizeof poly1305_key, n, k);
+    crypto_onetimeauth_poly1305_init(&state, poly1305_key);
+    for (size_t i = 0; i < m_count; i++) {
+        stream_xor_at(
+          crypto_stream_xsalsa20_xor_ic, secret + position, m[i].data, m[i].length,
+          sizeof poly1305_key + position, n, k
+        );
+        crypto_onetimeauth_poly1305_update(&state, secret + position, m[i].length);
+        position += m[i].length;
+    }
+    crypto_onetimeauth_poly1305_final(&state, c);
+    sodium_memzero(&state, sizeof state);
+    sodium_memzero(poly1305_key, sizeof poly1305_key);
+}
+
+int crypto_secretbox_easy_verify_fragments(
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+) {
+    unsigned char                     poly1305_key[crypto_onetimeauth_poly1305_KEYBYTES];
+    unsigned char                     mac[crypto_secretbox_MACBYTES];
+    unsigned char                     computed_mac[crypto_secretbox_MACBYTES];
+    crypto_onetimeauth_poly1305_state state;
+    int                               ret;
+
+    if (clen < crypto_secretbox_MACBYTES) {
+        return -1;
+    }
+    Fragments::gather(mac, c, c_count, offset, sizeof mac);
+    crypto_stream_xsalsa20(poly1305_key, sizeof poly1305_key, n, k);
+    crypto_onetimeauth_poly1305_init(&state, poly1305_key);
+    Fragments::forEachPiece(c, c_count, offset + crypto_secretbox_MACBYTES, clen - crypto_secretbox_MACBYTES,
+      [&state](const unsigned char* data, const size_t length, const size_t) {
+        crypto_onetimeauth_poly1305_update(&state, data, length);
+      }
+    );
+    crypto_onetimeauth_poly1305_final(&state, computed_mac);
+    ret = crypto_verify_16(computed_mac, mac);
+    sodium_memzero(&state, sizeof state);
+    sodium_memzero(poly1305_key, sizeof poly1305_key);
+
+    return ret;
+}
+
+void crypto_secretbox_easy_open_verified_fragments(
+  const OutputFragment* m, size_t m_count,
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+) {
+    stream_xor_fragments_at(
+      crypto_stream_xsalsa20_xor_ic, m, m_count,
+      c, c_count, offset + crypto_secretbox_MACBYTES, (size_t) (clen - crypto_secretbox_MACBYTES),
+      crypto_onetimeauth_poly1305_KEYBYTES, n, k
+    );
+}
+
+// Key Poly1305 with the first block of the XChaCha20 keystream and
+// authenticate the associated data, as the AEAD does before the message
+static void aead_poly1305_init(
+  crypto_onetimeauth_poly1305_state* state,
+  const unsigned char* ad, unsigned long long adlen,
+  const unsigned char* npub, const unsigned char* k
+) {
+    unsigned char block0[stream_block_bytes];
+
+    memset(block0, 0U, sizeof block0);
+    crypto_stream_xchacha20_xor_ic(block0, block0, sizeof block0, npub, 0U, k);
+    crypto_onetimeauth_poly1305_init(state, block0);
+    sodium_memzero(block0, sizeof block0);
+    crypto_onetimeauth_poly1305_update(state, ad, adlen);
+    crypto_onetimeauth_poly1305_update(state, pad0, (0x10 - adlen) & 0xf);
+}
+
+// Authenticate the message and associated data lengths, as the AEAD
+// does after the message, and compute the tag
+static void aead_poly1305_final(
+  crypto_onetimeauth_poly1305_state* state,
+  unsigned char* mac,
+  unsigned long long adlen, unsigned long long mlen
+) {
+    unsigned char slen[8U];
+
+    crypto_onetimeauth_poly1305_update(state, pad0, (0x10 - mlen) & 0xf);
+    store64_le(slen, (uint64_t) adlen);
+    crypto_onetimeauth_poly1305_update(state, slen, sizeof slen);
+    store64_le(slen, (uint64_t) mlen);
+    crypto_onetimeauth_poly1305_update(state, slen, sizeof slen);
+    crypto_onetimeauth_poly1305_final(state, mac);
+    sodium_memzero(state, sizeof *state);
+}
+
+void crypto_aead_xchacha20poly1305_ietf_encrypt_fragments(
+  unsigned char* c,
+  const Fragment* m, size_t m_count,
+  const unsigned char* ad, unsigned long long adlen,
+  const unsigned char* npub, const unsigned char* k
+) {
+    crypto_onetimeauth_poly1305_state state;
+    size_t                            position = 0;
+
+    aead_poly1305_init(&state, ad, adlen, npub, k);
+    for (size_t i = 0; i < m_count; i++) {
+        stream_xor_at(
+          crypto_stream_xchacha20_xor_ic, c + position, m[i].data, m[i].length,
+          aead_message_start + position, npub, k
+        );
+        crypto_onetimeauth_poly1305_update(&state, c + position, m[i].length);
+        position += m[i].length;
+    }
+    aead_poly1305_final(&state, c + position, adlen, position);
+}
+
+int crypto_aead_xchacha20poly1305_ietf_decrypt_fragments(
+  const OutputFragment* m, size_t m_count,
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* ad, unsigned long long adlen,
+  const unsigned char* npub, const unsigned char* k
+) {
+    crypto_onetimeauth_poly1305_state state;
+    unsigned char                     mac[crypto_aead_xchacha20poly1305_ietf_ABYTES];
+    unsigned char                     computed_mac[crypto_aead_xchacha20poly1305_ietf_ABYTES];
+    int                               ret;
+
+    if (clen < crypto_aead_xchacha20poly1305_ietf_ABYTES) {
+        return -1;
+    }
+    const unsigned long long mlen = clen - crypto_aead_xchacha20poly1305_ietf_ABYTES;
+    Fragments::gather(mac, c, c_count, offset + (size_t) mlen, sizeof mac);
+    aead_poly1305_init(&state, ad, adlen, npub, k);
+    Fragments::forEachPiece(c, c_count, offset, (size_t) mlen,
+      [&state](const unsigned char* data, const size_t length, const size_t) {
+        crypto_onetimeauth_poly1305_update(&state, data, length);
+      }
+    );
+    aead_poly1305_final(&state, computed_mac, adlen, mlen);
+    ret = crypto_verify_16(computed_mac, mac);
+    if (ret != 0) {
+        return -1;
+    }
+    stream_xor_fragments_at(
+      crypto_stream_xchacha20_xor_ic, m, m_count,
+      c, c_count, offset, (size_t) mlen,
+      aead_message_start, npub, k
+    );
+    return 0;
+}
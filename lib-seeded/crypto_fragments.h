@@ -0,0 +1,73 @@
+/************************************
+ * Versions of libsodium's secret box and XChaCha20-Poly1305 AEAD that
+ * read their input from a list of fragments rather than one contiguous
+ * buffer, producing exactly the same output as the contiguous functions
+ * without first copying the fragments together. The functions that
+ * decrypt also write their output across a list of fragments, so a
+ * plaintext can be scattered into the caller's buffers.
+ *
+ * Where a function reads a box from fragments, the box occupies bytes
+ * [offset, offset + clen) of the concatenated fragments, so callers can
+ * skip a nonce or public key that precedes it.
+ */
+
+#pragma once
+
+#include "fragments.hpp"
+
+/**
+ * Seal the concatenated fragments m into c, which receives
+ * crypto_secretbox_MACBYTES plus the fragments' total length bytes,
+ * as crypto_secretbox_easy would.
+ */
+void crypto_secretbox_easy_fragments(
+  unsigned char* c,
+  const Fragment* m, size_t m_count,
+  const unsigned char* n, const unsigned char* k
+);
+
+/**
+ * Verify a box created by crypto_secretbox_easy without decrypting it.
+ * Returns 0 if the box is authentic and -1 otherwise.
+ */
+int crypto_secretbox_easy_verify_fragments(
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+);
+
+/**
+ * Decrypt a box that crypto_secretbox_easy_verify_fragments has already
+ * verified, writing clen - crypto_secretbox_MACBYTES bytes across the
+ * fragments m, which must be at least that long in total.
+ */
+void crypto_secretbox_easy_open_verified_fragments(
+  const OutputFragment* m, size_t m_count,
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+);
+
+/**
+ * Encrypt the concatenated fragments m into c, which receives their total
+ * length plus crypto_aead_xchacha20poly1305_ietf_ABYTES bytes, as
+ * crypto_aead_xchacha20poly1305_ietf_encrypt would.
+ */
+void crypto_aead_xchacha20poly1305_ietf_encrypt_fragments(
+  unsigned char* c,
+  const Fragment* m, size_t m_count,
+  const unsigned char* ad, unsigned long long adlen,
+  const unsigned char* npub, const unsigned char* k
+);
+
+/**
+ * Verify and then decrypt a ciphertext created by
+ * crypto_aead_xchacha20poly1305_ietf_encrypt, writing
+ * clen - crypto_aead_xchacha20poly1305_ietf_ABYTES bytes across the
+ * fragments m, which must be at least that long in total.
+ * Returns 0 on success, and -1 (writing nothing) if it isn't authentic.
+ */
+int crypto_aead_xchacha20poly1305_ietf_decrypt_fragments(
+  const OutputFragment* m, size_t m_count,
+  const Fragment* c, size_t c_count, size_t offset, unsigned long long clen,
+  const unsigned char* ad, unsigned long long adlen,
+  const unsigned char* npub, const unsigned char* k
+);
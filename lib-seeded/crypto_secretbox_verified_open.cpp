@@ -0,0 +1,52 @@
+/************************************
+ * Mirrors crypto_secretbox_xsalsa20poly1305_open_detached in libsodium:
+ * the first 32 bytes of the XSalsa20 keystream are the Poly1305 key,
+ * and the rest of the keystream encrypts the message.
+ */
+#include <string.h>
+#include "sodium.h"
+#include "crypto_secretbox_verified_open.h"
+
+int crypto_secretbox_easy_verify(
+  const unsigned char *c, unsigned long long clen,
+  const unsigned char *n, const unsigned char *k
+) {
+    unsigned char poly1305_key[crypto_onetimeauth_poly1305_KEYBYTES];
+    int           ret;
+
+    if (clen < crypto_secretbox_MACBYTES) {
+        return -1;
+    }
+    crypto_stream_xsalsa20(poly1305_key, sizeof poly1305_key, n, k);
+    ret = crypto_onetimeauth_poly1305_verify(
+      c, c + crypto_secretbox_MACBYTES, clen - crypto_secretbox_MACBYTES, poly1305_key
+    );
+    sodium_memzero(poly1305_key, sizeof poly1305_key);
+
+    return ret;
+}
+
+void crypto_secretbox_easy_open_verified(
+  unsigned char *m, const unsigned char *c, unsigned long long clen,
+  const unsigned char *n, const unsigned char *k
+) {
+    // The first block of keystream is shared between the Poly1305 key
+    // (which we discard) and the first 32 bytes of the message.
+    unsigned char             block0[64U];
+    const unsigned char*      secret = c + crypto_secretbox_MACBYTES;
+    const unsigned long long  mlen = clen - crypto_secretbox_MACBYTES;
+    const unsigned long long  mlen0 =
+      mlen > sizeof block0 - crypto_onetimeauth_poly1305_KEYBYTES ?
+        sizeof block0 - crypto_onetimeauth_poly1305_KEYBYTES : mlen;
+
+    memset(block0, 0U, crypto_onetimeauth_poly1305_KEYBYTES);
+    memcpy(block0 + crypto_onetimeauth_poly1305_KEYBYTES, secret, mlen0);
+    crypto_stream_xsalsa20_xor(
+      block0, block0, crypto_onetimeauth_poly1305_KEYBYTES + mlen0, n, k
+    );
+    memcpy(m, block0 + crypto_onetimeauth_poly1305_KEYBYTES, mlen0);
+    if (mlen > mlen0) {
+        crypto_stream_xsalsa20_xor_ic(m + mlen0, secret + mlen0, mlen - mlen0, n, 1U, k);
+    }
+    sodium_memzero(block0, sizeof block0);
+}
@@ -0,0 +1,27 @@
+/************************************
+ * Split libsodium's crypto_secretbox_open_easy into its two halves,
+ * verification and decryption, so that callers can verify a secret box
+ * before allocating memory for its plaintext.
+ */
+
+#pragma once
+
+/**
+ * Verify the authentication tag of a box created by crypto_secretbox_easy
+ * (or crypto_box_easy_afternm) without decrypting it.
+ * Returns 0 if the box is authentic and -1 otherwise.
+ */
+int crypto_secretbox_easy_verify(
+  const unsigned char* c, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+);
+
+/**
+ * Decrypt a box that crypto_secretbox_easy_verify has already verified,
+ * writing clen - crypto_secretbox_MACBYTES bytes to m.
+ * Produces the same plaintext as crypto_secretbox_open_easy.
+ */
+void crypto_secretbox_easy_open_verified(
+  unsigned char* m, const unsigned char* c, unsigned long long clen,
+  const unsigned char* n, const unsigned char* k
+);
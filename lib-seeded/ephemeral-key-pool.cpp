@@ -0,0 +1,97 @@
+#include <cstring>
+#include <system_error>
+#include <sodium.h>
+#include "ephemeral-key-pool.hpp"
+
+// Each slot holds a public key followed by its secret key
+static const size_t keypairBytes = crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES;
+
+EphemeralKeyPool::EphemeralKeyPool(
+  const size_t capacity,
+  const bool refillInBackground
+) :
+  slotCount(capacity),
+  keypairs(capacity * keypairBytes),
+  slotStates(new std::atomic<unsigned char>[capacity]),
+  fullSlots(0),
+  nextSlot(0),
+  stopping(false)
+{
+  for (size_t slot = 0; slot < slotCount; slot++) {
+    slotStates[slot].store(Empty);
+  }
+  refill();
+#ifndef EMSCRIPTEN
+  if (refillInBackground && slotCount > 0) {
+    try {
+      refiller = std::thread(&EphemeralKeyPool::refillInBackground, this);
+    } catch (const std::system_error&) {
+      // Proceed without a background thread, generating on demand when dry
+    }
+  }
+#endif
+}
+
+EphemeralKeyPool::~EphemeralKeyPool() {
+  {
+    std::lock_guard<std::mutex> lock(refillMutex);
+    stopping = true;
+  }
+  refillNeeded.notify_one();
+#ifndef EMSCRIPTEN
+  if (refiller.joinable()) {
+    refiller.join();
+  }
+#endif
+  // The keypairs' SodiumBuffer wipes them as it is freed
+}
+
+void EphemeralKeyPool::refill() {
+  for (size_t slot = 0; slot < slotCount; slot++) {
+    unsigned char expected = Empty;
+    if (!slotStates[slot].compare_exchange_strong(expected, Filling, std::memory_order_acquire)) {
+      continue;
+    }
+    unsigned char* keypair = keypairs.data + slot * keypairBytes;
+    crypto_box_keypair(keypair, keypair + crypto_box_PUBLICKEYBYTES);
+    slotStates[slot].store(Full, std::memory_order_release);
+    fullSlots.fetch_add(1);
+  }
+}
+
+void EphemeralKeyPool::refillInBackground() {
+  std::unique_lock<std::mutex> lock(refillMutex);
+  while (!stopping) {
+    lock.unlock();
+    refill();
+    lock.lock();
+    refillNeeded.wait(lock, [this]() {
+      return stopping || fullSlots.load() <= lowWaterMark();
+    });
+  }
+}
+
+void EphemeralKeyPool::take(unsigned char* publicKey, unsigned char* secretKey) {
+  const size_t start = slotCount > 0 ? nextSlot.fetch_add(1) % slotCount : 0;
+  for (size_t i = 0; i < slotCount; i++) {
+    const size_t slot = (start + i) % slotCount;
+    unsigned char expected = Full;
+    if (!slotStates[slot].compare_exchange_strong(expected, Taking, std::memory_order_acquire)) {
+      continue;
+    }
+    unsigned char* keypair = keypairs.data + slot * keypairBytes;
+    memcpy(publicKey, keypair, crypto_box_PUBLICKEYBYTES);
+    memcpy(secretKey, keypair + crypto_box_PUBLICKEYBYTES, crypto_box_SECRETKEYBYTES);
+    sodium_memzero(keypair, keypairBytes);
+    slotStates[slot].store(Empty, std::memory_order_release);
+    if (fullSlots.fetch_sub(1) == lowWaterMark() + 1) {
+      // This take crossed the low-water mark. Notifying under the lock
+      // guarantees the refiller either sees the new count or is woken.
+      std::lock_guard<std::mutex> lock(refillMutex);
+      refillNeeded.notify_one();
+    }
+    return;
+  }
+  // The pool is dry
+  crypto_box_keypair(publicKey, secretKey);
+}
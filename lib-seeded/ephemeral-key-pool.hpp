@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#ifndef EMSCRIPTEN
+  #include <thread>
+#endif
+#include "sodium-buffer.hpp"
+
+/**
+ * @brief A pool of pre-generated ephemeral X25519 keypairs, so that
+ * SealingKey seals don't have to generate one (a random draw plus a
+ * scalar base multiplication) on the caller's thread.
+ *
+ * The keypairs are held in locked memory (a SodiumBuffer). Each is handed
+ * out exactly once and its slot is wiped as it is taken. Taking a keypair
+ * never blocks: slots are claimed with atomic compare-and-swap, and if the
+ * pool has run dry, take generates a keypair on the calling thread instead.
+ *
+ * By default, a background thread refills the pool whenever it falls to
+ * half its capacity. Without it (or under Emscripten, which has no
+ * threads), the pool is filled when constructed and whenever refill is
+ * called.
+ *
+ * Ephemeral keypairs aren't tied to any recipient, so one pool can be
+ * shared by any number of SealingKeys (see SealingKey::setEphemeralKeyPool).
+ *
+ * @ingroup BuildingBlocks
+ */
+class EphemeralKeyPool {
+  enum SlotState : unsigned char { Empty, Filling, Full, Taking };
+
+  const size_t slotCount;
+  SodiumBuffer keypairs;
+  std::unique_ptr<std::atomic<unsigned char>[]> slotStates;
+  std::atomic<size_t> fullSlots;
+  // Where take starts looking, so concurrent takes don't all contend
+  // for the same slot
+  std::atomic<size_t> nextSlot;
+
+  std::mutex refillMutex;
+  std::condition_variable refillNeeded;
+  bool stopping;
+#ifndef EMSCRIPTEN
+  std::thread refiller;
+#endif
+
+  EphemeralKeyPool(const EphemeralKeyPool&) = delete;
+  EphemeralKeyPool& operator=(const EphemeralKeyPool&) = delete;
+
+  size_t lowWaterMark() const { return slotCount / 2; }
+  void refillInBackground();
+
+public:
+  /**
+   * @brief Create a pool and fill it
+   *
+   * @param capacity The number of keypairs the pool holds
+   * @param refillInBackground Whether to start a thread that refills the
+   * pool when it runs low (ignored under Emscripten)
+   */
+  explicit EphemeralKeyPool(const size_t capacity = 64, const bool refillInBackground = true);
+
+  /**
+   * @brief Stop the refilling thread, if any, and wipe the remaining keypairs
+   */
+  ~EphemeralKeyPool();
+
+  /**
+   * @brief Take a keypair from the pool, wiping its slot, or generate
+   * one if the pool is empty. The caller must wipe the secret key once
+   * it's done with it.
+   *
+   * Safe to call from any number of threads at once.
+   *
+   * @param publicKey Receives crypto_box_PUBLICKEYBYTES bytes
+   * @param secretKey Receives crypto_box_SECRETKEYBYTES bytes
+   */
+  void take(unsigned char* publicKey, unsigned char* secretKey);
+
+  /**
+   * @brief Generate keypairs for every empty slot on the calling thread
+   */
+  void refill();
+
+  /**
+   * @brief The number of keypairs ready to be taken
+   */
+  size_t available() const { return fullSlots.load(); }
+
+  /**
+   * @brief The number of keypairs the pool holds when full
+   */
+  size_t capacity() const { return slotCount; }
+};
@@ -85,4 +85,21 @@ class InvalidRecipeValueException: public std::invalid_argument
 		std::invalid_argument(m ? m : "Invalid key recipe") {};
 };
 
+/**
+ * @brief Thrown when a key's algorithm is not supported by the
+ * hardware the library is running on (e.g., AES256GCM on a CPU
+ * without AES instructions).
+ */
+class AlgorithmUnavailableException: public std::runtime_error
+{
+	public:
+	/**
+	 * @brief Construct by throwing, passing an optional exception message
+	 * 
+	 * @param m The exception message
+	 */
+	AlgorithmUnavailableException(const char* m = NULL) :
+		std::runtime_error(m ? m : "Algorithm unavailable on this hardware") {};
+};
+
 /** @} */ // end of Exceptions group
\ No newline at end of file
@@ -25,6 +25,7 @@ namespace RecipeJson {
 		const std::string type = "type";
 		const std::string excludeOrientationOfFaces = "excludeOrientationOfFaces";
 		const std::string wordList = "wordList";
+		const std::string nonceType = "nonceType";
 
 	}
 
@@ -50,13 +51,17 @@ namespace RecipeJson {
 		_INVALID_ALGORITHM_ = 0,
 		XSalsa20Poly1305,
 		X25519,
-		Ed25519
+		Ed25519,
+		AES256GCM,
+		XChaCha20Poly1305
 	};
 	NLOHMANN_JSON_SERIALIZE_ENUM( Algorithm, {
 		{Algorithm::_INVALID_ALGORITHM_, nullptr},
 		{Algorithm::XSalsa20Poly1305, "XSalsa20Poly1305"},
 		{Algorithm::X25519, "X25519"},
-		{Algorithm::Ed25519, "Ed25519"}
+		{Algorithm::Ed25519, "Ed25519"},
+		{Algorithm::AES256GCM, "AES256GCM"},
+		{Algorithm::XChaCha20Poly1305, "XChaCha20Poly1305"}
 	})
 
 
@@ -73,6 +78,19 @@ namespace RecipeJson {
 	
 
 
+	enum NonceType {
+		_INVALID_NONCE_TYPE_ = 0,
+		Synthetic,
+		Random
+	};
+	NLOHMANN_JSON_SERIALIZE_ENUM( NonceType, {
+		{NonceType::_INVALID_NONCE_TYPE_, nullptr},
+		{NonceType::Synthetic, "Synthetic"},
+		{NonceType::Random, "Random"}
+	})
+	
+
+
 	enum HashFunction {
 		_INVALID_HASHFUNCTION_ = 0,
 		BLAKE2b,
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief One of the non-contiguous pieces of a message or ciphertext
+ * (like a POSIX iovec), passed as an array to the seal and unseal
+ * methods that accept fragments.
+ *
+ * The message or ciphertext is the concatenation of its fragments,
+ * in order. Nothing is copied, so the fragments must remain valid
+ * until the call returns.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct Fragment {
+  /**
+   * @brief The fragment's bytes
+   */
+  const unsigned char* data;
+  /**
+   * @brief The number of bytes in the fragment
+   */
+  size_t length;
+};
+
+/**
+ * @brief One of the non-contiguous buffers a plaintext is written into
+ * (like a POSIX iovec), passed as an array to the unseal methods that
+ * scatter their output.
+ *
+ * The plaintext is written across the buffers in order, filling each
+ * before moving to the next. Any bytes beyond the end of the plaintext
+ * are left untouched.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct OutputFragment {
+  /**
+   * @brief The buffer to write into
+   */
+  unsigned char* data;
+  /**
+   * @brief The number of bytes the buffer can hold
+   */
+  size_t length;
+};
+
+namespace Fragments {
+  /**
+   * @brief The total length of a list of fragments
+   */
+  template <typename FragmentType>
+  size_t totalLength(const FragmentType* fragments, const size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+      length += fragments[i].length;
+    }
+    return length;
+  }
+
+  /**
+   * @brief Call `visit(data, length, position)` for each contiguous piece
+   * of bytes [offset, offset + length) of the concatenated fragments, where
+   * position is the piece's offset from the start of that range.
+   * The range must lie within the fragments.
+   */
+  template <typename FragmentType, typename Visit>
+  void forEachPiece(
+    const FragmentType* fragments,
+    const size_t count,
+    size_t offset,
+    const size_t length,
+    const Visit& visit
+  ) {
+    size_t position = 0;
+    for (size_t i = 0; i < count && position < length; i++) {
+      if (offset >= fragments[i].length) {
+        offset -= fragments[i].length;
+        continue;
+      }
+      const size_t pieceLength = std::min(fragments[i].length - offset, length - position);
+      visit(fragments[i].data + offset, pieceLength, position);
+      position += pieceLength;
+      offset = 0;
+    }
+  }
+
+  /**
+   * @brief Copy bytes [offset, offset + length) of the concatenated
+   * fragments into out, for the small fixed-length fields (nonces,
+   * public keys, and tags) that may straddle fragments.
+   */
+  inline void gather(
+    unsigned char* out,
+    const Fragment* fragments,
+    const size_t count,
+    const size_t offset,
+    const size_t length
+  ) {
+    forEachPiece(fragments, count, offset, length,
+      [out](const unsigned char* data, const size_t pieceLength, const size_t position) {
+        memcpy(out + position, data, pieceLength);
+      }
+    );
+  }
+
+  /**
+   * @brief Copy length bytes from in into bytes [offset, offset + length)
+   * of the concatenated output fragments.
+   */
+  inline void scatter(
+    const OutputFragment* fragments,
+    const size_t count,
+    const size_t offset,
+    const unsigned char* in,
+    const size_t length
+  ) {
+    forEachPiece(fragments, count, offset, length,
+      [in](unsigned char* data, const size_t pieceLength, const size_t position) {
+        memcpy(data, in + position, pieceLength);
+      }
+    );
+  }
+}
@@ -4,6 +4,16 @@
 #include "hkdf.hpp"
 // https://tools.ietf.org/html/rfc5869, with Blake2 in 32 byte block mode
 SodiumBuffer hkdfBlake2b(const unsigned char* keyPtr, size_t keyLength, SodiumBuffer info, size_t outputSize) {
+  return hkdfBlake2b(keyPtr, keyLength, info.data, info.length, outputSize);
+}
+
+// The info (preimage) is public, so callers can pass it from any buffer
+// rather than copying it into a SodiumBuffer first.
+SodiumBuffer hkdfBlake2b(
+  const unsigned char* keyPtr, size_t keyLength,
+  const unsigned char* infoPtr, size_t infoLength,
+  size_t outputSize
+) {
   static const size_t blockSize = 32;
 
   // Section 2.2
@@ -45,7 +55,7 @@ SodiumBuffer hkdfBlake2b(const unsigned char* keyPtr, size_t keyLength, SodiumBu
     // | info
     crypto_generichash_blake2b_update(
       static_cast<crypto_generichash_blake2b_state*>((void*)blakeHashState.data),
-      info.data, info.length
+      infoPtr, infoLength
     );
     // | (i % 256)
     crypto_generichash_blake2b_update(
@@ -3,3 +3,9 @@
 #include "sodium-buffer.hpp"
 
 SodiumBuffer hkdfBlake2b(const unsigned char* keyPtr, size_t keyLength, SodiumBuffer info, size_t outputSize);
+
+SodiumBuffer hkdfBlake2b(
+  const unsigned char* keyPtr, size_t keyLength,
+  const unsigned char* infoPtr, size_t infoLength,
+  size_t outputSize
+);
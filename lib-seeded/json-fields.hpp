@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include "github-com-nlohmann-json/json.hpp"
+#include "result.hpp"
+
+/**
+ * Non-throwing counterparts of the nlohmann::json accessors used by the
+ * fromJson methods, for use by their tryFromJson counterparts.
+ * Each fails in exactly the cases where the accessor it mirrors would throw.
+ */
+namespace JsonFields {
+
+  /**
+   * @brief The error reported in place of any nlohmann::json exception
+   */
+  const SeededError parsingError = {
+    SeededErrorCode::JsonParsing, "Exception in parsing JSON"
+  };
+
+  /**
+   * @brief Parse without throwing, returning false unless the JSON
+   * is an object.
+   */
+  inline bool parseObject(const std::string& json, nlohmann::json& jsonObject) {
+    jsonObject = nlohmann::json::parse(json, nullptr, false);
+    return jsonObject.is_object();
+  }
+
+  /**
+   * @brief Mirrors `std::string(jsonObject.at(fieldName))`, returning
+   * NULL if the field is missing or is not a string.
+   */
+  inline const std::string* requiredString(
+    const nlohmann::json& jsonObject,
+    const std::string& fieldName
+  ) {
+    const auto field = jsonObject.find(fieldName);
+    if (field == jsonObject.end()) {
+      return NULL;
+    }
+    return field->get_ptr<const std::string*>();
+  }
+
+  /**
+   * @brief Mirrors `jsonObject.value<std::string>(fieldName, "")`, returning
+   * NULL if the field is present but is not a string.
+   */
+  inline const std::string* optionalString(
+    const nlohmann::json& jsonObject,
+    const std::string& fieldName
+  ) {
+    static const std::string empty;
+    const auto field = jsonObject.find(fieldName);
+    if (field == jsonObject.end()) {
+      return &empty;
+    }
+    return field->get_ptr<const std::string*>();
+  }
+}
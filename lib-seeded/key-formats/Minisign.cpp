@@ -0,0 +1,140 @@
+#include "Minisign.hpp"
+#include "PEM.hpp"
+#include "../signing-key-stream.hpp"
+#include "../mapped-file.hpp"
+#include <ctime>
+#include <sodium.h>
+
+static const std::string untrustedCommentPrefix = "untrusted comment: ";
+static const std::string trustedCommentPrefix = "trusted comment: ";
+static const char prehashedAlgorithm[] = "ED";
+static const char legacyAlgorithm[] = "Ed";
+static const size_t keyIdBytes = 8;
+static const size_t algorithmBytes = 2;
+
+// The BLAKE2b-512 hash of a file, which minisign's prehashed algorithm signs
+static const std::vector<unsigned char> hashFile(const std::string &path) {
+    crypto_generichash_state st;
+    crypto_generichash_init(&st, NULL, 0, crypto_generichash_BYTES_MAX);
+    SigningKeyStream::readFileInChunks(path, [&st](const unsigned char *chunk, const size_t length) {
+        crypto_generichash_update(&st, chunk, length);
+    });
+    std::vector<unsigned char> hash(crypto_generichash_BYTES_MAX);
+    crypto_generichash_final(&st, hash.data(), hash.size());
+    return hash;
+}
+
+static bool base64Decode(const std::string &base64, std::vector<unsigned char> &data, const size_t expectedLength) {
+    data.resize(expectedLength);
+    size_t length;
+    return sodium_base642bin(
+            data.data(), data.size(), base64.data(), base64.size(), NULL, &length, NULL,
+            sodium_base64_VARIANT_ORIGINAL
+    ) == 0 && length == expectedLength;
+}
+
+static const std::vector<std::string> splitLines(const std::string &text) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string line = text.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+        start = end + 1;
+    }
+    return lines;
+}
+
+const std::vector<unsigned char> getMinisignKeyId(const SignatureVerificationKey &publicKey) {
+    std::vector<unsigned char> hash(crypto_generichash_BYTES_MIN);
+    crypto_generichash(
+            hash.data(), hash.size(),
+            publicKey.signatureVerificationKeyBytes.data(), publicKey.signatureVerificationKeyBytes.size(),
+            NULL, 0
+    );
+    return std::vector<unsigned char>(hash.begin(), hash.begin() + keyIdBytes);
+}
+
+const std::string getMinisignPublicKey(const SignatureVerificationKey &publicKey) {
+    const std::vector<unsigned char> keyId = getMinisignKeyId(publicKey);
+    std::vector<unsigned char> data(legacyAlgorithm, legacyAlgorithm + algorithmBytes);
+    data.insert(data.end(), keyId.begin(), keyId.end());
+    data.insert(data.end(), publicKey.signatureVerificationKeyBytes.begin(), publicKey.signatureVerificationKeyBytes.end());
+    // minisign displays the key ID as a little-endian 64-bit number
+    const std::string keyIdAsNumber = toUpper(toHexStr(std::vector<unsigned char>(keyId.rbegin(), keyId.rend())));
+    return untrustedCommentPrefix + "minisign public key " + keyIdAsNumber + "\n" + base64Encode(data) + "\n";
+}
+
+const std::string getMinisignSignatureForFile(
+        const SigningKey &signingKey,
+        const std::string &path,
+        const std::string &_trustedComment
+) {
+    const std::string fileName = path.substr(path.find_last_of("/\\") + 1);
+    const std::string trustedComment = _trustedComment.empty()
+            ? "timestamp:" + std::to_string((long long) time(NULL)) + "\tfile:" + fileName + "\thashed"
+            : _trustedComment;
+    const std::vector<unsigned char> signature = signingKey.generateSignature(hashFile(path));
+
+    std::vector<unsigned char> signatureWithTrustedComment(signature);
+    signatureWithTrustedComment.insert(signatureWithTrustedComment.end(), trustedComment.begin(), trustedComment.end());
+    const std::vector<unsigned char> globalSignature = signingKey.generateSignature(signatureWithTrustedComment);
+
+    const std::vector<unsigned char> keyId = getMinisignKeyId(signingKey.getSignatureVerificationKey());
+    std::vector<unsigned char> data(prehashedAlgorithm, prehashedAlgorithm + algorithmBytes);
+    data.insert(data.end(), keyId.begin(), keyId.end());
+    data.insert(data.end(), signature.begin(), signature.end());
+    return untrustedCommentPrefix + "signature from lib-seeded secret key\n" +
+            base64Encode(data) + "\n" +
+            trustedCommentPrefix + trustedComment + "\n" +
+            base64Encode(globalSignature) + "\n";
+}
+
+bool verifyMinisignSignatureForFile(
+        const SignatureVerificationKey &publicKey,
+        const std::string &path,
+        const std::string &minisignSignature
+) {
+    const std::vector<std::string> lines = splitLines(minisignSignature);
+    if (lines.size() < 4 ||
+        lines[0].compare(0, untrustedCommentPrefix.size(), untrustedCommentPrefix) != 0 ||
+        lines[2].compare(0, trustedCommentPrefix.size(), trustedCommentPrefix) != 0) {
+        return false;
+    }
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> globalSignature;
+    if (!base64Decode(lines[1], data, algorithmBytes + keyIdBytes + crypto_sign_BYTES) ||
+        !base64Decode(lines[3], globalSignature, crypto_sign_BYTES)) {
+        return false;
+    }
+    const std::string algorithm(data.begin(), data.begin() + algorithmBytes);
+    const std::vector<unsigned char> keyId(data.begin() + algorithmBytes, data.begin() + algorithmBytes + keyIdBytes);
+    const std::vector<unsigned char> signature(data.begin() + algorithmBytes + keyIdBytes, data.end());
+    if (keyId != getMinisignKeyId(publicKey)) {
+        return false;
+    }
+
+    bool fileVerified;
+    if (algorithm == prehashedAlgorithm) {
+        fileVerified = publicKey.verify(hashFile(path), signature);
+    } else if (algorithm == legacyAlgorithm) {
+        // Legacy signatures sign the whole file, which must be mapped to verify
+        const MappedFile file(path);
+        fileVerified = SignatureVerificationKey::verify(
+                publicKey.signatureVerificationKeyBytes, file.data(), file.length(), signature
+        );
+    } else {
+        return false;
+    }
+
+    const std::string trustedComment = lines[2].substr(trustedCommentPrefix.size());
+    std::vector<unsigned char> signatureWithTrustedComment(signature);
+    signatureWithTrustedComment.insert(signatureWithTrustedComment.end(), trustedComment.begin(), trustedComment.end());
+    return fileVerified && publicKey.verify(signatureWithTrustedComment, globalSignature);
+}
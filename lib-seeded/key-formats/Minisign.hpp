@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../signing-key.hpp"
+
+/**
+ * Signatures and public keys in the formats used by minisign
+ * (https://jedisct1.github.io/minisign/), so that files signed with a
+ * SigningKey can be verified with minisign and vice versa.
+ *
+ * Signatures use minisign's prehashed ("ED") algorithm: Ed25519 over a
+ * BLAKE2b-512 hash of the file, which is computed reading the file in
+ * chunks. The key ID minisign stores with keys and signatures is derived
+ * from the public key.
+ */
+
+/**
+ * The 8-byte minisign key ID of a public key
+ */
+const std::vector<unsigned char> getMinisignKeyId(const SignatureVerificationKey &publicKey);
+
+/**
+ * A public key in the format of a minisign.pub file
+ */
+const std::string getMinisignPublicKey(const SignatureVerificationKey &publicKey);
+
+/**
+ * A signature of a file in the format of a .minisig file
+ *
+ * @param trustedComment The signed comment to include, or an empty string
+ * for minisign's default ("timestamp:<time>\tfile:<name>\thashed")
+ */
+const std::string getMinisignSignatureForFile(
+        const SigningKey &signingKey,
+        const std::string &path,
+        const std::string &trustedComment = ""
+);
+
+/**
+ * Verify a file's signature given in the format of a .minisig file,
+ * including the signature of its trusted comment. Accepts both
+ * prehashed ("ED") and legacy ("Ed") signatures.
+ *
+ * @return false if either signature is invalid, the signature was made
+ * with a key with a different key ID, or it isn't in minisign's format.
+ */
+bool verifyMinisignSignatureForFile(
+        const SignatureVerificationKey &publicKey,
+        const std::string &path,
+        const std::string &minisignSignature
+);
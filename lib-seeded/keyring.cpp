@@ -0,0 +1,90 @@
+#include <algorithm>
+#include "keyring.hpp"
+
+namespace KeyringErrors {
+  static const SeededError noKeyUnseals = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Keyring unseal failed: no key in the keyring can unseal the message with its unsealing instructions, or the ciphertext was modified/corrupted."
+  };
+}
+
+static std::string indexOf(const std::vector<unsigned char>& keyId) {
+  return std::string(keyId.begin(), keyId.end());
+}
+
+void Keyring::add(const SymmetricKey& key) {
+  symmetricKeysById.emplace(indexOf(key.keyId()), symmetricKeys.size());
+  symmetricKeys.push_back(key);
+}
+
+void Keyring::add(const UnsealingKey& key) {
+  unsealingKeysById.emplace(indexOf(key.keyId()), unsealingKeys.size());
+  unsealingKeys.push_back(key);
+}
+
+// The positions of the keys with an ID, in the order they were added
+static std::vector<size_t> positionsWithId(
+  const std::unordered_multimap<std::string, size_t>& keysById,
+  const std::vector<unsigned char>& keyId
+) {
+  std::vector<size_t> positions;
+  if (keyId.size() > 0) {
+    const auto range = keysById.equal_range(indexOf(keyId));
+    for (auto entry = range.first; entry != range.second; entry++) {
+      positions.push_back(entry->second);
+    }
+    std::sort(positions.begin(), positions.end());
+  }
+  return positions;
+}
+
+const SymmetricKey* Keyring::findSymmetricKey(const std::vector<unsigned char>& keyId) const {
+  const std::vector<size_t> positions = positionsWithId(symmetricKeysById, keyId);
+  return positions.empty() ? NULL : &symmetricKeys[positions.front()];
+}
+
+const UnsealingKey* Keyring::findUnsealingKey(const std::vector<unsigned char>& keyId) const {
+  const std::vector<size_t> positions = positionsWithId(unsealingKeysById, keyId);
+  return positions.empty() ? NULL : &unsealingKeys[positions.front()];
+}
+
+// Try the keys with the message's ID or, as trial decryption, every other key
+template <typename Key>
+static Result<SodiumBuffer> tryKeys(
+  const std::deque<Key>& keys,
+  const std::unordered_multimap<std::string, size_t>& keysById,
+  const PackagedSealedMessage& message,
+  const bool identifiedKeys
+) {
+  const std::vector<size_t> identified = positionsWithId(keysById, message.keyId);
+  const size_t count = identifiedKeys ? identified.size() : keys.size();
+  for (size_t i = 0; i < count; i++) {
+    const size_t position = identifiedKeys ? identified[i] : i;
+    if (!identifiedKeys && std::binary_search(identified.begin(), identified.end(), position)) {
+      continue;
+    }
+    Result<SodiumBuffer> plaintext = keys[position].tryUnseal(message.ciphertext, message.unsealingInstructions);
+    if (plaintext.ok()) {
+      return plaintext;
+    }
+  }
+  return KeyringErrors::noKeyUnseals;
+}
+
+Result<SodiumBuffer> Keyring::tryUnseal(const PackagedSealedMessage& message) const {
+  for (const bool identifiedKeys : {true, false}) {
+    Result<SodiumBuffer> symmetricPlaintext = tryKeys(symmetricKeys, symmetricKeysById, message, identifiedKeys);
+    if (symmetricPlaintext.ok()) {
+      return symmetricPlaintext;
+    }
+    Result<SodiumBuffer> unsealingPlaintext = tryKeys(unsealingKeys, unsealingKeysById, message, identifiedKeys);
+    if (unsealingPlaintext.ok()) {
+      return unsealingPlaintext;
+    }
+  }
+  return KeyringErrors::noKeyUnseals;
+}
+
+const SodiumBuffer Keyring::unseal(const PackagedSealedMessage& message) const {
+  return tryUnseal(message).valueOrThrow();
+}
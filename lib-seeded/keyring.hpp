@@ -0,0 +1,92 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sodium-buffer.hpp"
+#include "packaged-sealed-message.hpp"
+#include "symmetric-key.hpp"
+#include "unsealing-key.hpp"
+#include "result.hpp"
+
+/**
+ * @brief An in-memory collection of SymmetricKeys and UnsealingKeys,
+ * indexed by their key IDs, that can unseal any PackagedSealedMessage
+ * sealed for one of them.
+ *
+ * A message sealed with a key ID (SymmetricKey::sealWithKeyId or
+ * SealingKey::sealWithKeyId) is tried only against the keys with that
+ * ID, found with one hash-table lookup. A message without one, or whose
+ * ID matches none of the keys, is tried against every key (trial
+ * decryption), which costs a MAC check per SymmetricKey and a scalar
+ * multiplication per UnsealingKey.
+ *
+ * The keyring copies the keys added to it. Adding keys while other threads
+ * use the keyring is not safe; unsealing from many threads at once is.
+ *
+ * @ingroup BuildingBlocks
+ */
+class Keyring {
+  // Deques, so that the keys never move as more are added
+  std::deque<SymmetricKey> symmetricKeys;
+  std::deque<UnsealingKey> unsealingKeys;
+  // Key IDs to the positions of the keys with that ID
+  std::unordered_multimap<std::string, size_t> symmetricKeysById;
+  std::unordered_multimap<std::string, size_t> unsealingKeysById;
+
+public:
+  /**
+   * @brief Add a copy of a SymmetricKey, indexed by its keyId
+   */
+  void add(const SymmetricKey& key);
+
+  /**
+   * @brief Add a copy of an UnsealingKey, indexed by its keyId
+   */
+  void add(const UnsealingKey& key);
+
+  /**
+   * @brief The number of keys in the keyring
+   */
+  size_t size() const { return symmetricKeys.size() + unsealingKeys.size(); }
+
+  /**
+   * @brief Find a SymmetricKey by its keyId
+   *
+   * @return const SymmetricKey* The key (the first added, if several share
+   * the ID), or NULL if there is none. It remains valid for the life of
+   * the keyring.
+   */
+  const SymmetricKey* findSymmetricKey(const std::vector<unsigned char>& keyId) const;
+
+  /**
+   * @brief Find an UnsealingKey by its keyId
+   *
+   * @return const UnsealingKey* The key (the first added, if several share
+   * the ID), or NULL if there is none. It remains valid for the life of
+   * the keyring.
+   */
+  const UnsealingKey* findUnsealingKey(const std::vector<unsigned char>& keyId) const;
+
+  /**
+   * @brief Unseal a message with whichever key in the keyring it was
+   * sealed with, without throwing.
+   *
+   * @param message The message to unseal
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal
+   * would have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(const PackagedSealedMessage& message) const;
+
+  /**
+   * @brief Unseal a message with whichever key in the keyring it was sealed with
+   *
+   * @param message The message to unseal
+   * @return const SodiumBuffer The plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if no key
+   * in the keyring can unseal the message.
+   */
+  const SodiumBuffer unseal(const PackagedSealedMessage& message) const;
+};
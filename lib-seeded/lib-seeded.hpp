@@ -2,6 +2,7 @@
 
 
 #include "exceptions.hpp"
+#include "result.hpp"
 
 /** @defgroup BuildingBlocks Building blocks
  *  Classes on which keys derived from seeds are built
@@ -9,7 +10,14 @@
 
 #include "sodium-buffer.hpp"
 #include "recipe.hpp"
+#include "specialized-recipe.hpp"
+#include "recipe-validation.hpp"
 #include "packaged-sealed-message.hpp"
+#include "worker-pool.hpp"
+#include "message-batch.hpp"
+#include "fragments.hpp"
+#include "ephemeral-key-pool.hpp"
+#include "sealed-file.hpp"
 
 /** @defgroup DerivedFromSeeds Derived Keys
  * Keys derived from seed strings using 
@@ -20,6 +28,12 @@
 #include "password.hpp"
 #include "secret.hpp"
 #include "symmetric-key.hpp"
+#include "symmetric-key-stream.hpp"
+#include "symmetric-key-segmented.hpp"
 #include "sealing-key.hpp"
 #include "unsealing-key.hpp"
+#include "sealing-key-stream.hpp"
+#include "authenticated-box.hpp"
+#include "keyring.hpp"
 #include "signing-key.hpp"
+#include "signing-key-stream.hpp"
@@ -0,0 +1,239 @@
+#include <cerrno>
+#include <cstdio>
+#include <system_error>
+#include <utility>
+#include "sodium.h"
+#include "sodium-initializer.hpp"
+#include "mapped-file.hpp"
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+static std::system_error fileError(const char* action, const std::string& path) {
+  return std::system_error(errno, std::generic_category(), std::string(action) + " " + path);
+}
+
+#if defined(_WIN32) || defined(EMSCRIPTEN)
+
+MappedFile::MappedFile(const std::string& _path) :
+  path(_path), writable(false), committed(true), mapping(NULL), mappingLength(0)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    throw fileError("Could not open", path);
+  }
+  unsigned char chunk[64 * 1024];
+  size_t bytesRead;
+  while ((bytesRead = fread(chunk, 1, sizeof chunk, file)) > 0) {
+    buffer.insert(buffer.end(), chunk, chunk + bytesRead);
+  }
+  const bool failed = ferror(file) != 0;
+  fclose(file);
+  if (failed) {
+    throw fileError("Could not read", path);
+  }
+  mappingLength = buffer.size();
+  mapping = mappingLength > 0 ? buffer.data() : NULL;
+}
+
+MappedFile::MappedFile(const std::string& _path, const size_t length) :
+  path(_path), writable(true), committed(false), mapping(NULL), mappingLength(length), buffer(length)
+{
+  mapping = mappingLength > 0 ? buffer.data() : NULL;
+}
+
+MappedFile::MappedFile(MappedFile&& other) :
+  path(std::move(other.path)), temporaryPath(std::move(other.temporaryPath)),
+  writable(other.writable), committed(other.committed),
+  mapping(other.mapping), mappingLength(other.mappingLength), buffer(std::move(other.buffer))
+{
+  other.mapping = NULL;
+  other.mappingLength = 0;
+  other.committed = true;
+}
+
+MappedFile::~MappedFile() {
+  if (writable && !committed) {
+    // Don't leave a partial plaintext in freed memory
+    sodium_memzero(buffer.data(), buffer.size());
+  }
+}
+
+bool MappedFile::refersTo(const std::string& otherPath) const {
+  return otherPath == path;
+}
+
+void MappedFile::commit() {
+  if (!writable || committed) {
+    return;
+  }
+  temporaryPath = path + ".partial";
+  FILE* file = fopen(temporaryPath.c_str(), "wb");
+  if (file == NULL) {
+    throw fileError("Could not create", temporaryPath);
+  }
+  const bool failed = fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size();
+  if (fclose(file) != 0 || failed) {
+    std::remove(temporaryPath.c_str());
+    throw fileError("Could not write", temporaryPath);
+  }
+#ifdef _WIN32
+  // Windows won't rename over an existing file
+  std::remove(path.c_str());
+#endif
+  if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    const std::system_error error = fileError("Could not write", path);
+    std::remove(temporaryPath.c_str());
+    throw error;
+  }
+  committed = true;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& _path) :
+  path(_path), writable(false), committed(true), mapping(NULL), mappingLength(0)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw fileError("Could not open", path);
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    const std::system_error error = fileError("Could not open", path);
+    close(fd);
+    throw error;
+  }
+  device = (unsigned long long) status.st_dev;
+  inode = (unsigned long long) status.st_ino;
+  mappingLength = (size_t) status.st_size;
+  if (mappingLength > 0) {
+    void* mapped = mmap(NULL, mappingLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      const std::system_error error = fileError("Could not map", path);
+      close(fd);
+      throw error;
+    }
+    mapping = (unsigned char*) mapped;
+    // Files are sealed and unsealed front to back
+    madvise(mapped, mappingLength, MADV_SEQUENTIAL);
+  }
+  // The mapping remains valid once the descriptor is closed
+  close(fd);
+}
+
+// Create a new hidden file beside path, named with a random suffix,
+// with the mode that creating path itself would have given it:
+// that of the file it will replace, if there is one, or else 0666
+// less the umask.  (mkstemp would create it with mode 0600.)
+static int createTemporaryFile(const std::string& path, std::string& temporaryPath) {
+  const size_t nameStart = path.find_last_of('/') + 1;
+  const std::string prefix = path.substr(0, nameStart) + "." + path.substr(nameStart) + ".";
+  ensureSodiumInitialized();
+  int fd = -1;
+  for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+    unsigned char suffix[6];
+    randombytes_buf(suffix, sizeof suffix);
+    char suffixHex[2 * sizeof suffix + 1];
+    sodium_bin2hex(suffixHex, sizeof suffixHex, suffix, sizeof suffix);
+    temporaryPath = prefix + suffixHex;
+    fd = open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 && errno != EEXIST) {
+      break;
+    }
+  }
+  if (fd < 0) {
+    return fd;
+  }
+  struct stat existing;
+  if (
+    stat(path.c_str(), &existing) == 0 && S_ISREG(existing.st_mode) &&
+    fchmod(fd, existing.st_mode & 07777) != 0
+  ) {
+    const int savedErrno = errno;
+    close(fd);
+    unlink(temporaryPath.c_str());
+    errno = savedErrno;
+    return -1;
+  }
+  return fd;
+}
+
+MappedFile::MappedFile(const std::string& _path, const size_t length) :
+  path(_path), writable(true), committed(false), mapping(NULL), mappingLength(length)
+{
+  // Renamed over path only by commit
+  const int fd = createTemporaryFile(path, temporaryPath);
+  if (fd < 0) {
+    throw fileError("Could not create", path);
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || ftruncate(fd, (off_t) length) != 0) {
+    const std::system_error error = fileError("Could not create", path);
+    close(fd);
+    unlink(temporaryPath.c_str());
+    throw error;
+  }
+  device = (unsigned long long) status.st_dev;
+  inode = (unsigned long long) status.st_ino;
+  if (mappingLength > 0) {
+    void* mapped = mmap(NULL, mappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+      const std::system_error error = fileError("Could not map", path);
+      close(fd);
+      unlink(temporaryPath.c_str());
+      throw error;
+    }
+    mapping = (unsigned char*) mapped;
+  }
+  close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) :
+  path(std::move(other.path)), temporaryPath(std::move(other.temporaryPath)),
+  writable(other.writable), committed(other.committed),
+  mapping(other.mapping), mappingLength(other.mappingLength),
+  device(other.device), inode(other.inode)
+{
+  other.mapping = NULL;
+  other.mappingLength = 0;
+  other.committed = true;
+}
+
+MappedFile::~MappedFile() {
+  if (mapping != NULL) {
+    if (writable && !committed) {
+      // Don't leave a partial plaintext in the page cache
+      sodium_memzero(mapping, mappingLength);
+    }
+    munmap(mapping, mappingLength);
+  }
+  if (writable && !committed) {
+    unlink(temporaryPath.c_str());
+  }
+}
+
+bool MappedFile::refersTo(const std::string& otherPath) const {
+  struct stat status;
+  return stat(otherPath.c_str(), &status) == 0 &&
+    (unsigned long long) status.st_dev == device &&
+    (unsigned long long) status.st_ino == inode;
+}
+
+void MappedFile::commit() {
+  if (!writable || committed) {
+    return;
+  }
+  if (mapping != NULL && msync(mapping, mappingLength, MS_SYNC) != 0) {
+    throw fileError("Could not write", path);
+  }
+  if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    throw fileError("Could not write", path);
+  }
+  committed = true;
+}
+
+#endif
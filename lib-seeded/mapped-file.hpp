@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief A file mapped into memory, so it can be sealed or unsealed in
+ * place without first being read into (or assembled in) a buffer.
+ *
+ * A file opened for reading is mapped read-only. A file created for
+ * writing is staged in a temporary file of the given length, in the same
+ * directory, which commit() renames over the path. The temporary file is
+ * given the mode of the file it will replace or, if there is none, the
+ * mode a new file gets under the umask. Until commit, any file already at
+ * the path is left untouched, and if the MappedFile is destroyed without
+ * being committed, the temporary file is wiped and deleted, so a failed
+ * seal or unseal neither leaves a partial file (or partial plaintext)
+ * behind nor destroys an existing one.
+ *
+ * Where memory mapping isn't available (Windows and Emscripten), the
+ * file is read into, or written from, a buffer instead.
+ *
+ * @exception std::system_error Thrown by the constructors and commit
+ * if the file can't be opened, created, mapped, or written.
+ *
+ * @ingroup BuildingBlocks
+ */
+class MappedFile {
+  std::string path;
+  // Where a file created for writing is staged until commit
+  std::string temporaryPath;
+  bool writable;
+  bool committed;
+  unsigned char* mapping;
+  size_t mappingLength;
+#if defined(_WIN32) || defined(EMSCRIPTEN)
+  std::vector<unsigned char> buffer;
+#else
+  // Identifies the file, so refersTo can detect other paths to it
+  unsigned long long device;
+  unsigned long long inode;
+#endif
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+  /**
+   * @brief Map an existing file for reading
+   *
+   * @param path The path of the file to map
+   */
+  explicit MappedFile(const std::string& path);
+
+  /**
+   * @brief Create (or truncate) a file of a given length and map it for writing
+   *
+   * @param path The path of the file to create
+   * @param length The length of the file in bytes
+   */
+  MappedFile(const std::string& path, const size_t length);
+
+  /**
+   * @brief Move a mapping, leaving the original empty
+   */
+  MappedFile(MappedFile&& other);
+
+  ~MappedFile();
+
+  /**
+   * @brief The mapped contents of the file (NULL if it's empty)
+   */
+  unsigned char* data() const { return mapping; }
+
+  /**
+   * @brief The length of the file in bytes
+   */
+  size_t length() const { return mappingLength; }
+
+  /**
+   * @brief True if path names the file this MappedFile maps, so that
+   * callers can refuse to write a file over the one they are reading
+   */
+  bool refersTo(const std::string& path) const;
+
+  /**
+   * @brief Flush a file created for writing and move it to its path,
+   * replacing any file there, so that it is kept once this MappedFile
+   * is destroyed
+   */
+  void commit();
+};
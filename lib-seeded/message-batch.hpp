@@ -0,0 +1,214 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "result.hpp"
+#include "parallel-for.hpp"
+#include "worker-pool.hpp"
+
+/**
+ * @brief One message (or ciphertext) in a batch passed to a key's
+ * sealBatch or unsealBatch method.
+ *
+ * Nothing is copied: the data and unsealingInstructions must remain
+ * valid until the batch call returns.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct BatchMessage {
+  /**
+   * @brief The message to seal, or the ciphertext to unseal
+   */
+  const unsigned char* data;
+  /**
+   * @brief The length of data in bytes
+   */
+  size_t length;
+  /**
+   * @brief The unsealingInstructions to seal or unseal with,
+   * or NULL for none
+   */
+  const std::string* unsealingInstructions;
+};
+
+/**
+ * @brief The ciphertexts produced by a sealBatch call, stored
+ * contiguously in one arena.
+ *
+ * Ciphertext i occupies arena[offsets[i], offsets[i + 1]).
+ *
+ * @ingroup BuildingBlocks
+ */
+struct SealedBatch {
+  /**
+   * @brief Every ciphertext in the batch, in order
+   */
+  std::vector<unsigned char> arena;
+  /**
+   * @brief The offset of each ciphertext in the arena, followed by
+   * the arena's length (so there is one more offset than ciphertexts)
+   */
+  std::vector<size_t> offsets;
+
+  /**
+   * @brief The number of ciphertexts in the batch
+   */
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+  /**
+   * @brief The start of ciphertext i
+   */
+  const unsigned char* data(const size_t i) const { return arena.data() + offsets[i]; }
+  /**
+   * @brief The length of ciphertext i
+   */
+  size_t length(const size_t i) const { return offsets[i + 1] - offsets[i]; }
+};
+
+/**
+ * @brief The plaintexts produced by an unsealBatch call, stored
+ * contiguously in one arena of locked memory, with the outcome of
+ * unsealing each ciphertext.
+ *
+ * Plaintext i occupies arena.data[offsets[i], offsets[i + 1]).
+ * If ciphertext i failed to unseal, errors[i] says why and the
+ * plaintext's space in the arena is left zeroed.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct UnsealedBatch {
+  /**
+   * @brief Every plaintext in the batch, in order
+   */
+  SodiumBuffer arena;
+  /**
+   * @brief The offset of each plaintext in the arena, followed by
+   * the arena's length (so there is one more offset than plaintexts)
+   */
+  std::vector<size_t> offsets;
+  /**
+   * @brief The error each ciphertext failed to unseal with,
+   * or an error with code SeededErrorCode::None if it was unsealed
+   */
+  std::vector<SeededError> errors;
+
+  /**
+   * @brief The number of plaintexts in the batch
+   */
+  size_t size() const { return errors.size(); }
+  /**
+   * @brief True if ciphertext i was unsealed
+   */
+  bool ok(const size_t i) const { return !errors[i]; }
+  /**
+   * @brief The start of plaintext i
+   */
+  const unsigned char* data(const size_t i) const { return arena.data + offsets[i]; }
+  /**
+   * @brief The length of plaintext i (0 if it failed to unseal)
+   */
+  size_t length(const size_t i) const { return ok(i) ? offsets[i + 1] - offsets[i] : 0; }
+};
+
+namespace MessageBatch {
+  /**
+   * @brief The unsealingInstructions of a BatchMessage, or an empty
+   * string if it has none
+   */
+  inline const std::string& unsealingInstructions(const BatchMessage& message) {
+    static const std::string none;
+    return message.unsealingInstructions == NULL ? none : *message.unsealingInstructions;
+  }
+
+  /**
+   * @brief A forEach for seal and unseal that starts threadCount
+   * threads for the call (see parallelFor)
+   */
+  inline std::function<void(size_t, const std::function<void(size_t)>&)> onThreads(const size_t threadCount) {
+    return [threadCount](const size_t count, const std::function<void(size_t)>& body) {
+      parallelFor(count, body, threadCount);
+    };
+  }
+
+  /**
+   * @brief A forEach for seal and unseal that runs on a WorkerPool's threads
+   */
+  inline std::function<void(size_t, const std::function<void(size_t)>&)> onPool(WorkerPool& pool) {
+    return [&pool](const size_t count, const std::function<void(size_t)>& body) {
+      pool.parallelFor(count, body);
+    };
+  }
+
+  /**
+   * @brief Seal a batch into a single arena, sized up front from
+   * `sealedLength(messageLength)`, by calling
+   * `seal(message, ciphertext, ciphertextCapacity)` for each message
+   * from within `forEach(count, body)` (see onThreads and onPool).
+   * Used to implement the keys' sealBatch methods.
+   */
+  template <typename ForEach, typename SealedLength, typename Seal>
+  SealedBatch seal(
+    const BatchMessage* messages,
+    const size_t count,
+    const ForEach& forEach,
+    const SealedLength& sealedLength,
+    const Seal& seal
+  ) {
+    SealedBatch batch;
+    batch.offsets.resize(count + 1);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+      batch.offsets[i] = offset;
+      offset += sealedLength(messages[i].length);
+    }
+    batch.offsets[count] = offset;
+    batch.arena.resize(offset);
+    forEach(count, [&](const size_t i) {
+      seal(messages[i], batch.arena.data() + batch.offsets[i], batch.offsets[i + 1] - batch.offsets[i]);
+    });
+    return batch;
+  }
+
+  /**
+   * @brief Unseal a batch into a single arena, sized up front from
+   * `unsealedLength(ciphertextLength)`, by calling
+   * `tryUnseal(ciphertext, plaintext, plaintextCapacity)`, which
+   * returns a Result<size_t>, for each ciphertext from within
+   * `forEach(count, body)` (see onThreads and onPool).
+   * Used to implement the keys' unsealBatch methods.
+   */
+  template <typename ForEach, typename UnsealedLength, typename TryUnseal>
+  UnsealedBatch unseal(
+    const BatchMessage* ciphertexts,
+    const size_t count,
+    const ForEach& forEach,
+    const UnsealedLength& unsealedLength,
+    const TryUnseal& tryUnseal
+  ) {
+    std::vector<size_t> offsets(count + 1);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+      offsets[i] = offset;
+      offset += unsealedLength(ciphertexts[i].length);
+    }
+    offsets[count] = offset;
+    UnsealedBatch batch = {
+      SodiumBuffer(offset),
+      std::move(offsets),
+      std::vector<SeededError>(count, SeededError{SeededErrorCode::None, NULL})
+    };
+    forEach(count, [&](const size_t i) {
+      const Result<size_t> result = tryUnseal(
+        ciphertexts[i], batch.arena.data + batch.offsets[i], batch.offsets[i + 1] - batch.offsets[i]
+      );
+      if (!result.ok()) {
+        // Length errors are reported before anything is written, and the
+        // arena starts out filled with sodium_malloc's garbage
+        sodium_memzero(batch.arena.data + batch.offsets[i], batch.offsets[i + 1] - batch.offsets[i]);
+        batch.errors[i] = result.error();
+      }
+    });
+    return batch;
+  }
+}
@@ -1,30 +1,50 @@
+#include <utility>
 #include "packaged-sealed-message.hpp"
 #include "github-com-nlohmann-json/json.hpp"
 #include "exceptions.hpp"
 #include "convert.hpp"
 #include "common-names.hpp"
+#include "json-fields.hpp"
 
 // JSON field names
 namespace PackagedSealedMessageJsonFields {
   static const std::string ciphertext = "ciphertext";
   static const std::string recipe = CommonNames::recipe;
   static const std::string unsealingInstructions = "unsealingInstructions";
+  static const std::string keyId = "keyId";
 }
 
+const size_t PackagedSealedMessage::KeyIdBytes;
+
 PackagedSealedMessage::PackagedSealedMessage(
         const std::vector<unsigned char>& _ciphertext,
         const std::string& _recipe,
-        const std::string& _unsealingInstructions
+        const std::string& _unsealingInstructions,
+        const std::vector<unsigned char>& _keyId
 ) : 
     ciphertext(_ciphertext),
     recipe(_recipe),
-    unsealingInstructions(_unsealingInstructions)
+    unsealingInstructions(_unsealingInstructions),
+    keyId(_keyId)
+    {}
+
+PackagedSealedMessage::PackagedSealedMessage(
+        std::vector<unsigned char>&& _ciphertext,
+        const std::string& _recipe,
+        const std::string& _unsealingInstructions,
+        const std::vector<unsigned char>& _keyId
+) : 
+    ciphertext(std::move(_ciphertext)),
+    recipe(_recipe),
+    unsealingInstructions(_unsealingInstructions),
+    keyId(_keyId)
     {}
 
 PackagedSealedMessage::PackagedSealedMessage(const PackagedSealedMessage &other) :
   ciphertext(other.ciphertext),
   recipe(other.recipe),
-  unsealingInstructions(other.unsealingInstructions)
+  unsealingInstructions(other.unsealingInstructions),
+  keyId(other.keyId)
   {}
 
 const SodiumBuffer PackagedSealedMessage::toSerializedBinaryForm() const {
@@ -55,18 +75,35 @@ const std::string PackagedSealedMessage::toJson(
   if (unsealingInstructions.size() > 0) {
     asJson[PackagedSealedMessageJsonFields::unsealingInstructions] = unsealingInstructions;
   }
+  if (keyId.size() > 0) {
+    asJson[PackagedSealedMessageJsonFields::keyId] = toHexStr(keyId);
+  }
   return asJson.dump(indent, indent_char);
 }
   
-PackagedSealedMessage PackagedSealedMessage::fromJson(const std::string& packagedSealedMessageAsJson) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(packagedSealedMessageAsJson);
-    return PackagedSealedMessage(
-      hexStrToByteVector(jsonObject.at(PackagedSealedMessageJsonFields::ciphertext)),
-      jsonObject.value<std::string>(PackagedSealedMessageJsonFields::recipe, ""),
-      jsonObject.value<std::string>(PackagedSealedMessageJsonFields::unsealingInstructions, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+Result<PackagedSealedMessage> PackagedSealedMessage::tryFromJson(const std::string& packagedSealedMessageAsJson) {
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(packagedSealedMessageAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* ciphertextHex = JsonFields::requiredString(jsonObject, PackagedSealedMessageJsonFields::ciphertext);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, PackagedSealedMessageJsonFields::recipe);
+  const std::string* unsealingInstructions = JsonFields::optionalString(jsonObject, PackagedSealedMessageJsonFields::unsealingInstructions);
+  const std::string* keyIdHex = JsonFields::optionalString(jsonObject, PackagedSealedMessageJsonFields::keyId);
+  if (ciphertextHex == NULL || recipe == NULL || unsealingInstructions == NULL || keyIdHex == NULL) {
+    return JsonFields::parsingError;
+  }
+  for (const std::string* hex : {ciphertextHex, keyIdHex}) {
+    const SeededError hexError = hexStrError(*hex);
+    if (hexError) {
+      return hexError;
+    }
   }
+  return Result<PackagedSealedMessage>(
+    ResultInPlace(), hexStrToByteVector(*ciphertextHex), *recipe, *unsealingInstructions, hexStrToByteVector(*keyIdHex)
+  );
+}
+
+PackagedSealedMessage PackagedSealedMessage::fromJson(const std::string& packagedSealedMessageAsJson) {
+  return tryFromJson(packagedSealedMessageAsJson).valueOrThrow();
 }
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include "sodium-buffer.hpp"
+#include "result.hpp"
 
 /**
  * @brief When a message is sealed, the ciphertext is packaged with the recipe
@@ -14,6 +15,11 @@
 class PackagedSealedMessage {
 
 public:
+    /**
+     * @brief The length of the key IDs that may accompany a sealed message
+     */
+    static const size_t KeyIdBytes = 8;
+
     /**
      * @brief The sealed message as a raw array of bytes
      */
@@ -28,6 +34,17 @@ public:
      * requests the unsealer to follow as a condition of unsealing.
      */
     const std::string unsealingInstructions;
+    /**
+     * @brief An optional short identifier of the key that sealed the
+     * message (see SymmetricKey::keyId and SealingKey::keyId), so that
+     * a Keyring can find the key to unseal it with without trying each.
+     * Empty if the message was sealed without one.
+     *
+     * The key ID is carried by the JSON form only. The binary form is
+     * unchanged, so that existing readers can still parse it, and
+     * messages reconstituted from it have no key ID.
+     */
+    const std::vector<unsigned char> keyId;
 
     /**
      * @brief Construct directly from the constituent members
@@ -37,11 +54,31 @@ public:
      * encryption/decryption keys.
      * @param unsealingInstructions Optional public instructions that the sealer
      * requests the unsealer to follow as a condition of unsealing.
+     * @param keyId Optional identifier of the key that sealed the message
      */
     PackagedSealedMessage(
         const std::vector<unsigned char>& ciphertext,
         const std::string& recipe,
-        const std::string& unsealingInstructions
+        const std::string& unsealingInstructions,
+        const std::vector<unsigned char>& keyId = {}
+    );
+
+    /**
+     * @brief Construct from the constituent members, taking ownership
+     * of the ciphertext rather than copying it
+     * 
+     * @param ciphertext  The binary sealed message
+     * @param recipe  The recipe used to generate the
+     * encryption/decryption keys.
+     * @param unsealingInstructions Optional public instructions that the sealer
+     * requests the unsealer to follow as a condition of unsealing.
+     * @param keyId Optional identifier of the key that sealed the message
+     */
+    PackagedSealedMessage(
+        std::vector<unsigned char>&& ciphertext,
+        const std::string& recipe,
+        const std::string& unsealingInstructions,
+        const std::vector<unsigned char>& keyId = {}
     );
 
     /**
@@ -91,4 +128,11 @@ public:
    */
   static PackagedSealedMessage fromJson(const std::string& packagedSealedMessageAsJson);
 
+  /**
+   * @brief Reconstitute a PackagedSealedMessage from JSON without throwing.
+   *
+   * @return Result<PackagedSealedMessage> The message, or the error fromJson would have thrown.
+   */
+  static Result<PackagedSealedMessage> tryFromJson(const std::string& packagedSealedMessageAsJson);
+
 };
\ No newline at end of file
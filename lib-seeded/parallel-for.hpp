@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <vector>
+#ifndef EMSCRIPTEN
+  #include <thread>
+#endif
+
+/**
+ * @brief The number of threads parallelFor uses when not told how many to use:
+ * one per hardware thread.
+ *
+ * @ingroup BuildingBlocks
+ */
+inline size_t defaultThreadCount() {
+#ifdef EMSCRIPTEN
+  return 1;
+#else
+  const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+  return hardwareThreads == 0 ? 1 : hardwareThreads;
+#endif
+}
+
+/**
+ * @brief Call `body(index)` for every index in [0, count), spreading
+ * the calls across threads.
+ *
+ * Threads claim indexes in small chunks from a shared counter, so slow
+ * items don't leave other threads idle. Calls for different indexes may
+ * run concurrently and in any order, so `body` must only write state
+ * that belongs to its index. If any call throws, the remaining indexes
+ * are skipped and the first exception is rethrown on the calling thread.
+ * With one thread (or under Emscripten), the calls run in order on the
+ * calling thread.
+ *
+ * @param count The number of indexes
+ * @param body The function to call with each index
+ * @param threadCount The maximum number of threads to use, including the
+ * calling thread, or 0 for defaultThreadCount()
+ *
+ * @ingroup BuildingBlocks
+ */
+template <typename Body>
+void parallelFor(const size_t count, const Body& body, size_t threadCount = 0) {
+  if (threadCount == 0) {
+    threadCount = defaultThreadCount();
+  }
+  threadCount = std::min(threadCount, count);
+#ifdef EMSCRIPTEN
+  threadCount = 1;
+#endif
+  if (threadCount <= 1) {
+    for (size_t index = 0; index < count; index++) {
+      body(index);
+    }
+    return;
+  }
+
+  // Eight chunks per thread balances load without contending on the counter
+  const size_t chunkSize = std::max((size_t) 1, count / (threadCount * 8));
+  std::atomic<size_t> nextIndex(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr firstException;
+  std::mutex exceptionMutex;
+
+  const auto work = [&]() {
+    try {
+      while (!failed.load(std::memory_order_relaxed)) {
+        const size_t start = nextIndex.fetch_add(chunkSize);
+        if (start >= count) {
+          break;
+        }
+        const size_t end = std::min(count, start + chunkSize);
+        for (size_t index = start; index < end; index++) {
+          body(index);
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exceptionMutex);
+      if (!firstException) {
+        firstException = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+#ifndef EMSCRIPTEN
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+  for (size_t i = 1; i < threadCount; i++) {
+    try {
+      threads.emplace_back(work);
+    } catch (const std::system_error&) {
+      // Proceed with the threads we were able to start
+      break;
+    }
+  }
+  work();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+#endif
+  if (firstException) {
+    std::rethrow_exception(firstException);
+  }
+}
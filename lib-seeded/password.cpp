@@ -5,6 +5,7 @@
 #include <algorithm>    // std::min
 #include <sstream> 
 #include "common-names.hpp"
+#include "json-fields.hpp"
 
 const std::vector<std::string> parseOrGetWordList(
   const Recipe& recipe,
@@ -136,16 +137,21 @@ namespace PasswordJsonFields {
   static const std::string recipe = CommonNames::recipe;
 }
 
-Password Password::fromJson(const std::string& secretAsJson) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(secretAsJson);
-    return Password(
-      jsonObject.value<std::string>(PasswordJsonFields::password, ""),
-      jsonObject.value<std::string>(PasswordJsonFields::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+Result<Password> Password::tryFromJson(const std::string& secretAsJson) {
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(secretAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* password = JsonFields::optionalString(jsonObject, PasswordJsonFields::password);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, PasswordJsonFields::recipe);
+  if (password == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
   }
+  return Result<Password>(ResultInPlace(), *password, *recipe);
+}
+
+Password Password::fromJson(const std::string& secretAsJson) {
+  return tryFromJson(secretAsJson).valueOrThrow();
 }
 
 const std::string
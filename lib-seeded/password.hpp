@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sodium-buffer.hpp"
+#include "result.hpp"
 #include <string>
 
 /**
@@ -156,4 +157,13 @@ public:
     const std::string& seedAsJson
   );
 
+  /**
+   * @brief Reconstitute a Password from JSON without throwing.
+   *
+   * @return Result<Password> The Password, or the error fromJson would have thrown.
+   */
+  static Result<Password> tryFromJson(
+    const std::string& seedAsJson
+  );
+
 };
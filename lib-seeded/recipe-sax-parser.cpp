@@ -0,0 +1,178 @@
+#include <utility>
+#include <vector>
+#include "recipe-sax-parser.hpp"
+
+// The names of an enum's values, read once from its
+// NLOHMANN_JSON_SERIALIZE_ENUM table so that values added to
+// derivation-parameters.hpp are recognized here too.
+// Every enum in the recipe schema has its invalid value at 0,
+// mapped to null, and its valid values numbered from 1.
+template <typename EnumType>
+static std::vector<std::pair<std::string, EnumType>> enumNames() {
+  std::vector<std::pair<std::string, EnumType>> names;
+  for (int i = 1; ; i++) {
+    const nlohmann::json name = static_cast<EnumType>(i);
+    if (!name.is_string()) {
+      break;
+    }
+    names.push_back(std::make_pair(name.get<std::string>(), static_cast<EnumType>(i)));
+  }
+  return names;
+}
+
+template <typename EnumType>
+static EnumType enumFromName(const std::string& name) {
+  static const std::vector<std::pair<std::string, EnumType>> names = enumNames<EnumType>();
+  for (const auto& entry : names) {
+    if (entry.first == name) {
+      return entry.second;
+    }
+  }
+  return static_cast<EnumType>(0);
+}
+
+bool RecipeSaxParser::parse(const std::string& recipeJson) {
+  return nlohmann::json::sax_parse(recipeJson, this);
+}
+
+RecipeNumericField* RecipeSaxParser::currentNumericField() {
+  switch (currentField) {
+    case Field::LengthInBytes: return &lengthInBytes;
+    case Field::LengthInBits: return &lengthInBits;
+    case Field::LengthInWords: return &lengthInWords;
+    case Field::LengthInChars: return &lengthInChars;
+    case Field::HashFunctionMemoryPasses: return &hashFunctionMemoryPasses;
+    case Field::HashFunctionMemoryLimitInBytes: return &hashFunctionMemoryLimitInBytes;
+    default: return NULL;
+  }
+}
+
+void RecipeSaxParser::setCurrentFieldToNonString() {
+  switch (currentField) {
+    case Field::Type: type.set(RecipeJson::type::_INVALID_TYPE_); break;
+    case Field::Algorithm: algorithm.set(RecipeJson::Algorithm::_INVALID_ALGORITHM_); break;
+    case Field::WordList: wordList.set(RecipeJson::WordList::_INVALID_WORD_LIST_); break;
+    case Field::HashFunction: hashFunction.set(RecipeJson::HashFunction::_INVALID_HASHFUNCTION_); break;
+    case Field::NonceType: nonceType.set(RecipeJson::NonceType::_INVALID_NONCE_TYPE_); break;
+    default: break;
+  }
+}
+
+bool RecipeSaxParser::null() {
+  if (isTopLevelFieldValue()) {
+    setCurrentFieldToNonString();
+    RecipeNumericField* field = currentNumericField();
+    if (field != NULL) field->setNotANumber();
+  }
+  return true;
+}
+
+bool RecipeSaxParser::boolean(bool value) {
+  if (isTopLevelFieldValue()) {
+    setCurrentFieldToNonString();
+    RecipeNumericField* field = currentNumericField();
+    if (field != NULL) field->setBoolean(value);
+  }
+  return true;
+}
+
+bool RecipeSaxParser::number_integer(nlohmann::json::number_integer_t value) {
+  if (isTopLevelFieldValue()) {
+    setCurrentFieldToNonString();
+    RecipeNumericField* field = currentNumericField();
+    if (field != NULL) field->setInteger(value);
+  }
+  return true;
+}
+
+bool RecipeSaxParser::number_unsigned(nlohmann::json::number_unsigned_t value) {
+  if (isTopLevelFieldValue()) {
+    setCurrentFieldToNonString();
+    RecipeNumericField* field = currentNumericField();
+    if (field != NULL) field->setUnsigned(value);
+  }
+  return true;
+}
+
+bool RecipeSaxParser::number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t&) {
+  if (isTopLevelFieldValue()) {
+    setCurrentFieldToNonString();
+    RecipeNumericField* field = currentNumericField();
+    if (field != NULL) field->setFloat(value);
+  }
+  return true;
+}
+
+bool RecipeSaxParser::string(nlohmann::json::string_t& value) {
+  if (isTopLevelFieldValue()) {
+    switch (currentField) {
+      case Field::Type: type.set(enumFromName<RecipeJson::type>(value)); break;
+      case Field::Algorithm: algorithm.set(enumFromName<RecipeJson::Algorithm>(value)); break;
+      case Field::WordList: wordList.set(enumFromName<RecipeJson::WordList>(value)); break;
+      case Field::HashFunction: hashFunction.set(enumFromName<RecipeJson::HashFunction>(value)); break;
+      case Field::NonceType: nonceType.set(enumFromName<RecipeJson::NonceType>(value)); break;
+      default: {
+        RecipeNumericField* field = currentNumericField();
+        if (field != NULL) field->setNotANumber();
+      }
+    }
+  }
+  return true;
+}
+
+// Binary values only arise in binary formats such as CBOR, never in JSON
+bool RecipeSaxParser::binary(nlohmann::json::binary_t&) {
+  return null();
+}
+
+bool RecipeSaxParser::start_object(std::size_t) {
+  if (depth == 0) {
+    isObject = true;
+  } else if (isTopLevelFieldValue()) {
+    null();
+  }
+  depth++;
+  return true;
+}
+
+bool RecipeSaxParser::key(nlohmann::json::string_t& name) {
+  if (isTopLevelFieldValue()) {
+    namespace FieldNames = RecipeJson::FieldNames;
+    currentField =
+      name == FieldNames::type ? Field::Type :
+      name == FieldNames::algorithm ? Field::Algorithm :
+      name == FieldNames::wordList ? Field::WordList :
+      name == FieldNames::hashFunction ? Field::HashFunction :
+      name == FieldNames::nonceType ? Field::NonceType :
+      name == FieldNames::lengthInBytes ? Field::LengthInBytes :
+      name == FieldNames::lengthInBits ? Field::LengthInBits :
+      name == FieldNames::lengthInWords ? Field::LengthInWords :
+      name == FieldNames::lengthInChars ? Field::LengthInChars :
+      name == FieldNames::hashFunctionMemoryPasses ? Field::HashFunctionMemoryPasses :
+      name == FieldNames::hashFunctionMemoryLimitInBytes ? Field::HashFunctionMemoryLimitInBytes :
+      Field::None;
+  }
+  return true;
+}
+
+bool RecipeSaxParser::end_object() {
+  depth--;
+  return true;
+}
+
+bool RecipeSaxParser::start_array(std::size_t) {
+  if (isTopLevelFieldValue()) {
+    null();
+  }
+  depth++;
+  return true;
+}
+
+bool RecipeSaxParser::end_array() {
+  depth--;
+  return true;
+}
+
+bool RecipeSaxParser::parse_error(std::size_t, const std::string&, const nlohmann::json::exception&) {
+  return false;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "github-com-nlohmann-json/json.hpp"
+// Must come after json.hpp
+#include "./externally-generated/derivation-parameters.hpp"
+
+/**
+ * The most recent value a recipe gave for a numeric field, kept in the form
+ * nlohmann::json stores numbers so that read converts it exactly as
+ * basic_json::value<NumberType> would.
+ */
+class RecipeNumericField {
+  enum class Kind { Absent, Integer, Unsigned, Float, Boolean, NotANumber };
+  Kind kind = Kind::Absent;
+  union {
+    std::int64_t integerValue;
+    std::uint64_t unsignedValue;
+    double floatValue;
+    bool booleanValue;
+  };
+
+public:
+  void setInteger(const std::int64_t value) { kind = Kind::Integer; integerValue = value; }
+  void setUnsigned(const std::uint64_t value) { kind = Kind::Unsigned; unsignedValue = value; }
+  void setFloat(const double value) { kind = Kind::Float; floatValue = value; }
+  void setBoolean(const bool value) { kind = Kind::Boolean; booleanValue = value; }
+  void setNotANumber() { kind = Kind::NotANumber; }
+
+  /**
+   * Read the field, or defaultValue if it was absent, returning false
+   * (where basic_json::value would throw) if its value was not a number.
+   *
+   * basic_json converts booleans to arithmetic types other than its own
+   * number types, so a boolean is read as 0 or 1 for unsigned int fields
+   * but rejected for size_t fields.
+   */
+  template <typename NumberType>
+  bool read(const NumberType defaultValue, NumberType& value) const {
+    switch (kind) {
+      case Kind::Absent: value = defaultValue; return true;
+      case Kind::Integer: value = static_cast<NumberType>(integerValue); return true;
+      case Kind::Unsigned: value = static_cast<NumberType>(unsignedValue); return true;
+      case Kind::Float: value = static_cast<NumberType>(floatValue); return true;
+      case Kind::Boolean:
+        if (
+          std::is_same<NumberType, nlohmann::json::number_unsigned_t>::value ||
+          std::is_same<NumberType, nlohmann::json::number_integer_t>::value ||
+          std::is_same<NumberType, nlohmann::json::number_float_t>::value
+        ) {
+          return false;
+        }
+        value = static_cast<NumberType>(booleanValue);
+        return true;
+      default: return false;
+    }
+  }
+};
+
+/**
+ * The most recent value a recipe gave for an enum field. As with
+ * NLOHMANN_JSON_SERIALIZE_ENUM, any value other than one of the
+ * enum's names is read as the enum's invalid (zero) value.
+ */
+template <typename EnumType>
+class RecipeEnumField {
+  bool present = false;
+  EnumType value = static_cast<EnumType>(0);
+
+public:
+  void set(const EnumType _value) { present = true; value = _value; }
+
+  EnumType read(const EnumType defaultValue) const {
+    return present ? value : defaultValue;
+  }
+};
+
+/**
+ * A SAX handler for nlohmann::json::sax_parse that captures the recipe
+ * fields the Recipe class reads, without building a JSON DOM.
+ *
+ * It uses nlohmann's lexer and parser, so it accepts exactly the JSON
+ * that nlohmann::json::parse does. Only fields of the top-level object
+ * are captured and, as with the DOM, when a field appears more than
+ * once its last value wins.
+ */
+class RecipeSaxParser {
+public:
+  /**
+   * True if the recipe's top-level value is an object
+   */
+  bool isObject = false;
+
+  RecipeEnumField<RecipeJson::type> type;
+  RecipeEnumField<RecipeJson::Algorithm> algorithm;
+  RecipeEnumField<RecipeJson::WordList> wordList;
+  RecipeEnumField<RecipeJson::HashFunction> hashFunction;
+  RecipeEnumField<RecipeJson::NonceType> nonceType;
+  RecipeNumericField lengthInBytes;
+  RecipeNumericField lengthInBits;
+  RecipeNumericField lengthInWords;
+  RecipeNumericField lengthInChars;
+  RecipeNumericField hashFunctionMemoryPasses;
+  RecipeNumericField hashFunctionMemoryLimitInBytes;
+
+  /**
+   * Parse a recipe, returning false if it is not valid JSON.
+   */
+  bool parse(const std::string& recipeJson);
+
+  // The nlohmann::json_sax interface
+  bool null();
+  bool boolean(bool value);
+  bool number_integer(nlohmann::json::number_integer_t value);
+  bool number_unsigned(nlohmann::json::number_unsigned_t value);
+  bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t&);
+  bool string(nlohmann::json::string_t& value);
+  bool binary(nlohmann::json::binary_t& value);
+  bool start_object(std::size_t);
+  bool key(nlohmann::json::string_t& name);
+  bool end_object();
+  bool start_array(std::size_t);
+  bool end_array();
+  bool parse_error(std::size_t, const std::string&, const nlohmann::json::exception&);
+
+private:
+  enum class Field {
+    None,
+    Type,
+    Algorithm,
+    WordList,
+    HashFunction,
+    NonceType,
+    LengthInBytes,
+    LengthInBits,
+    LengthInWords,
+    LengthInChars,
+    HashFunctionMemoryPasses,
+    HashFunctionMemoryLimitInBytes
+  };
+
+  std::size_t depth = 0;
+  Field currentField = Field::None;
+
+  bool isTopLevelFieldValue() const { return depth == 1 && isObject; }
+  RecipeNumericField* currentNumericField();
+  void setCurrentFieldToNonString();
+};
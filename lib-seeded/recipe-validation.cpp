@@ -0,0 +1,38 @@
+#include "recipe-validation.hpp"
+#include "parallel-for.hpp"
+
+RecipeValidation validateRecipe(
+  const std::string& recipe,
+  const RecipeJson::type typeRequired
+) {
+  RecipeValidation validation;
+  const Result<Recipe> parsed = Recipe::tryParse(recipe, typeRequired);
+  if (!parsed) {
+    validation.error = parsed.error();
+    return validation;
+  }
+  const Recipe& recipeObj = parsed.value();
+  validation.type = recipeObj.type;
+  validation.algorithm = recipeObj.algorithm;
+  validation.hashFunction = recipeObj.hashFunction;
+  validation.lengthInBytes = recipeObj.lengthInBytes;
+  if (recipeObj.type == RecipeJson::type::Password) {
+    validation.lengthInWords = recipeObj.lengthInWords;
+    validation.lengthInBits = recipeObj.lengthInBits;
+  }
+  validation.recipeWithAllOptionalParametersSpecified =
+    recipeObj.recipeWithAllOptionalParametersSpecified();
+  return validation;
+}
+
+std::vector<RecipeValidation> validateRecipes(
+  const std::vector<std::string>& recipes,
+  const RecipeJson::type typeRequired,
+  const size_t threadCount
+) {
+  std::vector<RecipeValidation> validations(recipes.size());
+  parallelFor(recipes.size(), [&](const size_t index) {
+    validations[index] = validateRecipe(recipes[index], typeRequired);
+  }, threadCount);
+  return validations;
+}
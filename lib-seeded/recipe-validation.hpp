@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "recipe.hpp"
+
+/**
+ * @brief The outcome of validating a recipe with validateRecipe or
+ * validateRecipes: the error the Recipe constructor would throw,
+ * or a summary of the valid recipe.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct RecipeValidation {
+  /**
+   * @brief Why the recipe is invalid, or an error with code
+   * SeededErrorCode::None if it is valid
+   */
+  SeededError error = {SeededErrorCode::None, NULL};
+
+  /**
+   * @brief The recipe's type (or the type required of it), if valid
+   */
+  RecipeJson::type type = RecipeJson::type::_INVALID_TYPE_;
+  /**
+   * @brief The recipe's algorithm, if valid and it has one
+   */
+  RecipeJson::Algorithm algorithm = RecipeJson::Algorithm::_INVALID_ALGORITHM_;
+  /**
+   * @brief The recipe's hash function, if valid
+   */
+  RecipeJson::HashFunction hashFunction = RecipeJson::HashFunction::_INVALID_HASHFUNCTION_;
+  /**
+   * @brief The length of the secret the recipe derives, if valid
+   */
+  unsigned int lengthInBytes = 0;
+  /**
+   * @brief The number of words in the password, for valid Password recipes
+   */
+  unsigned int lengthInWords = 0;
+  /**
+   * @brief The bits of entropy in the password, for valid Password recipes
+   */
+  unsigned int lengthInBits = 0;
+  /**
+   * @brief The canonical form of the recipe from
+   * Recipe::recipeWithAllOptionalParametersSpecified, if valid
+   */
+  std::string recipeWithAllOptionalParametersSpecified;
+
+  /**
+   * @brief True if the recipe is valid
+   */
+  bool ok() const {
+    return !error;
+  }
+};
+
+/**
+ * @brief Validate a recipe by the rules of the Recipe constructor,
+ * without throwing.
+ *
+ * @param recipe The JSON formatted recipe object to validate
+ * as specified by @ref recipe_format
+ * @param typeRequired As for the Recipe constructor
+ *
+ * @ingroup BuildingBlocks
+ */
+RecipeValidation validateRecipe(
+  const std::string& recipe,
+  const RecipeJson::type typeRequired = RecipeJson::type::_INVALID_TYPE_
+);
+
+/**
+ * @brief Validate a batch of recipes across threads.
+ *
+ * Equivalent to calling validateRecipe on each recipe, with the
+ * results in the same order as the recipes.
+ *
+ * @param recipes The recipes to validate
+ * @param typeRequired As for the Recipe constructor
+ * @param threadCount The maximum number of threads to use,
+ * or 0 for one per hardware thread
+ *
+ * @ingroup BuildingBlocks
+ */
+std::vector<RecipeValidation> validateRecipes(
+  const std::vector<std::string>& recipes,
+  const RecipeJson::type typeRequired = RecipeJson::type::_INVALID_TYPE_,
+  const size_t threadCount = 0
+);
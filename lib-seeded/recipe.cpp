@@ -9,61 +9,118 @@
 #include "recipe.hpp"
 #include "exceptions.hpp"
 #include "word-lists.hpp"
+#include "recipe-sax-parser.hpp"
 
 extern "C" {
 #include "../extern/libsodium/src/libsodium/crypto_pwhash/argon2/argon2.h"
 }
 
-// Wrap json parser in a function that throws exceptions as
-// InvalidRecipeJsonException
-nlohmann::json parseJsonWithKeyDerviationOptionsExceptions(std::string json) {
-  try {
-    return nlohmann::json::parse(json);
-  } catch (nlohmann::json::exception e) {
-    throw InvalidRecipeJsonException(e.what());
-  } catch (...) {
-    throw InvalidRecipeJsonException();
-  }
+namespace RecipeErrors {
+  static const SeededError invalidJson = {
+    SeededErrorCode::InvalidRecipeJson, "Invalid JSON key recipe"
+  };
+  static const SeededError notAnObject = {
+    SeededErrorCode::InvalidRecipeJson, "Recipe must be a JSON object"
+  };
+  static const SeededError invalidValueType = {
+    SeededErrorCode::InvalidRecipeValue, "Recipe field has a value of the wrong type"
+  };
+  static const SeededError unexpectedType = {
+    SeededErrorCode::InvalidRecipeValue, "Unexpected type in Recipe"
+  };
+  static const SeededError invalidSymmetricAlgorithm = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid algorithm type for symmetric key cryptography"
+  };
+  static const SeededError invalidPublicKeyAlgorithm = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid algorithm type for public key cryptography"
+  };
+  static const SeededError invalidSigningAlgorithm = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid algorithm type for signing key"
+  };
+  static const SeededError lengthConflict = {
+    SeededErrorCode::InvalidRecipeValue, "lengthInBits and lengthInWords conflict"
+  };
+  static const SeededError invalidX25519Length = {
+    SeededErrorCode::InvalidRecipeValue, "X25519 public key cryptography must use lengthInBytes of 32"
+  };
+  static const SeededError invalidEd25519Length = {
+    SeededErrorCode::InvalidRecipeValue, "Ed25519 signing must use lengthInBytes of 32"
+  };
+  static const SeededError invalidXSalsa20Poly1305Length = {
+    SeededErrorCode::InvalidRecipeValue, "XSalsa20Poly1305 symmetric cryptography must use lengthInBytes of 32"
+  };
+  static const SeededError invalidNonceType = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid nonceType"
+  };
+  static const SeededError invalidAES256GCMLength = {
+    SeededErrorCode::InvalidRecipeValue, "AES256GCM symmetric cryptography must use lengthInBytes of 32"
+  };
+  static const SeededError invalidXChaCha20Poly1305Length = {
+    SeededErrorCode::InvalidRecipeValue, "XChaCha20Poly1305 symmetric cryptography must use lengthInBytes of 32"
+  };
+  static const SeededError invalidHashFunction = {
+    SeededErrorCode::InvalidArgument, "Invalid hashFunction"
+  };
 }
 
-
-// Use the nlohmann::json library to read the JSON-encoded
-// key generation options.
-// We make heavy use of the library's enum conversion, as documented at:
-//   https://github.com/nlohmann/json#specializing-enum-conversion
 Recipe::Recipe(
   const std::string& _recipe,
   const RecipeJson::type typeRequired
 ) : recipe(_recipe) {
-  const nlohmann::json& recipeObject = parseJsonWithKeyDerviationOptionsExceptions(
-    recipe.size() == 0 ? "{}" : recipe
-  );
+  const SeededError error = parse(typeRequired);
+  if (error) {
+    error.throwException();
+  }
+}
+
+Recipe::Recipe(
+  const std::string& _recipe,
+  const Unparsed
+) : recipe(_recipe) {}
+
+Result<Recipe> Recipe::tryParse(
+  const std::string& recipe,
+  const RecipeJson::type typeRequired
+) {
+  Result<Recipe> result(ResultInPlace(), recipe, Unparsed());
+  const SeededError error = result.value().parse(typeRequired);
+  if (error) {
+    result.fail(error);
+  }
+  return result;
+}
+
+// Read the JSON-encoded key generation options in a single pass
+// with RecipeSaxParser, which captures the fields we need without
+// building a DOM, and then apply defaults and validate them.
+const SeededError Recipe::parse(
+  const RecipeJson::type typeRequired
+) {
+  RecipeSaxParser recipeObject;
+  if (!recipeObject.parse(recipe.size() == 0 ? "{}" : recipe)) {
+    return RecipeErrors::invalidJson;
+  }
+  if (!recipeObject.isObject) {
+    return RecipeErrors::notAnObject;
+  }
   this->wordList = RecipeJson::WordList::_INVALID_WORD_LIST_;
 
   //
   // type
   //
-  type = recipeObject.value<RecipeJson::type>(
-      RecipeJson::FieldNames::type,
-      typeRequired
-    );
+  type = recipeObject.type.read(typeRequired);
 
   if (typeRequired != RecipeJson::type::_INVALID_TYPE_ &&
       type != typeRequired) {
     // We required type == typeRequired since typeRequired wasn't invalid,
     // but the JSON specified a different key type
-    throw InvalidRecipeValueException("Unexpected type in Recipe");
-  }
-
-  if (type != RecipeJson::type::_INVALID_TYPE_) {
-    recipeExplicit[RecipeJson::FieldNames::type] = type;
+    return RecipeErrors::unexpectedType;
   }
 
   //
   // algorithm
   //
-  algorithm = recipeObject.value<RecipeJson::Algorithm>(
-    RecipeJson::FieldNames::algorithm,
+  algorithm = recipeObject.algorithm.read(
     // Default value depends on the purpose
     (type == RecipeJson::type::SymmetricKey) ?
         // For symmetric crypto, default to XSalsa20Poly1305
@@ -80,76 +137,61 @@ Recipe::Recipe(
 
   // Validate that the key type is allowed for this type
   if (type == RecipeJson::type::SymmetricKey &&
-      algorithm != RecipeJson::Algorithm::XSalsa20Poly1305
+      algorithm != RecipeJson::Algorithm::XSalsa20Poly1305 &&
+      algorithm != RecipeJson::Algorithm::AES256GCM &&
+      algorithm != RecipeJson::Algorithm::XChaCha20Poly1305
   ) {
-    throw InvalidRecipeValueException(
-      "Invalid algorithm type for symmetric key cryptography"
-    );
+    return RecipeErrors::invalidSymmetricAlgorithm;
   }
 
   if (type == RecipeJson::type::UnsealingKey &&
     algorithm != RecipeJson::Algorithm::X25519
     ) {
-    throw InvalidRecipeValueException(
-      "Invalid algorithm type for public key cryptography"
-    );
+    return RecipeErrors::invalidPublicKeyAlgorithm;
   }
   if (type == RecipeJson::type::SigningKey &&
     algorithm != RecipeJson::Algorithm::Ed25519
     ) {
-    throw InvalidRecipeValueException(
-      "Invalid algorithm type for signing key"
-    );
-  }
-
-  if (type != RecipeJson::type::_INVALID_TYPE_) {
-    recipeExplicit[RecipeJson::FieldNames::type] = type;
-  }
-
-  if (algorithm != RecipeJson::Algorithm::_INVALID_ALGORITHM_) {
-    recipeExplicit[RecipeJson::FieldNames::algorithm] = algorithm;
+    return RecipeErrors::invalidSigningAlgorithm;
   }
 
   //
   // lengthInBytes
   //
-  lengthInBytes =
-    recipeObject.value<unsigned int>(
-      RecipeJson::FieldNames::lengthInBytes,
+  if (!recipeObject.lengthInBytes.read<unsigned int>(
       algorithm == RecipeJson::Algorithm::X25519 ?
         crypto_box_SEEDBYTES :
       algorithm == RecipeJson::Algorithm::XSalsa20Poly1305 ?
         // When a 256-bit (32 byte) key is needed, default to 32 bytes
         crypto_stream_xsalsa20_KEYBYTES :
         // When the key type is not defined, default to 32 bytes. 
-        32
-    );
+        32,
+      lengthInBytes
+  )) {
+    return RecipeErrors::invalidValueType;
+  }
 
   if (type == RecipeJson::type::Password) {
     // Determine the word list used to generate a password
-    wordList = recipeObject.value<RecipeJson::WordList>(
-      RecipeJson::FieldNames::wordList, RecipeJson::WordList::EN_512_words_5_chars_max_ed_4_20200917
+    wordList = recipeObject.wordList.read(
+      RecipeJson::WordList::EN_512_words_5_chars_max_ed_4_20200917
     );
     // Determine the bitsPerWord from the password;
     double bitsPerWord = log2(getWordList(wordList).size());
 
     // For password derivations, a length may be specified in bits of entropy
     // or in words.
-    lengthInBits = recipeObject.value<unsigned int>(
-        RecipeJson::FieldNames::lengthInBits, 0
-    );
-    lengthInWords = recipeObject.value<unsigned int>(
-      RecipeJson::FieldNames::lengthInWords, 0
-    );
-    lengthInChars = recipeObject.value<size_t>(
-      RecipeJson::FieldNames::lengthInChars, std::string::npos
-    );
+    if (
+      !recipeObject.lengthInBits.read<unsigned int>(0, lengthInBits) ||
+      !recipeObject.lengthInWords.read<unsigned int>(0, lengthInWords) ||
+      !recipeObject.lengthInChars.read<size_t>(std::string::npos, lengthInChars)
+    ) {
+      return RecipeErrors::invalidValueType;
+    }
     // If no length specified, derive a password with 128-bits of entropy
     // (if it's good enough for an AES block, it's good enough for a password).
     if (lengthInBits > 0 && lengthInWords > 0 && lengthInWords != (unsigned int)ceil(lengthInBits * bitsPerWord)) {
-      throw InvalidRecipeValueException( 
-        "lengthInBits and lengthInWords conflict"
-      );
+      return RecipeErrors::lengthConflict;
     } else if (lengthInBits == 0) {
       if (lengthInWords == 0) {
         lengthInBits = 128;
@@ -172,61 +214,86 @@ Recipe::Recipe(
     algorithm == RecipeJson::Algorithm::X25519
     && lengthInBytes != crypto_box_SEEDBYTES
   ) {
-    throw InvalidRecipeValueException( (
-        "X25519 public key cryptography must use lengthInBytes of " +
-        std::to_string(crypto_box_SEEDBYTES)
-      ).c_str() );
+    return RecipeErrors::invalidX25519Length;
   }
   if (
     algorithm == RecipeJson::Algorithm::Ed25519
     && lengthInBytes != crypto_sign_SEEDBYTES
     ) {
-    throw InvalidRecipeValueException((
-      "Ed25519 signing must use lengthInBytes of " +
-      std::to_string(crypto_sign_SEEDBYTES)
-      ).c_str());
+    return RecipeErrors::invalidEd25519Length;
   }
   if (
     algorithm == RecipeJson::Algorithm::XSalsa20Poly1305 &&
     lengthInBytes != crypto_stream_xsalsa20_KEYBYTES
   ) {
-    throw InvalidRecipeValueException( (
-        "XSalsa20Poly1305 symmetric cryptography must use lengthInBytes of " +
-        std::to_string(crypto_stream_xsalsa20_KEYBYTES)
-      ).c_str() );
+    return RecipeErrors::invalidXSalsa20Poly1305Length;
+  }
+  if (
+    algorithm == RecipeJson::Algorithm::AES256GCM &&
+    lengthInBytes != crypto_aead_aes256gcm_KEYBYTES
+  ) {
+    return RecipeErrors::invalidAES256GCMLength;
+  }
+  if (
+    algorithm == RecipeJson::Algorithm::XChaCha20Poly1305 &&
+    lengthInBytes != crypto_aead_xchacha20poly1305_ietf_KEYBYTES
+  ) {
+    return RecipeErrors::invalidXChaCha20Poly1305Length;
   }
 
-	if (type == RecipeJson::type::Secret) {
-		recipeExplicit[RecipeJson::FieldNames::lengthInBytes] = lengthInBytes;
-	}
+  if (type == RecipeJson::type::SymmetricKey) {
+    nonceType = recipeObject.nonceType.read(RecipeJson::NonceType::Synthetic);
+    if (nonceType == RecipeJson::NonceType::_INVALID_NONCE_TYPE_) {
+      return RecipeErrors::invalidNonceType;
+    }
+  }
 
-  hashFunction = recipeObject.value<RecipeJson::HashFunction>(
-      RecipeJson::FieldNames::hashFunction,
-      RecipeJson::HashFunction::BLAKE2b
-  );
+  hashFunction = recipeObject.hashFunction.read(RecipeJson::HashFunction::BLAKE2b);
   if (hashFunction != RecipeJson::HashFunction::BLAKE2b && hashFunction != RecipeJson::HashFunction::Argon2id) {
-    throw std::invalid_argument("Invalid hashFunction");
+    return RecipeErrors::invalidHashFunction;
   }
-  recipeExplicit[RecipeJson::FieldNames::hashFunction] = hashFunction;
-  hashFunctionMemoryPasses = recipeObject.value<size_t>(
-    RecipeJson::FieldNames::hashFunctionMemoryPasses,
-    (hashFunction == RecipeJson::HashFunction::Argon2id) ? 2 : 1
-  );
-  hashFunctionMemoryLimitInBytes = recipeObject.value<size_t>(
-    RecipeJson::FieldNames::hashFunctionMemoryLimitInBytes, 67108864U
-  );
-  if (hashFunction == RecipeJson::HashFunction::Argon2id) {
-    recipeExplicit[RecipeJson::FieldNames::hashFunctionMemoryLimitInBytes] = hashFunctionMemoryLimitInBytes;
-    recipeExplicit[RecipeJson::FieldNames::hashFunctionMemoryPasses] = hashFunctionMemoryPasses;
+  if (
+    !recipeObject.hashFunctionMemoryPasses.read<size_t>(
+      (hashFunction == RecipeJson::HashFunction::Argon2id) ? 2 : 1,
+      hashFunctionMemoryPasses
+    ) ||
+    !recipeObject.hashFunctionMemoryLimitInBytes.read<size_t>(
+      67108864U,
+      hashFunctionMemoryLimitInBytes
+    )
+  ) {
+    return RecipeErrors::invalidValueType;
   }
-
+  return {SeededErrorCode::None, NULL};
 }
 
 
+// Built from the parsed fields on each call, rather than stored in every
+// Recipe, as few callers need the explicit form.
 const std::string Recipe::recipeWithAllOptionalParametersSpecified(
   int indent,
   const char indent_char
 ) const {
+  nlohmann::json recipeExplicit = nlohmann::json::object();
+  if (type != RecipeJson::type::_INVALID_TYPE_) {
+    recipeExplicit[RecipeJson::FieldNames::type] = type;
+  }
+  if (algorithm != RecipeJson::Algorithm::_INVALID_ALGORITHM_) {
+    recipeExplicit[RecipeJson::FieldNames::algorithm] = algorithm;
+  }
+  if (type == RecipeJson::type::Secret) {
+    recipeExplicit[RecipeJson::FieldNames::lengthInBytes] = lengthInBytes;
+  }
+  // Only the non-default nonceType is written, so that recipes written
+  // before it existed keep the same explicit form
+  if (nonceType == RecipeJson::NonceType::Random) {
+    recipeExplicit[RecipeJson::FieldNames::nonceType] = nonceType;
+  }
+  recipeExplicit[RecipeJson::FieldNames::hashFunction] = hashFunction;
+  if (hashFunction == RecipeJson::HashFunction::Argon2id) {
+    recipeExplicit[RecipeJson::FieldNames::hashFunctionMemoryLimitInBytes] = hashFunctionMemoryLimitInBytes;
+    recipeExplicit[RecipeJson::FieldNames::hashFunctionMemoryPasses] = hashFunctionMemoryPasses;
+  }
   return recipeExplicit.dump(indent, indent_char);
 }
 
@@ -246,66 +313,80 @@ const SodiumBuffer Recipe::derivePrimarySecret(
 		 finalType == RecipeJson::type::SigningKey ? "SigningKey" :
      "";
 
-  // Create a hash preimage that is the seed string, followed by a null
-  // terminator, followed by the recipe string.
-  //   <seedString> + '\0' <recipe>
-  SodiumBuffer keyTypeAndRecipe(
-    // length of key type
-    typeString.length() +
-    // length of the json string specifying the recipe
-    recipe.length()
-  );
-
-  // Use this moving pointer to write the primage
-  unsigned char* writePtr = keyTypeAndRecipe.data;
-  // copy the key type
-  memcpy(
-    writePtr,
-    typeString.c_str(),
-    typeString.length()
-  );
-  writePtr += typeString.length();
-  // copy the key recipe into the preimage
-  memcpy(
-    writePtr,
-    recipe.c_str(),
-    recipe.length()
-  );
-
-
+  // Create a hash preimage that is the key type followed by the recipe string
+  //   <typeString> + <recipe>
+  // The preimage is public (it contains no part of the seed), so it
+  // needn't live in a SodiumBuffer.
+  std::string keyTypeAndRecipe;
+  keyTypeAndRecipe.reserve(typeString.length() + recipe.length());
+  keyTypeAndRecipe.append(typeString);
+  keyTypeAndRecipe.append(recipe);
 
   if (this->hashFunction == RecipeJson::HashFunction::Argon2id) {
-    if (this->lengthInBytes > crypto_pwhash_argon2id_BYTES_MAX ) {
-      throw std::invalid_argument("Invalid hash length");
-    }
-    SodiumBuffer hashOutput(std::max(crypto_pwhash_argon2id_BYTES_MIN, this->lengthInBytes));
-    const int hashSuccessOutcome = argon2id_hash_raw(
-      // opsLimit
-      (uint32_t) this->hashFunctionMemoryPasses,
-      // memLimit
-      (uint32_t) (this->hashFunctionMemoryLimitInBytes / 1024U),
-      // parallelism (same as default for libSodium: 1
-      (uint32_t) 1U,
-      // The password pointer/length are where we submit the seed and its length
-      seedString.c_str(), seedString.length(),
-      // We salt with the keyTypeAndRecipe
-      keyTypeAndRecipe.data, keyTypeAndRecipe.length,
-      // The output goes into result
-      hashOutput.data, hashOutput.length
+    return hashPreimageWithArgon2id(
+      seedString,
+      (const unsigned char*) keyTypeAndRecipe.data(), keyTypeAndRecipe.length(),
+      this->lengthInBytes,
+      this->hashFunctionMemoryPasses,
+      this->hashFunctionMemoryLimitInBytes
     );
-    if (hashSuccessOutcome != ARGON2_OK) {
-      throw std::bad_alloc();
-    }
-    if (hashOutput.length > this->lengthInBytes) {
-      SodiumBuffer trimmedHashOutput(this->lengthInBytes);
-      memcpy(trimmedHashOutput.data, hashOutput.data, trimmedHashOutput.length);
-      return trimmedHashOutput;
-    } else {
-      return hashOutput;
-    }
   } else {
-    // Blake2b
-    return hkdfBlake2b((unsigned char*) seedString.c_str(), seedString.length(), keyTypeAndRecipe, this->lengthInBytes);
+    return hashPreimageWithBlake2b(
+      seedString,
+      (const unsigned char*) keyTypeAndRecipe.data(), keyTypeAndRecipe.length(),
+      this->lengthInBytes
+    );
+  }
+}
+
+const SodiumBuffer Recipe::hashPreimageWithBlake2b(
+  const std::string& seedString,
+  const unsigned char* preimage,
+  const size_t preimageLength,
+  const size_t lengthInBytes
+) {
+  return hkdfBlake2b(
+    (const unsigned char*) seedString.c_str(), seedString.length(),
+    preimage, preimageLength,
+    lengthInBytes
+  );
+}
+
+const SodiumBuffer Recipe::hashPreimageWithArgon2id(
+  const std::string& seedString,
+  const unsigned char* preimage,
+  const size_t preimageLength,
+  const size_t lengthInBytes,
+  const size_t hashFunctionMemoryPasses,
+  const size_t hashFunctionMemoryLimitInBytes
+) {
+  if (lengthInBytes > crypto_pwhash_argon2id_BYTES_MAX ) {
+    throw std::invalid_argument("Invalid hash length");
+  }
+  SodiumBuffer hashOutput(std::max((size_t) crypto_pwhash_argon2id_BYTES_MIN, lengthInBytes));
+  const int hashSuccessOutcome = argon2id_hash_raw(
+    // opsLimit
+    (uint32_t) hashFunctionMemoryPasses,
+    // memLimit
+    (uint32_t) (hashFunctionMemoryLimitInBytes / 1024U),
+    // parallelism (same as default for libSodium: 1
+    (uint32_t) 1U,
+    // The password pointer/length are where we submit the seed and its length
+    seedString.c_str(), seedString.length(),
+    // We salt with the keyTypeAndRecipe
+    preimage, preimageLength,
+    // The output goes into result
+    hashOutput.data, hashOutput.length
+  );
+  if (hashSuccessOutcome != ARGON2_OK) {
+    throw std::bad_alloc();
+  }
+  if (hashOutput.length > lengthInBytes) {
+    SodiumBuffer trimmedHashOutput(lengthInBytes);
+    memcpy(trimmedHashOutput.data, hashOutput.data, trimmedHashOutput.length);
+    return trimmedHashOutput;
+  } else {
+    return hashOutput;
   }
 }
 
@@ -6,7 +6,8 @@
 #include "github-com-nlohmann-json/json.hpp"
 // Must come after json.hpp
 #include "./externally-generated/derivation-parameters.hpp"
-#include "recipe.hpp"
+#include "result.hpp"
+#include "sodium-buffer.hpp"
 
 const size_t BytesPerWordOfPassword = 8;
 
@@ -27,7 +28,20 @@ class Recipe {
  */
 
 private:
-	nlohmann::json recipeExplicit;
+	struct Unparsed {};
+	friend class Result<Recipe>;
+
+	/**
+	 * Construct without parsing, for tryParse to then call parse.
+	 */
+	Recipe(const std::string& recipe, const Unparsed);
+
+	/**
+	 * Parse the recipe into the fields of this object, returning the error
+	 * the constructor should throw (SeededErrorCode::None if valid).
+	 */
+	const SeededError parse(const RecipeJson::type typeRequired);
+
 public:
 	/**
 	 * @brief Mirroring the JSON field in @ref derivation_options_universal_fields "Recipe JSON Universal Fields"
@@ -77,6 +91,16 @@ public:
 	 */
 	RecipeJson::HashFunction hashFunction;
 
+	/**
+	 * @brief How a SymmetricKey generates the nonce for each message it seals:
+	 * Synthetic (the default) derives it from the key, message, and
+	 * unsealingInstructions, so sealing is deterministic, whereas Random
+	 * generates it randomly so that sealing and unsealing each take a single
+	 * pass over the message.
+	 * RecipeJson::NonceType::_INVALID_NONCE_TYPE_ for types other than SymmetricKey.
+	 */
+	RecipeJson::NonceType nonceType = RecipeJson::NonceType::_INVALID_NONCE_TYPE_;
+
 	/**
 	 * Create a Recipe class from the JSON representation
 	 * of the key generation options.
@@ -97,9 +121,28 @@ public:
 			RecipeJson::type::_INVALID_TYPE_
 	);
 
+	/**
+	 * Parse a recipe without throwing, for input-validation paths in which
+	 * invalid recipes are common.
+	 * 
+	 * @param recipe The JSON formatted recipe object to parse
+	 * as specified by @ref recipe_format
+	 * @param typeRequired As for the constructor.
+	 * @return Result<Recipe> The parsed recipe, or the error the
+	 * constructor would have thrown.
+	 **/
+	static Result<Recipe> tryParse(
+		const std::string& recipe,
+		const RecipeJson::type typeRequired =
+			RecipeJson::type::_INVALID_TYPE_
+	);
+
 	/**
 	 * @brief Return JSON with default parameters filled in.
 	 *
+	 * The JSON is generated from this object's fields on each call,
+	 * so callers that need it repeatedly should keep the result.
+	 *
 	 * @param indent JSON indent depth
 	 * @param indent_char The char used for JSON indenting
 	 */
@@ -198,4 +241,44 @@ public:
 			RecipeJson::type::_INVALID_TYPE_
 	) const;
 
+	/**
+	 * @brief Apply the BLAKE2b-based HKDF used by derivePrimarySecret
+	 * to an already-constructed preimage (`<typeString> + <recipe>`).
+	 *
+	 * Exposed so that SpecializedRecipe can derive secrets identical to
+	 * those of derivePrimarySecret without re-parsing the recipe.
+	 *
+	 * @param seedString The seed (the HKDF input keying material)
+	 * @param preimage The key type string followed by the recipe string
+	 * @param preimageLength The length of the preimage in bytes
+	 * @param lengthInBytes The length of the secret to derive
+	 */
+	static const SodiumBuffer hashPreimageWithBlake2b(
+		const std::string& seedString,
+		const unsigned char* preimage,
+		const size_t preimageLength,
+		const size_t lengthInBytes
+	);
+
+	/**
+	 * @brief Apply Argon2id, as used by derivePrimarySecret, to
+	 * an already-constructed preimage (`<typeString> + <recipe>`),
+	 * which serves as the salt.
+	 *
+	 * @param seedString The seed (the Argon2id password)
+	 * @param preimage The key type string followed by the recipe string
+	 * @param preimageLength The length of the preimage in bytes
+	 * @param lengthInBytes The length of the secret to derive
+	 * @param hashFunctionMemoryPasses The Argon2id opslimit
+	 * @param hashFunctionMemoryLimitInBytes The Argon2id memory limit
+	 */
+	static const SodiumBuffer hashPreimageWithArgon2id(
+		const std::string& seedString,
+		const unsigned char* preimage,
+		const size_t preimageLength,
+		const size_t lengthInBytes,
+		const size_t hashFunctionMemoryPasses,
+		const size_t hashFunctionMemoryLimitInBytes
+	);
+
 };
@@ -0,0 +1,27 @@
+#include <stdexcept>
+#include "result.hpp"
+#include "exceptions.hpp"
+#include "convert.hpp"
+
+void SeededError::throwException() const {
+  switch (code) {
+    case SeededErrorCode::CryptographicVerificationFailure:
+      throw CryptographicVerificationFailureException(message);
+    case SeededErrorCode::KeyLength:
+      throw KeyLengthException(message);
+    case SeededErrorCode::JsonParsing:
+      throw JsonParsingException(message);
+    case SeededErrorCode::InvalidRecipeJson:
+      throw InvalidRecipeJsonException(message);
+    case SeededErrorCode::InvalidRecipeValue:
+      throw InvalidRecipeValueException(message);
+    case SeededErrorCode::InvalidHexCharacter:
+      throw InvalidHexCharacterException(message);
+    case SeededErrorCode::AlgorithmUnavailable:
+      throw AlgorithmUnavailableException(message);
+    case SeededErrorCode::InvalidArgument:
+    case SeededErrorCode::None:
+    default:
+      throw std::invalid_argument(message ? message : "Invalid argument");
+  }
+}
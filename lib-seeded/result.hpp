@@ -0,0 +1,195 @@
+#pragma once
+
+#include <new>
+#include <utility>
+
+/**
+ * @brief Identifies a failure reported by one of the non-throwing
+ * `try*` methods. Each code corresponds to the exception the
+ * throwing form of the same method throws.
+ *
+ * @ingroup BuildingBlocks
+ */
+enum class SeededErrorCode {
+  /** No error */
+  None = 0,
+  /** Corresponds to std::invalid_argument */
+  InvalidArgument,
+  /** Corresponds to CryptographicVerificationFailureException */
+  CryptographicVerificationFailure,
+  /** Corresponds to KeyLengthException */
+  KeyLength,
+  /** Corresponds to JsonParsingException */
+  JsonParsing,
+  /** Corresponds to InvalidRecipeJsonException */
+  InvalidRecipeJson,
+  /** Corresponds to InvalidRecipeValueException */
+  InvalidRecipeValue,
+  /** Corresponds to InvalidHexCharacterException */
+  InvalidHexCharacter,
+  /** Corresponds to AlgorithmUnavailableException */
+  AlgorithmUnavailable
+};
+
+/**
+ * @brief The failure reported by a `try*` method: an error code
+ * and a message.
+ *
+ * The message is always a string literal, so reporting a failure
+ * never allocates.
+ *
+ * @ingroup BuildingBlocks
+ */
+struct SeededError {
+  /**
+   * @brief The kind of failure, or SeededErrorCode::None
+   */
+  SeededErrorCode code;
+  /**
+   * @brief A static description of the failure (the message
+   * the corresponding exception is thrown with)
+   */
+  const char* message;
+
+  /**
+   * @brief True if this represents a failure
+   */
+  explicit operator bool() const {
+    return code != SeededErrorCode::None;
+  }
+
+  /**
+   * @brief Throw the exception that corresponds to this error's code,
+   * with this error's message.
+   */
+  [[noreturn]] void throwException() const;
+};
+
+/**
+ * @brief Tag used to construct a Result's value in place
+ */
+struct ResultInPlace {};
+
+/**
+ * @brief The outcome of a non-throwing `try*` method: either a value
+ * or a SeededError.
+ *
+ * The value is stored inside the Result and is only constructed on
+ * success, so a failure costs neither an exception nor an allocation.
+ *
+ * ```cpp
+ * const Result<SodiumBuffer> plaintext = key.tryUnseal(packagedSealedMessage);
+ * if (!plaintext) {
+ *   // plaintext.error().code explains why
+ * }
+ * ```
+ *
+ * @tparam T The type of the value returned on success
+ *
+ * @ingroup BuildingBlocks
+ */
+template <typename T>
+class Result {
+  SeededError resultError;
+  union {
+    T resultValue;
+  };
+
+public:
+  /**
+   * @brief Construct a failed result
+   *
+   * @param error The failure, which must not have code SeededErrorCode::None
+   */
+  Result(const SeededError& error) : resultError(error) {}
+
+  /**
+   * @brief Construct a successful result, passing the arguments
+   * to the value's constructor
+   */
+  template <typename... Args>
+  explicit Result(ResultInPlace, Args&&... args) :
+    resultError{SeededErrorCode::None, nullptr}
+  {
+    new (&resultValue) T(std::forward<Args>(args)...);
+  }
+
+  Result(const Result& other) : resultError(other.resultError) {
+    if (ok()) {
+      new (&resultValue) T(other.resultValue);
+    }
+  }
+
+  Result(Result&& other) : resultError(other.resultError) {
+    if (ok()) {
+      new (&resultValue) T(std::move(other.resultValue));
+    }
+  }
+
+  Result& operator=(const Result&) = delete;
+
+  ~Result() {
+    if (ok()) {
+      resultValue.~T();
+    }
+  }
+
+  /**
+   * @brief True if the operation succeeded and value() may be called
+   */
+  bool ok() const {
+    return resultError.code == SeededErrorCode::None;
+  }
+
+  /**
+   * @brief True if the operation succeeded and value() may be called
+   */
+  explicit operator bool() const {
+    return ok();
+  }
+
+  /**
+   * @brief The failure, or an error with code SeededErrorCode::None on success
+   */
+  const SeededError& error() const {
+    return resultError;
+  }
+
+  /**
+   * @brief The value, which must only be accessed if ok()
+   */
+  T& value() {
+    return resultValue;
+  }
+
+  /**
+   * @brief The value, which must only be accessed if ok()
+   */
+  const T& value() const {
+    return resultValue;
+  }
+
+  /**
+   * @brief Take the value, or throw the exception corresponding
+   * to the error.  This is how the throwing APIs wrap the `try*` APIs.
+   */
+  T valueOrThrow() && {
+    if (!ok()) {
+      resultError.throwException();
+    }
+    return std::move(resultValue);
+  }
+
+  /**
+   * @brief Replace a successful result with a failure,
+   * destroying the value.
+   *
+   * @param error The failure, which must not have code SeededErrorCode::None
+   */
+  void fail(const SeededError& error) {
+    if (ok()) {
+      resultValue.~T();
+    }
+    resultError = error;
+  }
+};
@@ -0,0 +1,83 @@
+#include <cstring>
+#include <stdexcept>
+#include "sealed-file.hpp"
+
+static const size_t lengthFieldBytes = 4;
+
+static unsigned char* writeLengthField(unsigned char* writePtr, const size_t length) {
+  *(writePtr++) = (length >> 24) & 0xff;
+  *(writePtr++) = (length >> 16) & 0xff;
+  *(writePtr++) = (length >> 8) & 0xff;
+  *(writePtr++) = (length) & 0xff;
+  return writePtr;
+}
+
+static size_t readLengthField(const unsigned char* readPtr) {
+  return
+    (size_t(*(readPtr)) << 24) +
+    (size_t(*(readPtr + 1)) << 16) +
+    (size_t(*(readPtr + 2)) << 8) +
+    (size_t(*(readPtr + 3)));
+}
+
+size_t SealedFile::length(
+  const size_t ciphertextLength,
+  const std::string& recipe,
+  const std::string& unsealingInstructions
+) {
+  if (ciphertextLength > (size_t)0xffffffff || recipe.length() > (size_t)0xffffffff) {
+    throw std::invalid_argument("Cannot serialize buffers of size >= 4GB");
+  }
+  return lengthFieldBytes + ciphertextLength + lengthFieldBytes + recipe.length() + unsealingInstructions.length();
+}
+
+unsigned char* SealedFile::writeAllButCiphertext(
+  MappedFile& file,
+  const size_t ciphertextLength,
+  const std::string& recipe,
+  const std::string& unsealingInstructions
+) {
+  unsigned char* ciphertext = writeLengthField(file.data(), ciphertextLength);
+  unsigned char* writePtr = writeLengthField(ciphertext + ciphertextLength, recipe.length());
+  memcpy(writePtr, recipe.data(), recipe.length());
+  memcpy(writePtr + recipe.length(), unsealingInstructions.data(), unsealingInstructions.length());
+  return ciphertext;
+}
+
+SealedFile::Contents SealedFile::read(const MappedFile& file) {
+  const unsigned char* readPtr = file.data();
+  size_t bytesRemaining = file.length();
+  Contents contents;
+  if (bytesRemaining < lengthFieldBytes) {
+    throw std::invalid_argument("Not enough bytes in buffer for field length");
+  }
+  contents.ciphertextLength = readLengthField(readPtr);
+  readPtr += lengthFieldBytes;
+  bytesRemaining -= lengthFieldBytes;
+  if (contents.ciphertextLength > bytesRemaining) {
+    throw std::invalid_argument("Field length is longer than remaining bytes in buffer");
+  }
+  contents.ciphertext = readPtr;
+  readPtr += contents.ciphertextLength;
+  bytesRemaining -= contents.ciphertextLength;
+  if (bytesRemaining < lengthFieldBytes) {
+    throw std::invalid_argument("Not enough bytes in buffer for field length");
+  }
+  const size_t recipeLength = readLengthField(readPtr);
+  readPtr += lengthFieldBytes;
+  bytesRemaining -= lengthFieldBytes;
+  if (recipeLength > bytesRemaining) {
+    throw std::invalid_argument("Field length is longer than remaining bytes in buffer");
+  }
+  contents.recipe = std::string((const char*) readPtr, recipeLength);
+  contents.unsealingInstructions = std::string((const char*) readPtr + recipeLength, bytesRemaining - recipeLength);
+  return contents;
+}
+
+MappedFile SealedFile::openInput(const std::string& inputPath, const std::string& outputPath) {
+  MappedFile input(inputPath);
+  if (input.refersTo(outputPath)) {
+    throw std::invalid_argument("The output file must not be the input file");
+  }
+  return input;
+}
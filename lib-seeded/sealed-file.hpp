@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include "mapped-file.hpp"
+
+/**
+ * @brief The layout of the files written by the keys' sealFile methods,
+ * which hold a PackagedSealedMessage in its serialized binary form
+ * (see PackagedSealedMessage::toSerializedBinaryForm):
+ * ```
+ *   <ciphertext length: 4 bytes, big endian> <ciphertext>
+ *   <recipe length: 4 bytes, big endian> <recipe> <unsealingInstructions>
+ * ```
+ * So a sealed file can also be read with
+ * PackagedSealedMessage::fromSerializedBinaryForm, and a serialized
+ * PackagedSealedMessage saved to a file can be unsealed with unsealFile.
+ * Since the length fields are 4 bytes, ciphertexts must be shorter than 4GB.
+ *
+ * @ingroup BuildingBlocks
+ */
+namespace SealedFile {
+  /**
+   * @brief The length of a sealed file containing a ciphertext of the
+   * given length, the recipe, and the unsealingInstructions
+   *
+   * @exception std::invalid_argument Thrown if the ciphertext or recipe
+   * is 4GB or longer.
+   */
+  size_t length(
+    const size_t ciphertextLength,
+    const std::string& recipe,
+    const std::string& unsealingInstructions
+  );
+
+  /**
+   * @brief Write everything but the ciphertext into a file of
+   * length(ciphertextLength, recipe, unsealingInstructions) bytes,
+   * returning where the ciphertext must be written.
+   */
+  unsigned char* writeAllButCiphertext(
+    MappedFile& file,
+    const size_t ciphertextLength,
+    const std::string& recipe,
+    const std::string& unsealingInstructions
+  );
+
+  /**
+   * @brief The parts of a sealed file. The ciphertext points into the
+   * file's mapping rather than being copied out of it.
+   */
+  struct Contents {
+    const unsigned char* ciphertext;
+    size_t ciphertextLength;
+    std::string recipe;
+    std::string unsealingInstructions;
+  };
+
+  /**
+   * @brief Find the parts of a sealed file
+   *
+   * @exception std::invalid_argument Thrown if the length fields
+   * don't fit within the file.
+   */
+  Contents read(const MappedFile& file);
+
+  /**
+   * @brief Open inputPath for reading, refusing if outputPath would
+   * overwrite it.
+   *
+   * @exception std::invalid_argument Thrown if outputPath names the input file.
+   */
+  MappedFile openInput(const std::string& inputPath, const std::string& outputPath);
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "sealing-key-stream.hpp"
+#include "exceptions.hpp"
+
+// The context that separates stream keys from other values
+// derived from an X25519 shared key
+static const char streamKeyContext[] = "SealingKeyStream";
+
+// The SymmetricKey a stream is sealed with, derived from the X25519
+// shared key (crypto_box_beforenm) and salted with the unsealingInstructions
+static SymmetricKey deriveStreamKey(
+  const unsigned char* sharedKey,
+  const unsigned char* ephemeralPublicKey,
+  const unsigned char* recipientPublicKey,
+  const std::string& unsealingInstructions
+) {
+  SodiumBuffer keyBytes(crypto_secretbox_KEYBYTES);
+  crypto_generichash_state st;
+  crypto_generichash_init(&st, sharedKey, crypto_box_BEFORENMBYTES, keyBytes.length);
+  crypto_generichash_update(&st, (const unsigned char*) streamKeyContext, sizeof streamKeyContext - 1);
+  crypto_generichash_update(&st, ephemeralPublicKey, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, recipientPublicKey, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length());
+  crypto_generichash_final(&st, keyBytes.data, keyBytes.length);
+  sodium_memzero(&st, sizeof st);
+  return SymmetricKey(keyBytes, "");
+}
+
+/////
+//  SealingKeyStreamSealer
+////
+
+SealingKeyStreamSealer::SealingKeyStreamSealer(
+  const SealingKey& key,
+  const std::string& unsealingInstructions,
+  const SymmetricKeyStreamOutput& _output,
+  const size_t chunkSize
+) : output(_output) {
+  unsigned char ephemeralSecretKey[crypto_box_SECRETKEYBYTES];
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  crypto_box_keypair(ephemeralPublicKey, ephemeralSecretKey);
+  const int result = crypto_box_beforenm(sharedKey, key.sealingKeyBytes.data(), ephemeralSecretKey);
+  sodium_memzero(ephemeralSecretKey, sizeof ephemeralSecretKey);
+  if (result != 0) {
+    sodium_memzero(sharedKey, sizeof sharedKey);
+    throw std::invalid_argument("Invalid key");
+  }
+  const SymmetricKey streamKey = deriveStreamKey(
+    sharedKey, ephemeralPublicKey, key.sealingKeyBytes.data(), unsealingInstructions
+  );
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  sealer.reset(new SymmetricKeyStreamSealer(streamKey, unsealingInstructions, output, chunkSize));
+}
+
+void SealingKeyStreamSealer::init() {
+  if (initialized) {
+    throw std::logic_error("Stream already started");
+  }
+  initialized = true;
+  output(ephemeralPublicKey, sizeof ephemeralPublicKey);
+  sealer->init();
+}
+
+void SealingKeyStreamSealer::update(
+  const unsigned char* plaintext,
+  const size_t length
+) {
+  sealer->update(plaintext, length);
+}
+
+void SealingKeyStreamSealer::final() {
+  sealer->final();
+}
+
+/////
+//  UnsealingKeyStreamUnsealer
+////
+
+UnsealingKeyStreamUnsealer::UnsealingKeyStreamUnsealer(
+  const UnsealingKey& key,
+  const std::string& _unsealingInstructions,
+  const SymmetricKeyStreamOutput& _output
+) :
+  sealingKeyBytes(key.sealingKeyBytes),
+  unsealingKeyBytes(key.unsealingKeyBytes),
+  unsealingInstructions(_unsealingInstructions),
+  output(_output)
+{}
+
+void UnsealingKeyStreamUnsealer::fail() {
+  throw CryptographicVerificationFailureException(
+    "Public/Private stream unseal failed: the private key doesn't match the public key used to seal the stream, the unsealing instructions do not match those used to seal the stream, or the stream was modified/corrupted/truncated."
+  );
+}
+
+void UnsealingKeyStreamUnsealer::update(
+  const unsigned char* ciphertext,
+  const size_t length
+) {
+  size_t offset = 0;
+  if (!unsealer) {
+    const size_t toCopy = std::min(length, sizeof ephemeralPublicKey - ephemeralPublicKeyLength);
+    memcpy(ephemeralPublicKey + ephemeralPublicKeyLength, ciphertext, toCopy);
+    ephemeralPublicKeyLength += toCopy;
+    offset += toCopy;
+    if (ephemeralPublicKeyLength < sizeof ephemeralPublicKey) {
+      return;
+    }
+    unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+    if (crypto_box_beforenm(sharedKey, ephemeralPublicKey, unsealingKeyBytes.data) != 0) {
+      sodium_memzero(sharedKey, sizeof sharedKey);
+      fail();
+    }
+    const SymmetricKey streamKey = deriveStreamKey(
+      sharedKey, ephemeralPublicKey, sealingKeyBytes.data(), unsealingInstructions
+    );
+    sodium_memzero(sharedKey, sizeof sharedKey);
+    unsealer.reset(new SymmetricKeyStreamUnsealer(streamKey, unsealingInstructions, output));
+  }
+  if (offset < length) {
+    unsealer->update(ciphertext + offset, length - offset);
+  }
+}
+
+void UnsealingKeyStreamUnsealer::final() {
+  if (!unsealer) {
+    fail();
+  }
+  unsealer->final();
+}
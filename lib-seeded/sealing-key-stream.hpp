@@ -0,0 +1,166 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "symmetric-key-stream.hpp"
+#include "sealing-key.hpp"
+#include "unsealing-key.hpp"
+
+/**
+ * @brief Constants of the public-key stream format shared
+ * by SealingKeyStreamSealer and UnsealingKeyStreamUnsealer.
+ *
+ * A sealed stream is an ephemeral X25519 public key followed by a
+ * SymmetricKey stream (see SymmetricKeyStream):
+ * ```
+ *   <ephemeral public key: 32 bytes> <SymmetricKey stream>
+ * ```
+ * The SymmetricKey that seals the stream is derived from the X25519
+ * exchange between the ephemeral key and the recipient's key, salted
+ * with the unsealingInstructions:
+ * ```
+ *   BLAKE2b(key: crypto_box_beforenm(...),
+ *     message: "SealingKeyStream" <ephemeral public key> <recipient public key> <unsealingInstructions>)
+ * ```
+ *
+ * @ingroup DerivedFromSeeds
+ */
+namespace SealingKeyStream {
+  /**
+   * @brief The length of the stream header
+   */
+  const size_t HeaderBytes = crypto_box_PUBLICKEYBYTES + SymmetricKeyStream::HeaderBytes;
+  /**
+   * @brief The length of a sealed stream of a given plaintext length
+   */
+  inline size_t sealedLength(const size_t plaintextLength, const size_t chunkSize = SymmetricKeyStream::DefaultChunkSize) {
+    return crypto_box_PUBLICKEYBYTES + SymmetricKeyStream::sealedLength(plaintextLength, chunkSize);
+  }
+}
+
+/**
+ * @brief Seals a message of any length, incrementally and in constant memory,
+ * so that only the holder of an UnsealingKey can unseal it.
+ *
+ * Used just like SymmetricKeyStreamSealer: call init, then update with
+ * each part of the plaintext, then final. The sealed stream is passed to
+ * the output function as it is produced.
+ *
+ * Streams are unsealed with UnsealingKeyStreamUnsealer. Their format
+ * (see SealingKeyStream) differs from that of SealingKey::seal.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class SealingKeyStreamSealer {
+  unsigned char ephemeralPublicKey[crypto_box_PUBLICKEYBYTES];
+  const SymmetricKeyStreamOutput output;
+  std::unique_ptr<SymmetricKeyStreamSealer> sealer;
+  bool initialized = false;
+
+public:
+  /**
+   * @brief Prepare to seal a stream
+   *
+   * @param key The key of the recipient who will unseal the stream
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the stream.
+   * @param output The function to pass the sealed stream to
+   * @param chunkSize The length of plaintext sealed in each chunk
+   * @throws std::invalid_argument if the chunk size is 0 or
+   * greater than SymmetricKeyStream::MaxChunkSize
+   */
+  SealingKeyStreamSealer(
+    const SealingKey& key,
+    const std::string& unsealingInstructions,
+    const SymmetricKeyStreamOutput& output,
+    const size_t chunkSize = SymmetricKeyStream::DefaultChunkSize
+  );
+
+  SealingKeyStreamSealer(const SealingKeyStreamSealer&) = delete;
+  SealingKeyStreamSealer& operator=(const SealingKeyStreamSealer&) = delete;
+
+  /**
+   * @brief Start the stream, writing its header to the output
+   *
+   * @throws std::logic_error if the stream has already been started
+   */
+  void init();
+
+  /**
+   * @brief Seal the next part of the plaintext, writing each chunk
+   * to the output as it fills.
+   *
+   * @throws std::logic_error if called before init or after final
+   */
+  void update(const unsigned char* plaintext, const size_t length);
+
+  /**
+   * @brief Seal the rest of the plaintext as the final chunk and
+   * write it to the output.
+   *
+   * @throws std::logic_error if called before init or after final
+   */
+  void final();
+};
+
+/**
+ * @brief Unseals a stream sealed by SealingKeyStreamSealer,
+ * incrementally and in constant memory.
+ *
+ * Used just like SymmetricKeyStreamUnsealer, and with the same caveat:
+ * a stream that was cut short is only detected by final, so don't act
+ * on the plaintext until final has returned.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class UnsealingKeyStreamUnsealer {
+  const std::vector<unsigned char> sealingKeyBytes;
+  const SodiumBuffer unsealingKeyBytes;
+  const std::string unsealingInstructions;
+  const SymmetricKeyStreamOutput output;
+  unsigned char ephemeralPublicKey[crypto_box_PUBLICKEYBYTES];
+  size_t ephemeralPublicKeyLength = 0;
+  std::unique_ptr<SymmetricKeyStreamUnsealer> unsealer;
+
+  [[noreturn]] void fail();
+
+public:
+  /**
+   * @brief Prepare to unseal a stream
+   *
+   * @param key The key the stream was sealed for
+   * @param unsealingInstructions The unsealingInstructions the stream
+   * was sealed with, if any.
+   * @param output The function to pass the plaintext to
+   */
+  UnsealingKeyStreamUnsealer(
+    const UnsealingKey& key,
+    const std::string& unsealingInstructions,
+    const SymmetricKeyStreamOutput& output
+  );
+
+  UnsealingKeyStreamUnsealer(const UnsealingKeyStreamUnsealer&) = delete;
+  UnsealingKeyStreamUnsealer& operator=(const UnsealingKeyStreamUnsealer&) = delete;
+
+  /**
+   * @brief Unseal the next part of the sealed stream, writing the
+   * plaintext of each chunk to the output once it is authenticated.
+   *
+   * @throws CryptographicVerificationFailureException if the stream
+   * is not authentic, was sealed for a different key or with different
+   * unsealingInstructions, or continues past its final chunk
+   */
+  void update(const unsigned char* ciphertext, const size_t length);
+
+  /**
+   * @brief Finish unsealing the stream, writing the plaintext
+   * of its final chunk to the output.
+   *
+   * @throws CryptographicVerificationFailureException if the stream
+   * is not authentic or was truncated
+   */
+  void final();
+};
@@ -1,3 +1,4 @@
+#include <utility>
 #include "github-com-nlohmann-json/json.hpp"
 #include "sealing-key.hpp"
 #include "crypto_box_seal_salted.h"
@@ -5,6 +6,8 @@
 #include "lib-seeded.hpp"
 #include "exceptions.hpp"
 #include "common-names.hpp"
+#include "json-fields.hpp"
+#include "sealed-file.hpp"
 
 namespace SealingKeyJsonFieldName {
   const std::string keyBytes = "keyBytes";
@@ -20,16 +23,29 @@ SealingKey::SealingKey(
     }
   }
 
-SealingKey SealingKey::fromJson(const std::string& sealingKeyAsJson) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(sealingKeyAsJson);
-    return SealingKey(
-      hexStrToByteVector(jsonObject.at(SealingKeyJsonFieldName::keyBytes)),
-      jsonObject.value(SealingKeyJsonFieldName::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+Result<SealingKey> SealingKey::tryFromJson(const std::string& sealingKeyAsJson) {
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(sealingKeyAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* keyBytesHex = JsonFields::requiredString(jsonObject, SealingKeyJsonFieldName::keyBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, SealingKeyJsonFieldName::recipe);
+  if (keyBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
+  }
+  const SeededError hexError = hexStrError(*keyBytesHex);
+  if (hexError) {
+    return hexError;
   }
+  const std::vector<unsigned char> keyBytes = hexStrToByteVector(*keyBytesHex);
+  if (keyBytes.size() != crypto_box_PUBLICKEYBYTES) {
+    return SeededError{SeededErrorCode::InvalidRecipeValue, "Invalid key size exception"};
+  }
+  return Result<SealingKey>(ResultInPlace(), keyBytes, *recipe);
+}
+
+SealingKey SealingKey::fromJson(const std::string& sealingKeyAsJson) {
+  return tryFromJson(sealingKeyAsJson).valueOrThrow();
 }
 
 const std::string SealingKey::toJson(
@@ -44,11 +60,39 @@ const std::string SealingKey::toJson(
 };
 
 
-const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
+/* static */ size_t SealingKey::sealedLength(const size_t messageLength) {
+  return messageLength + crypto_box_SEALBYTES;
+}
+
+// The ephemeral keypair a message is sealed with, taken from a pool if
+// there is one and generated on the spot if not, and wiped once sealed
+class EphemeralKeypair {
+public:
+  unsigned char publicKey[crypto_box_PUBLICKEYBYTES];
+  unsigned char secretKey[crypto_box_SECRETKEYBYTES];
+
+  explicit EphemeralKeypair(EphemeralKeyPool* pool) {
+    if (pool != NULL) {
+      pool->take(publicKey, secretKey);
+    } else {
+      crypto_box_keypair(publicKey, secretKey);
+    }
+  }
+
+  ~EphemeralKeypair() {
+    sodium_memzero(secretKey, sizeof secretKey);
+    sodium_memzero(publicKey, sizeof publicKey);
+  }
+};
+
+static size_t sealToBuffer(
   const unsigned char* message,
   const size_t messageLength,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
   const std::vector<unsigned char> &sealingKeyBytes,
-  const std::string& unsealingInstructions
+  const std::string& unsealingInstructions,
+  EphemeralKeyPool* ephemeralKeyPool = NULL
 ) {
   if (sealingKeyBytes.size() != crypto_box_PUBLICKEYBYTES) {
     throw std::invalid_argument("Invalid key size");
@@ -56,22 +100,175 @@ const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
   if (messageLength <= 0) {
     throw std::invalid_argument("Invalid message length");
   }
-  const size_t ciphertextLength =
-    messageLength + crypto_box_SEALBYTES;
-  std::vector<unsigned char> ciphertext(ciphertextLength);
+  const size_t ciphertextLength = SealingKey::sealedLength(messageLength);
+  if (ciphertextCapacity < ciphertextLength) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
 
-  crypto_box_salted_seal(
-    ciphertext.data(),
+  const EphemeralKeypair ephemeralKeypair(ephemeralKeyPool);
+  crypto_box_salted_seal_with_keypair(
+    ciphertext,
     message,
     messageLength,
     sealingKeyBytes.data(),
+    ephemeralKeypair.publicKey,
+    ephemeralKeypair.secretKey,
     unsealingInstructions.c_str(),
     unsealingInstructions.length()
   );
 
+  return ciphertextLength;
+}
+
+const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::vector<unsigned char> &sealingKeyBytes,
+  const std::string& unsealingInstructions
+) {
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  std::vector<unsigned char> ciphertext(sealedLength(messageLength));
+  sealToBuffer(
+    message, messageLength, ciphertext.data(), ciphertext.size(), sealingKeyBytes, unsealingInstructions
+  );
   return ciphertext;
 }
 
+size_t SealingKey::sealToCiphertextOnly(
+  const unsigned char* message,
+  const size_t messageLength,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  return sealToBuffer(
+    message, messageLength, ciphertext, ciphertextCapacity, sealingKeyBytes, unsealingInstructions,
+    ephemeralKeyPool.get()
+  );
+}
+
+size_t SealingKey::sealToCiphertextOnly(
+  const Fragment* messageFragments,
+  const size_t fragmentCount,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  const size_t messageLength = Fragments::totalLength(messageFragments, fragmentCount);
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  const size_t ciphertextLength = sealedLength(messageLength);
+  if (ciphertextCapacity < ciphertextLength) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
+  const EphemeralKeypair ephemeralKeypair(ephemeralKeyPool.get());
+  crypto_box_salted_seal_fragments_with_keypair(
+    ciphertext,
+    messageFragments,
+    fragmentCount,
+    sealingKeyBytes.data(),
+    ephemeralKeypair.publicKey,
+    ephemeralKeypair.secretKey,
+    unsealingInstructions.c_str(),
+    unsealingInstructions.length()
+  );
+  return ciphertextLength;
+}
+
+void SealingKey::sealFile(
+  const std::string& inputPath,
+  const std::string& outputPath,
+  const std::string& unsealingInstructions
+) const {
+  const MappedFile input = SealedFile::openInput(inputPath, outputPath);
+  if (input.length() == 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  const size_t ciphertextLength = sealedLength(input.length());
+  MappedFile output(outputPath, SealedFile::length(ciphertextLength, recipe, unsealingInstructions));
+  sealToBuffer(
+    input.data(), input.length(),
+    SealedFile::writeAllButCiphertext(output, ciphertextLength, recipe, unsealingInstructions), ciphertextLength,
+    sealingKeyBytes, unsealingInstructions, ephemeralKeyPool.get()
+  );
+  output.commit();
+}
+
+SealedBatch SealingKey::sealBatch(
+  const BatchMessage* messages,
+  const size_t count,
+  const size_t threadCount
+) const {
+  return MessageBatch::seal(messages, count, MessageBatch::onThreads(threadCount), sealedLength,
+    [this](const BatchMessage& message, unsigned char* ciphertext, const size_t ciphertextCapacity) {
+      sealToBuffer(
+        message.data, message.length, ciphertext, ciphertextCapacity,
+        sealingKeyBytes, MessageBatch::unsealingInstructions(message), ephemeralKeyPool.get()
+      );
+    }
+  );
+}
+
+// The layout of the envelopes sealForRecipients produces
+static const size_t recipientCountBytes = 4;
+static const size_t recipientSlotBytes = crypto_box_SEALBYTES - crypto_box_PUBLICKEYBYTES + crypto_secretbox_KEYBYTES;
+static const size_t payloadOverheadBytes = crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+
+/* static */ size_t SealingKey::sealedForRecipientsLength(
+  const size_t recipientCount,
+  const size_t messageLength
+) {
+  return recipientCountBytes + crypto_box_PUBLICKEYBYTES +
+    recipientCount * recipientSlotBytes + payloadOverheadBytes + messageLength;
+}
+
+/* static */ const std::vector<unsigned char> SealingKey::sealForRecipients(
+  const std::vector<SealingKey>& recipients,
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions
+) {
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  if (recipients.empty() || (uint64_t) recipients.size() > 0xffffffffULL) {
+    throw std::invalid_argument("Invalid number of recipients");
+  }
+  std::vector<unsigned char> envelope(sealedForRecipientsLength(recipients.size(), messageLength));
+  unsigned char* out = envelope.data();
+  for (size_t i = 0; i < recipientCountBytes; i++) {
+    out[i] = (unsigned char) (((uint64_t) recipients.size()) >> (8 * i));
+  }
+  out += recipientCountBytes;
+
+  // One ephemeral keypair serves every recipient, so each recipient needs
+  // only one scalar multiplication to find its slot
+  const EphemeralKeypair ephemeralKeypair(NULL);
+  memcpy(out, ephemeralKeypair.publicKey, crypto_box_PUBLICKEYBYTES);
+  out += crypto_box_PUBLICKEYBYTES;
+
+  SodiumBuffer dataKey(crypto_secretbox_KEYBYTES);
+  randombytes_buf(dataKey.data, dataKey.length);
+  unsigned char sealedDataKey[crypto_box_SEALBYTES + crypto_secretbox_KEYBYTES];
+  for (const SealingKey& recipient : recipients) {
+    crypto_box_salted_seal_with_keypair(
+      sealedDataKey, dataKey.data, dataKey.length, recipient.sealingKeyBytes.data(),
+      ephemeralKeypair.publicKey, ephemeralKeypair.secretKey,
+      unsealingInstructions.c_str(), unsealingInstructions.length()
+    );
+    memcpy(out, sealedDataKey + crypto_box_PUBLICKEYBYTES, recipientSlotBytes);
+    out += recipientSlotBytes;
+  }
+
+  // The data key is used only once, but a random nonce costs little
+  randombytes_buf(out, crypto_secretbox_NONCEBYTES);
+  crypto_secretbox_easy(out + crypto_secretbox_NONCEBYTES, message, messageLength, out, dataKey.data);
+  return envelope;
+}
+
 const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
   const SodiumBuffer &message,
   const std::vector<unsigned char> &sealingKeyBytes,
@@ -87,7 +284,19 @@ const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
   const size_t messageLength,
   const std::string& unsealingInstructions
 ) const {
-  return SealingKey::sealToCiphertextOnly(message, messageLength, sealingKeyBytes, unsealingInstructions);
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  std::vector<unsigned char> ciphertext(sealedLength(messageLength));
+  sealToBuffer(
+    message, messageLength, ciphertext.data(), ciphertext.size(), sealingKeyBytes, unsealingInstructions,
+    ephemeralKeyPool.get()
+  );
+  return ciphertext;
+}
+
+void SealingKey::setEphemeralKeyPool(const std::shared_ptr<EphemeralKeyPool>& pool) {
+  ephemeralKeyPool = pool;
 }
 
 const std::vector<unsigned char> SealingKey::sealToCiphertextOnly(
@@ -101,22 +310,14 @@ const PackagedSealedMessage SealingKey::seal(
   const std::vector<unsigned char>& message,
   const std::string& unsealingInstructions
 ) const {
-  return PackagedSealedMessage(
-    sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions),
-    recipe,
-    unsealingInstructions
-  );  
+  return seal(message.data(), message.size(), unsealingInstructions);
 }
 
 const PackagedSealedMessage SealingKey::seal(
   const SodiumBuffer& message,
   const std::string& unsealingInstructions
 ) const {
-  return PackagedSealedMessage(
-    sealToCiphertextOnly(message.data, message.length, unsealingInstructions),
-    recipe,
-    unsealingInstructions
-  );
+  return seal(message.data, message.length, unsealingInstructions);
 }
 
 const PackagedSealedMessage SealingKey::seal(
@@ -124,11 +325,9 @@ const PackagedSealedMessage SealingKey::seal(
   const size_t messageLength,
   const std::string& unsealingInstructions
 ) const {
-  return PackagedSealedMessage(
-    sealToCiphertextOnly(message, messageLength, unsealingInstructions),
-    recipe,
-    unsealingInstructions
-  );
+  // Move the ciphertext into the package rather than copying it
+  std::vector<unsigned char> ciphertext(sealToCiphertextOnly(message, messageLength, unsealingInstructions));
+  return PackagedSealedMessage(std::move(ciphertext), recipe, unsealingInstructions);
 }
 
   const PackagedSealedMessage SealingKey::seal(
@@ -157,3 +356,32 @@ SealingKey SealingKey::fromSerializedBinaryForm(const SodiumBuffer &serializedBi
   const auto fields = serializedBinaryForm.splitFixedLengthList(2);
   return SealingKey(fields[0].toVector(), fields[1].toUtf8String());
 }
+
+// The context that separates key IDs from other hashes of the public key
+static const char keyIdContext[] = "SealingKeyId";
+
+const std::vector<unsigned char> SealingKey::keyId() const {
+  std::vector<unsigned char> id(PackagedSealedMessage::KeyIdBytes);
+  crypto_generichash_state st;
+  crypto_generichash_init(&st, NULL, 0, id.size());
+  crypto_generichash_update(&st, (const unsigned char*) keyIdContext, sizeof keyIdContext - 1);
+  crypto_generichash_update(&st, sealingKeyBytes.data(), sealingKeyBytes.size());
+  crypto_generichash_final(&st, id.data(), id.size());
+  return id;
+}
+
+const PackagedSealedMessage SealingKey::sealWithKeyId(
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions
+) const {
+  std::vector<unsigned char> ciphertext(sealToCiphertextOnly(message, messageLength, unsealingInstructions));
+  return PackagedSealedMessage(std::move(ciphertext), recipe, unsealingInstructions, keyId());
+}
+
+const PackagedSealedMessage SealingKey::sealWithKeyId(
+  const std::vector<unsigned char>& message,
+  const std::string& unsealingInstructions
+) const {
+  return sealWithKeyId(message.data(), message.size(), unsealingInstructions);
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
 #include <sodium.h>
 #include "sodium-buffer.hpp"
 #include "packaged-sealed-message.hpp"
+#include "result.hpp"
+#include "message-batch.hpp"
+#include "fragments.hpp"
+#include "ephemeral-key-pool.hpp"
 
 /**
  * @brief A sealingKeyBytes is used to _seal_ messages, in combination with a
@@ -34,6 +39,9 @@
  * @ingroup DerivedFromSeeds
  */
 class SealingKey {
+  // Where seals take their ephemeral keypairs from, if anywhere
+  std::shared_ptr<EphemeralKeyPool> ephemeralKeyPool;
+
 public:
   /**
    * @brief Construct a sealingKeyBytes from a JSON string
@@ -41,6 +49,13 @@ public:
    * @param sealingKeyAsJson The JSON encoding of a sealingKeyBytes
    */
   static SealingKey fromJson(const std::string& sealingKeyAsJson);
+
+  /**
+   * @brief Reconstitute a SealingKey from JSON without throwing.
+   *
+   * @return Result<SealingKey> The key, or the error fromJson would have thrown.
+   */
+  static Result<SealingKey> tryFromJson(const std::string& sealingKeyAsJson);
   
   /**
    * @brief The binary representation of the public key used for sealing
@@ -138,6 +153,150 @@ public:
     const std::string& unsealingInstructions = {}
   ) const;
 
+  /**
+   * @brief The length of the ciphertext produced by sealing a message
+   * of a given length (the message length plus 48 bytes).
+   */
+  static size_t sealedLength(const size_t messageLength);
+
+  /**
+   * @brief Seal a plaintext message into a buffer the caller provides,
+   * without allocating.
+   * 
+   * @param message The plaintxt message to seal 
+   * @param messageLength The length of the plaintext message in bytes
+   * @param ciphertext The buffer to write the sealed message into
+   * @param ciphertextCapacity The size of the ciphertext buffer, which must
+   * be at least sealedLength(messageLength)
+   * @param unsealingInstructions If this optional string
+   * is passed, the same string must be passed to unseal the message.
+   * @return size_t The number of bytes written to ciphertext
+   * 
+   * @exception std::invalid_argument Thrown if the message is empty or
+   * the ciphertext buffer is too small.
+   */
+  size_t sealToCiphertextOnly(
+    const unsigned char* message,
+    const size_t messageLength,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a message held in non-contiguous fragments into a buffer
+   * the caller provides, without first copying the fragments together.
+   *
+   * The ciphertext can be unsealed just like one produced by
+   * sealToCiphertextOnly from the concatenation of the fragments.
+   *
+   * @param messageFragments The fragments of the plaintext message
+   * @param fragmentCount The number of fragments
+   * @param ciphertext The buffer to write the sealed _ciphertext_ into
+   * @param ciphertextCapacity The size of the ciphertext buffer, which must
+   * be at least sealedLength(total length of the fragments)
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return size_t The number of bytes written to ciphertext
+   *
+   * @exception std::invalid_argument Thrown if the message is empty or
+   * the ciphertext buffer is too small.
+   */
+  size_t sealToCiphertextOnly(
+    const Fragment* messageFragments,
+    const size_t fragmentCount,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a file into another file, mapping both into memory so
+   * the message is sealed straight from one to the other.
+   *
+   * The sealed file holds this key's recipe and the unsealingInstructions
+   * along with the ciphertext, like a PackagedSealedMessage (see SealedFile).
+   *
+   * @param inputPath The path of the file to seal, which must not be empty
+   * @param outputPath The path of the sealed file to create (or overwrite),
+   * which must not be the input file
+   * @param unsealingInstructions If this optional string is
+   * passed, it is stored in the sealed file and must be honored
+   * by whoever unseals it.
+   *
+   * @exception std::invalid_argument Thrown if the input file is empty
+   * or is the output file, or if the ciphertext would be 4GB or longer.
+   * @exception std::system_error Thrown if either file can't be opened or written.
+   */
+  void sealFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a batch of messages into one contiguous arena,
+   * allocating once for the whole batch rather than once per message.
+   *
+   * Each ciphertext is the one sealToCiphertextOnly would produce for
+   * the same message and unsealingInstructions.
+   *
+   * @param messages The messages to seal, each with its own (optional)
+   * unsealingInstructions
+   * @param count The number of messages
+   * @param threadCount The maximum number of threads to seal with, or 0
+   * for one per core. Threads are started for each call, so only use
+   * more than one for batches that take milliseconds to seal.
+   * @return SealedBatch The ciphertexts, in the order of the messages
+   *
+   * @exception std::invalid_argument Thrown if any message is empty.
+   */
+  SealedBatch sealBatch(
+    const BatchMessage* messages,
+    const size_t count,
+    const size_t threadCount = 1
+  ) const;
+
+  /**
+   * @brief The length of the envelope sealForRecipients produces for a
+   * given number of recipients and message length.
+   */
+  static size_t sealedForRecipientsLength(const size_t recipientCount, const size_t messageLength);
+
+  /**
+   * @brief Seal one message for many recipients, encrypting it only once.
+   *
+   * The message is sealed with a random, single-use data key, and that
+   * key is sealed for each recipient. The envelope is:
+   *   - the number of recipients (4 bytes, little-endian)
+   *   - an ephemeral public key shared by every recipient's slot (32 bytes)
+   *   - one 48-byte slot per recipient: the data key, sealed as the
+   *     box sealToCiphertextOnly would produce with that ephemeral key
+   *     (the 32-byte public key prefix, which every slot shares, omitted)
+   *   - the message, sealed with the data key as a secret box (24-byte
+   *     random nonce, 16-byte MAC)
+   *
+   * Each recipient unseals it with UnsealingKey::unsealForRecipient,
+   * which computes its shared key once and then only checks each slot's
+   * MAC to find its own. Recipients can't tell who the others are.
+   *
+   * @param recipients The SealingKeys of the recipients
+   * @param message The plaintext message to seal
+   * @param messageLength The length of the plaintext to seal
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const std::vector<unsigned char> The envelope
+   *
+   * @exception std::invalid_argument Thrown if the message is empty,
+   * or if there are no recipients or more than 2^32 - 1 of them.
+   */
+  static const std::vector<unsigned char> sealForRecipients(
+    const std::vector<SealingKey>& recipients,
+    const unsigned char* message,
+    const size_t messageLength,
+    const std::string& unsealingInstructions = {}
+  );
+
   /**
    * @brief Seal a plaintext message
    * 
@@ -225,6 +384,57 @@ public:
     const std::string& unsealingInstructions
   ) const;
 
+  /**
+   * @brief A short identifier of this key (PackagedSealedMessage::KeyIdBytes
+   * long) for a Keyring to index the matching UnsealingKey by: a BLAKE2b
+   * hash of the sealingKeyBytes, which UnsealingKey::keyId also returns.
+   */
+  const std::vector<unsigned char> keyId() const;
+
+  /**
+   * @brief Seal a plaintext message and package it along with its recipe,
+   * unsealingInstructions, and this key's keyId, so that a Keyring
+   * holding this key can find it without trying every key it holds.
+   *
+   * The key ID links every message sealed this way to the same key,
+   * so only use it where that needn't be hidden.
+   *
+   * @param message The plaintext message to seal
+   * @param messageLength The length of the plaintext to seal
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const PackagedSealedMessage The sealed message, with its keyId
+   */
+  const PackagedSealedMessage sealWithKeyId(
+    const unsigned char* message,
+    const size_t messageLength,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a plaintext message and package it along with its recipe,
+   * unsealingInstructions, and this key's keyId.
+   *
+   * @param message The plaintext message to seal
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const PackagedSealedMessage The sealed message, with its keyId
+   */
+  const PackagedSealedMessage sealWithKeyId(
+    const std::vector<unsigned char>& message,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Take the ephemeral keypair for each message this key seals
+   * from a pool of pre-generated keypairs, rather than generating one
+   * during the seal. Copies of this key made afterwards share the pool.
+   *
+   * @param pool The pool, or an empty pointer to go back to generating
+   * a keypair for each message
+   */
+  void setEphemeralKeyPool(const std::shared_ptr<EphemeralKeyPool>& pool);
+
   /**
    * @brief Get the copy of the raw public key bytes used by lib-sodium
    * 
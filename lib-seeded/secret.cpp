@@ -2,6 +2,8 @@
 #include "recipe.hpp"
 #include "exceptions.hpp"
 #include "common-names.hpp"
+#include "convert.hpp"
+#include "json-fields.hpp"
 
 Secret::Secret(
   const SodiumBuffer& _secretBytes,
@@ -41,16 +43,25 @@ namespace SecretJsonFields {
   static const std::string recipe = CommonNames::recipe;
 }
 
-Secret Secret::fromJson(const std::string& secretAsJson) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(secretAsJson);
-    return Secret(
-      SodiumBuffer::fromHexString(jsonObject.at(SecretJsonFields::secretBytes)),
-      jsonObject.value<std::string>(SecretJsonFields::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+Result<Secret> Secret::tryFromJson(const std::string& secretAsJson) {
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(secretAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* secretBytesHex = JsonFields::requiredString(jsonObject, SecretJsonFields::secretBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, SecretJsonFields::recipe);
+  if (secretBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
+  }
+  const SeededError hexError = hexStrError(*secretBytesHex);
+  if (hexError) {
+    return hexError;
   }
+  return Result<Secret>(ResultInPlace(), SodiumBuffer::fromHexString(*secretBytesHex), *recipe);
+}
+
+Secret Secret::fromJson(const std::string& secretAsJson) {
+  return tryFromJson(secretAsJson).valueOrThrow();
 }
 
 const std::string
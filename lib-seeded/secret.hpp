@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sodium-buffer.hpp"
+#include "result.hpp"
 #include <string>
 
 /**
@@ -122,4 +123,13 @@ public:
     const std::string& seedAsJson
   );
 
+  /**
+   * @brief Reconstitute a Secret from JSON without throwing.
+   *
+   * @return Result<Secret> The Secret, or the error fromJson would have thrown.
+   */
+  static Result<Secret> tryFromJson(
+    const std::string& seedAsJson
+  );
+
 };
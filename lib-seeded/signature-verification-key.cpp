@@ -1,12 +1,17 @@
 #include "github-com-nlohmann-json/json.hpp"
 #include "signature-verification-key.hpp"
+#include "signing-key-stream.hpp"
 #include "exceptions.hpp"
+#include "parallel-for.hpp"
 #include "convert.hpp"
 #include <stdexcept>
+#include <algorithm>
 #include "common-names.hpp"
+#include "json-fields.hpp"
 #include "key-formats/OpenSshKey.hpp"
 #include "key-formats/OpenPgpKey.hpp"
 #include "key-formats/PEM.hpp"
+#include "key-formats/Minisign.hpp"
 
 namespace SignatureVerificationKeyJsonFieldName {
   static const std::string keyBytes = "keyBytes";
@@ -22,18 +27,29 @@ SignatureVerificationKey::SignatureVerificationKey(
     }
   }
 
-SignatureVerificationKey SignatureVerificationKey::fromJson(const std::string& signatureVerificationKeyAsJson) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(signatureVerificationKeyAsJson);
-    return SignatureVerificationKey(
-      hexStrToByteVector(jsonObject.value<std::string>(
-        SignatureVerificationKeyJsonFieldName::keyBytes, "")),
-      jsonObject.value<std::string>(
-        SignatureVerificationKeyJsonFieldName::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+Result<SignatureVerificationKey> SignatureVerificationKey::tryFromJson(const std::string& signatureVerificationKeyAsJson) {
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(signatureVerificationKeyAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* keyBytesHex = JsonFields::optionalString(jsonObject, SignatureVerificationKeyJsonFieldName::keyBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, SignatureVerificationKeyJsonFieldName::recipe);
+  if (keyBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
+  }
+  const SeededError hexError = hexStrError(*keyBytesHex);
+  if (hexError) {
+    return hexError;
+  }
+  const std::vector<unsigned char> keyBytes = hexStrToByteVector(*keyBytesHex);
+  if (keyBytes.size() != crypto_sign_PUBLICKEYBYTES) {
+    return SeededError{SeededErrorCode::InvalidArgument, "Invalid key size exception"};
   }
+  return Result<SignatureVerificationKey>(ResultInPlace(), keyBytes, *recipe);
+}
+
+SignatureVerificationKey SignatureVerificationKey::fromJson(const std::string& signatureVerificationKeyAsJson) {
+  return tryFromJson(signatureVerificationKeyAsJson).valueOrThrow();
 }
 
 // SignatureVerificationKey::SignatureVerificationKey(const std::string& verificationKeyAsJson) :
@@ -123,6 +139,64 @@ bool SignatureVerificationKey::verify(
   return verify(signatureVerificationKeyBytes, message.data, message.length, signature);
 }
 
+bool SignatureVerificationKey::verifyFile(
+  const std::string& path,
+  const std::vector<unsigned char>& signature
+) const {
+  SignatureVerificationKeyStreamVerifier verifier(*this);
+  SigningKeyStream::readFileInChunks(path, [&verifier](const unsigned char* chunk, const size_t length) {
+    verifier.update(chunk, length);
+  });
+  return verifier.final(signature);
+}
+
+bool SignatureVerificationKey::verifyMinisignSignatureForFile(
+  const std::string& path,
+  const std::string& minisignSignature
+) const {
+  return ::verifyMinisignSignatureForFile(*this, path, minisignSignature);
+}
+
+// Verify a batch with the given forEach, which calls body(index) for every index
+template <typename ForEach>
+static VerifiedBatch verifyBatchWith(
+  const BatchSignedMessage* messages,
+  const size_t count,
+  const ForEach& forEach
+) {
+  VerifiedBatch batch = {std::vector<unsigned char>(count, 0), 0};
+  forEach(count, [&](const size_t i) {
+    const BatchSignedMessage& item = messages[i];
+    batch.valid[i] =
+      item.key != NULL &&
+      item.key->signatureVerificationKeyBytes.size() == crypto_sign_PUBLICKEYBYTES &&
+      item.signatureLength == crypto_sign_BYTES &&
+      crypto_sign_verify_detached(item.signature, item.message, item.messageLength, item.key->signatureVerificationKeyBytes.data()) == 0;
+  });
+  batch.invalidCount = (size_t) std::count(batch.valid.begin(), batch.valid.end(), 0);
+  return batch;
+}
+
+VerifiedBatch SignatureVerificationKey::verifyBatch(
+  const BatchSignedMessage* messages,
+  const size_t count,
+  const size_t threadCount
+) {
+  return verifyBatchWith(messages, count, [threadCount](const size_t n, const std::function<void(size_t)>& body) {
+    parallelFor(n, body, threadCount);
+  });
+}
+
+VerifiedBatch SignatureVerificationKey::verifyBatch(
+  const BatchSignedMessage* messages,
+  const size_t count,
+  WorkerPool& pool
+) {
+  return verifyBatchWith(messages, count, [&pool](const size_t n, const std::function<void(size_t)>& body) {
+    pool.parallelFor(n, body);
+  });
+}
+
 
 const SodiumBuffer SignatureVerificationKey::toSerializedBinaryForm() const {
   SodiumBuffer _signatureVerificationKeyBytes(signatureVerificationKeyBytes);
@@ -144,4 +218,8 @@ SignatureVerificationKey SignatureVerificationKey::fromSerializedBinaryForm(
 
 const std::string SignatureVerificationKey::toOpenSshPublicKey() const {
   return getOpenSSHPublicKeyEd25519(*this);
-}
\ No newline at end of file
+}
+
+const std::string SignatureVerificationKey::toMinisignPublicKey() const {
+  return getMinisignPublicKey(*this);
+}
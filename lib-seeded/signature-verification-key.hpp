@@ -6,6 +6,74 @@
 #include <string>
 
 #include "sodium-buffer.hpp"
+#include "result.hpp"
+#include "worker-pool.hpp"
+
+class SignatureVerificationKey;
+
+/**
+ * @brief One signed message in a batch passed to
+ * SignatureVerificationKey::verifyBatch.
+ *
+ * Nothing is copied: the key, message, and signature must remain
+ * valid until the batch call returns.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+struct BatchSignedMessage {
+  /**
+   * @brief The key to verify the signature with (if NULL, the
+   * signature is treated as invalid)
+   */
+  const SignatureVerificationKey* key;
+  /**
+   * @brief The message that was signed
+   */
+  const unsigned char* message;
+  /**
+   * @brief The length of the message in bytes
+   */
+  size_t messageLength;
+  /**
+   * @brief The signature to verify
+   */
+  const unsigned char* signature;
+  /**
+   * @brief The length of the signature in bytes
+   */
+  size_t signatureLength;
+};
+
+/**
+ * @brief The outcome of verifying each signature in a batch
+ *
+ * @ingroup DerivedFromSeeds
+ */
+struct VerifiedBatch {
+  /**
+   * @brief 1 for each signature that is valid, 0 for each that isn't
+   * (bytes rather than a std::vector<bool>, so that threads can set
+   * them concurrently)
+   */
+  std::vector<unsigned char> valid;
+  /**
+   * @brief The number of signatures that aren't valid
+   */
+  size_t invalidCount;
+
+  /**
+   * @brief The number of signatures in the batch
+   */
+  size_t size() const { return valid.size(); }
+  /**
+   * @brief True if signature i is valid
+   */
+  bool ok(const size_t i) const { return valid[i] != 0; }
+  /**
+   * @brief True if every signature in the batch is valid
+   */
+  bool allValid() const { return invalidCount == 0; }
+};
 
 /**
  * @brief A SignatureVerificationKey is used to verify that messages were
@@ -54,6 +122,15 @@ public:
     const std::string& signatureVerificationKeyAsJson
   );
 
+  /**
+   * @brief Reconstitute a SignatureVerificationKey from JSON without throwing.
+   *
+   * @return Result<SignatureVerificationKey> The SignatureVerificationKey, or the error fromJson would have thrown.
+   */
+  static Result<SignatureVerificationKey> tryFromJson(
+    const std::string& signatureVerificationKeyAsJson
+  );
+
   /**
    * @brief Serialize this object to a JSON-formatted string
    * 
@@ -188,6 +265,74 @@ public:
     const std::vector<unsigned char>& signature
   ) const;
 
+  /**
+   * @brief Verify a signature produced by SigningKey::generateSignatureForFile,
+   * reading the file in chunks.
+   *
+   * @param path The path of the file that was signed
+   * @param signature The signature
+   * @return true if the signature is valid
+   * @return false if the verification fails.
+   * @exception std::system_error Thrown if the file can't be read.
+   */
+  bool verifyFile(
+    const std::string& path,
+    const std::vector<unsigned char>& signature
+  ) const;
+
+  /**
+   * @brief Verify a file's signature in the format of a minisign .minisig
+   * file, such as one produced by SigningKey::generateMinisignSignatureForFile
+   * or by minisign, reading the file in chunks.
+   *
+   * @param path The path of the file that was signed
+   * @param minisignSignature The contents of the .minisig file
+   * @return true if the signature and its trusted comment's signature are valid
+   * @return false if the verification fails.
+   * @exception std::system_error Thrown if the file can't be read.
+   */
+  bool verifyMinisignSignatureForFile(
+    const std::string& path,
+    const std::string& minisignSignature
+  ) const;
+
+  /**
+   * @brief Verify a batch of signatures, each with its own key, and
+   * report which are valid.
+   *
+   * Each signature is verified exactly as verify would, so a batch with
+   * invalid signatures pinpoints them rather than just failing.
+   *
+   * @param messages The signed messages to verify
+   * @param count The number of signed messages
+   * @param threadCount The maximum number of threads to verify with, or 0
+   * for one per core. Threads are started for each call, so only use
+   * more than one for batches that take milliseconds to verify.
+   * @return VerifiedBatch Whether each signature, in the order of the
+   * messages, is valid
+   */
+  static VerifiedBatch verifyBatch(
+    const BatchSignedMessage* messages,
+    const size_t count,
+    const size_t threadCount = 1
+  );
+
+  /**
+   * @brief Verify a batch of signatures, as verifyBatch does, spreading
+   * the work across the threads of a WorkerPool.
+   *
+   * @param messages The signed messages to verify
+   * @param count The number of signed messages
+   * @param pool The threads to verify with
+   * @return VerifiedBatch Whether each signature, in the order of the
+   * messages, is valid
+   */
+  static VerifiedBatch verifyBatch(
+    const BatchSignedMessage* messages,
+    const size_t count,
+    WorkerPool& pool
+  );
+
   /**
    * @brief Get the raw signature verification key as a byte vector.
    * 
@@ -234,5 +379,10 @@ public:
    * @brief Convert the signature-verification key to an OpenSSH public key string
   */
   const std::string toOpenSshPublicKey() const;
+
+  /**
+   * @brief Convert the signature-verification key to the format of a minisign.pub file
+   */
+  const std::string toMinisignPublicKey() const;
 };
 
@@ -0,0 +1,99 @@
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+#include "signing-key-stream.hpp"
+#include "exceptions.hpp"
+
+/////
+//  SigningKeyStreamSigner
+////
+
+SigningKeyStreamSigner::SigningKeyStreamSigner(const SigningKey& key) :
+  signingKeyBytes(key.signingKeyBytes)
+{
+  crypto_sign_init(&state);
+}
+
+SigningKeyStreamSigner::~SigningKeyStreamSigner() {
+  sodium_memzero(&state, sizeof state);
+}
+
+void SigningKeyStreamSigner::update(const unsigned char* message, const size_t length) {
+  if (finished) {
+    throw std::logic_error("Stream already finished");
+  }
+  crypto_sign_update(&state, message, length);
+}
+
+const std::vector<unsigned char> SigningKeyStreamSigner::final() {
+  if (finished) {
+    throw std::logic_error("Stream already finished");
+  }
+  finished = true;
+  std::vector<unsigned char> signature(crypto_sign_BYTES);
+  crypto_sign_final_create(&state, signature.data(), NULL, signingKeyBytes.data);
+  return signature;
+}
+
+/////
+//  SignatureVerificationKeyStreamVerifier
+////
+
+SignatureVerificationKeyStreamVerifier::SignatureVerificationKeyStreamVerifier(
+  const SignatureVerificationKey& key
+) : signatureVerificationKeyBytes(key.signatureVerificationKeyBytes) {
+  if (signatureVerificationKeyBytes.size() != crypto_sign_PUBLICKEYBYTES) {
+    throw KeyLengthException("Invalid signature-verification key size");
+  }
+  crypto_sign_init(&state);
+}
+
+SignatureVerificationKeyStreamVerifier::~SignatureVerificationKeyStreamVerifier() {
+  sodium_memzero(&state, sizeof state);
+}
+
+void SignatureVerificationKeyStreamVerifier::update(const unsigned char* message, const size_t length) {
+  if (finished) {
+    throw std::logic_error("Stream already finished");
+  }
+  crypto_sign_update(&state, message, length);
+}
+
+bool SignatureVerificationKeyStreamVerifier::final(const std::vector<unsigned char>& signature) {
+  if (finished) {
+    throw std::logic_error("Stream already finished");
+  }
+  finished = true;
+  return signature.size() == crypto_sign_BYTES &&
+    crypto_sign_final_verify(&state, signature.data(), signatureVerificationKeyBytes.data()) == 0;
+}
+
+/////
+//  SigningKeyStream
+////
+
+void SigningKeyStream::readFileInChunks(
+  const std::string& path,
+  const std::function<void(const unsigned char*, size_t)>& update
+) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    throw std::system_error(errno, std::generic_category(), "Could not open " + path);
+  }
+  std::vector<unsigned char> chunk(1024 * 1024);
+  size_t bytesRead;
+  try {
+    while ((bytesRead = fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+      update(chunk.data(), bytesRead);
+    }
+  } catch (...) {
+    fclose(file);
+    throw;
+  }
+  const bool failed = ferror(file) != 0;
+  fclose(file);
+  if (failed) {
+    throw std::system_error(EIO, std::generic_category(), "Could not read " + path);
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "signing-key.hpp"
+#include "signature-verification-key.hpp"
+
+/**
+ * @brief Signs a message of any length, incrementally and in constant
+ * memory, using Ed25519ph (crypto_sign_init/update/final_create).
+ *
+ * Construct it, call update with each part of the message, then call
+ * final to get the signature. Use SigningKey::generateSignatureForFile
+ * to sign a file in chunks.
+ *
+ * Ed25519ph signs a SHA-512 hash of the message rather than the message
+ * itself, so its signatures are verified by
+ * SignatureVerificationKeyStreamVerifier (or
+ * SignatureVerificationKey::verifyFile), not SignatureVerificationKey::verify.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class SigningKeyStreamSigner {
+  const SodiumBuffer signingKeyBytes;
+  crypto_sign_state state;
+  bool finished = false;
+
+  SigningKeyStreamSigner(const SigningKeyStreamSigner&) = delete;
+  SigningKeyStreamSigner& operator=(const SigningKeyStreamSigner&) = delete;
+
+public:
+  /**
+   * @brief Prepare to sign a message
+   *
+   * @param key The key to sign with
+   */
+  explicit SigningKeyStreamSigner(const SigningKey& key);
+
+  ~SigningKeyStreamSigner();
+
+  /**
+   * @brief Add the next part of the message
+   *
+   * @throws std::logic_error if final has been called
+   */
+  void update(const unsigned char* message, const size_t length);
+
+  /**
+   * @brief Sign the message passed to update
+   *
+   * @return const std::vector<unsigned char> The crypto_sign_BYTES-byte signature
+   * @throws std::logic_error if final has already been called
+   */
+  const std::vector<unsigned char> final();
+};
+
+/**
+ * @brief Verifies an Ed25519ph signature produced by SigningKeyStreamSigner,
+ * incrementally and in constant memory.
+ *
+ * Construct it, call update with each part of the message, then call
+ * final with the signature.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class SignatureVerificationKeyStreamVerifier {
+  const std::vector<unsigned char> signatureVerificationKeyBytes;
+  crypto_sign_state state;
+  bool finished = false;
+
+  SignatureVerificationKeyStreamVerifier(const SignatureVerificationKeyStreamVerifier&) = delete;
+  SignatureVerificationKeyStreamVerifier& operator=(const SignatureVerificationKeyStreamVerifier&) = delete;
+
+public:
+  /**
+   * @brief Prepare to verify a message's signature
+   *
+   * @param key The key to verify the signature with
+   * @throws KeyLengthException if the key isn't crypto_sign_PUBLICKEYBYTES long
+   */
+  explicit SignatureVerificationKeyStreamVerifier(const SignatureVerificationKey& key);
+
+  ~SignatureVerificationKeyStreamVerifier();
+
+  /**
+   * @brief Add the next part of the message
+   *
+   * @throws std::logic_error if final has been called
+   */
+  void update(const unsigned char* message, const size_t length);
+
+  /**
+   * @brief Verify the signature of the message passed to update
+   *
+   * @return true if the signature is valid
+   * @return false if it isn't (or isn't crypto_sign_BYTES long)
+   * @throws std::logic_error if final has already been called
+   */
+  bool final(const std::vector<unsigned char>& signature);
+};
+
+namespace SigningKeyStream {
+  /**
+   * @brief Read a file in chunks, passing each to `update(chunk, length)`,
+   * so that files too large to hold in memory can be signed or hashed.
+   *
+   * @exception std::system_error Thrown if the file can't be opened or read.
+   */
+  void readFileInChunks(
+    const std::string& path,
+    const std::function<void(const unsigned char*, size_t)>& update
+  );
+}
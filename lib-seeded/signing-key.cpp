@@ -1,12 +1,15 @@
 #include "signing-key.hpp"
+#include "signing-key-stream.hpp"
 #include "recipe.hpp"
 #include "sodium-buffer.hpp"
 #include "convert.hpp"
 #include "exceptions.hpp"
 #include "common-names.hpp"
+#include "json-fields.hpp"
 #include "key-formats/OpenSshKey.hpp"
 #include "key-formats/OpenPgpKey.hpp"
 #include "key-formats/PEM.hpp"
+#include "key-formats/Minisign.hpp"
 
 const SodiumBuffer convertSeedToSodiumPrivateKey(const SodiumBuffer& seedOrSodiumPrivateKey) {
   if (seedOrSodiumPrivateKey.length == crypto_sign_SECRETKEYBYTES) {
@@ -21,19 +24,28 @@ const SodiumBuffer convertSeedToSodiumPrivateKey(const SodiumBuffer& seedOrSodiu
   }
 }
 
+// The public key stored in the second half of a sodium-style private key
+static const std::vector<unsigned char> extractSignatureVerificationKey(const SodiumBuffer& sodiumPrivateKey) {
+  std::vector<unsigned char> signatureVerificationKeyBytes(crypto_sign_PUBLICKEYBYTES);
+  crypto_sign_ed25519_sk_to_pk(signatureVerificationKeyBytes.data(), sodiumPrivateKey.data);
+  return signatureVerificationKeyBytes;
+}
+
 SigningKey::SigningKey(
   const SodiumBuffer& _signingKeyBytes,
   const std::string& _recipe
 ) :
+  signingKeyBytes(convertSeedToSodiumPrivateKey(_signingKeyBytes)),
   recipe(_recipe),
-  signingKeyBytes(convertSeedToSodiumPrivateKey(_signingKeyBytes))
+  signatureVerificationKeyBytes(extractSignatureVerificationKey(signingKeyBytes))
 {}
 
 SigningKey::SigningKey(
   const SigningKey& other
 ) :
+  signingKeyBytes(other.signingKeyBytes),
   recipe(other.recipe),
-  signingKeyBytes(other.signingKeyBytes)
+  signatureVerificationKeyBytes(other.signatureVerificationKeyBytes)
   {}
 
 namespace SigningKeyJsonField {
@@ -41,19 +53,36 @@ namespace SigningKeyJsonField {
   static const std::string recipe = CommonNames::recipe;
 }
 
-SigningKey SigningKey::fromJson(
+Result<SigningKey> SigningKey::tryFromJson(
   const std::string& signingKeyAsJson
 ) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(signingKeyAsJson);
-    return SigningKey(
-      SodiumBuffer::fromHexString(jsonObject.at(SigningKeyJsonField::signingKeyBytes)),
-      jsonObject.value(SigningKeyJsonField::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(signingKeyAsJson, jsonObject)) {
+    return JsonFields::parsingError;
   }
+  const std::string* signingKeyBytesHex = JsonFields::requiredString(jsonObject, SigningKeyJsonField::signingKeyBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, SigningKeyJsonField::recipe);
+  if (signingKeyBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
+  }
+  const SeededError hexError = hexStrError(*signingKeyBytesHex);
+  if (hexError) {
+    return hexError;
+  }
+  const SodiumBuffer signingKeyBytes = SodiumBuffer::fromHexString(*signingKeyBytesHex);
+  if (
+    signingKeyBytes.length != crypto_sign_SECRETKEYBYTES &&
+    signingKeyBytes.length != crypto_sign_SEEDBYTES
+  ) {
+    return SeededError{SeededErrorCode::InvalidRecipeValue, "Invalid signing key size"};
+  }
+  return Result<SigningKey>(ResultInPlace(), signingKeyBytes, *recipe);
+}
 
+SigningKey SigningKey::fromJson(
+  const std::string& signingKeyAsJson
+) {
+  return tryFromJson(signingKeyAsJson).valueOrThrow();
 }
 
 SigningKey::SigningKey(
@@ -82,9 +111,7 @@ SigningKey SigningKey::deriveFromSeed(
 
 
 
-const std::vector<unsigned char> SigningKey::getSignatureVerificationKeyBytes() const {
-  std::vector<unsigned char> signatureVerificationKeyBytes(crypto_sign_PUBLICKEYBYTES);
-  crypto_sign_ed25519_sk_to_pk(signatureVerificationKeyBytes.data(), signingKeyBytes.data);
+const std::vector<unsigned char>& SigningKey::getSignatureVerificationKeyBytes() const {
   return signatureVerificationKeyBytes;
 }
 
@@ -115,6 +142,23 @@ const std::vector<unsigned char> SigningKey::generateSignature(
   return generateSignature(message.data(), message.size());
 }
 
+const std::vector<unsigned char> SigningKey::generateSignatureForFile(
+  const std::string& path
+) const {
+  SigningKeyStreamSigner signer(*this);
+  SigningKeyStream::readFileInChunks(path, [&signer](const unsigned char* chunk, const size_t length) {
+    signer.update(chunk, length);
+  });
+  return signer.final();
+}
+
+const std::string SigningKey::generateMinisignSignatureForFile(
+  const std::string& path,
+  const std::string& trustedComment
+) const {
+  return getMinisignSignatureForFile(*this, path, trustedComment);
+}
+
 const std::string SigningKey::toJson(
   int indent,
   const char indent_char
@@ -29,6 +29,12 @@ public:
    */
   const std::string recipe;
 
+private:
+  // The public key, copied out of signingKeyBytes once rather than for each use
+  const std::vector<unsigned char> signatureVerificationKeyBytes;
+
+public:
+
   /**
    * @brief Construct a copy of another SigningKey
    */
@@ -79,9 +85,8 @@ public:
   /**
    * @brief Construct (reconsitute) the SigningKey from JSON format.
    * The JSON object may or may not contain the signatureVerificationKeyBytes.
-   * If it does not, an empty byte vector will be stored and the verification
-   * key bytes will be re-derived from the signing key by
-   * getSignatureVerificationKeyBytes if they are needed.
+   * Either way, the verification key bytes are taken from the signing key
+   * (see getSignatureVerificationKeyBytes).
    * 
    * @param signingKeyAsJson 
 
@@ -90,6 +95,15 @@ public:
    const std::string& signingKeyAsJson
   );
 
+  /**
+   * @brief Reconstitute a SigningKey from JSON without throwing.
+   *
+   * @return Result<SigningKey> The SigningKey, or the error fromJson would have thrown.
+   */
+  static Result<SigningKey> tryFromJson(
+    const std::string& signingKeyAsJson
+  );
+
   /**
    * @brief Extract the 32-byte private seed (the compact representation of the private key)
    * from the 64-byte sodium private key (which contains a copy of the public key, which
@@ -99,10 +113,9 @@ public:
 
   /**
    * @brief Get the raw binary representation of the signature-verification key,
-   * re-deriving them from the signing key if signatureVerificationKeyBytes is a
-   * zero-length vector
+   * which is extracted from the signing key when the SigningKey is constructed
    */
-  const std::vector<unsigned char> getSignatureVerificationKeyBytes() const;
+  const std::vector<unsigned char>& getSignatureVerificationKeyBytes() const;
 
   /**
    * @brief Get a SignatureVerificationKey which is used to verify
@@ -140,6 +153,37 @@ public:
     const std::vector<unsigned char> &message
   ) const;
 
+  /**
+   * @brief Sign a file of any size, reading it in chunks, with Ed25519ph
+   * (see SigningKeyStreamSigner).
+   *
+   * The signature is verified with SignatureVerificationKey::verifyFile
+   * (not SignatureVerificationKey::verify, since Ed25519ph signs a hash
+   * of the file rather than the file itself).
+   *
+   * @param path The path of the file to sign
+   * @return const std::vector<unsigned char> The signature
+   * @exception std::system_error Thrown if the file can't be read.
+   */
+  const std::vector<unsigned char> generateSignatureForFile(
+    const std::string& path
+  ) const;
+
+  /**
+   * @brief Sign a file of any size, reading it in chunks, producing a
+   * signature in the format of a minisign .minisig file (see key-formats/Minisign.hpp).
+   *
+   * @param path The path of the file to sign
+   * @param trustedComment The signed comment to include, or an empty
+   * string for minisign's default
+   * @return const std::string The contents of a .minisig file
+   * @exception std::system_error Thrown if the file can't be read.
+   */
+  const std::string generateMinisignSignatureForFile(
+    const std::string& path,
+    const std::string& trustedComment = ""
+  ) const;
+
   /**
    * @brief Serialize this object to a JSON-formatted string
    * 
@@ -41,6 +41,13 @@ SodiumBuffer::SodiumBuffer(const std::string str) : SodiumBuffer(
 SodiumBuffer::SodiumBuffer(const SodiumBuffer &other) :
     SodiumBuffer(other.length, other.data) {}
 
+SodiumBuffer::SodiumBuffer(SodiumBuffer &&other) noexcept :
+    data(other.data),
+    length(other.length)
+{
+    other.data = NULL;
+}
+
 SodiumBuffer::SodiumBuffer(const std::vector<unsigned char> &bufferData) :
     SodiumBuffer(bufferData.size(), bufferData.data()) {}
 
@@ -34,6 +34,8 @@ public:
   /**
    * @brief The length of the buffer.
    *
+   * A SodiumBuffer that has been moved from keeps its length, but its
+   * data is NULL; it must not be used except to be destroyed.
    */
   const size_t length;
 
@@ -61,6 +63,16 @@ public:
    */
   SodiumBuffer(const SodiumBuffer& other);
 
+  /**
+   * @brief Construct a new SodiumBuffer by taking ownership of the memory
+   * of a SodiumBuffer that is about to be destroyed, rather than copying it.
+   * The other SodiumBuffer is left with no data (data == NULL), which marks
+   * it as moved from; its length is unchanged.
+   *
+   * @param other
+   */
+  SodiumBuffer(SodiumBuffer&& other) noexcept;
+
   /**
     * Construct a buffer that stores a string
     */
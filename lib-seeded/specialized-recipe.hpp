@@ -0,0 +1,269 @@
+#pragma once
+
+#include <string>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "recipe.hpp"
+#include "exceptions.hpp"
+
+/**
+ * Compile-time traits used by SpecializedRecipe to mirror the
+ * defaults and validation rules of the Recipe constructor.
+ */
+namespace SpecializedRecipeTraits {
+
+  /**
+   * @brief The type string that Recipe::derivePrimarySecret
+   * places at the start of the hash preimage.
+   */
+  template <RecipeJson::type Type> struct TypeName;
+  template <> struct TypeName<RecipeJson::type::Secret> {
+    static const char* value() { return "Secret"; }
+  };
+  template <> struct TypeName<RecipeJson::type::SymmetricKey> {
+    static const char* value() { return "SymmetricKey"; }
+  };
+  template <> struct TypeName<RecipeJson::type::UnsealingKey> {
+    static const char* value() { return "UnsealingKey"; }
+  };
+  template <> struct TypeName<RecipeJson::type::SigningKey> {
+    static const char* value() { return "SigningKey"; }
+  };
+
+  /**
+   * @brief The algorithm the Recipe constructor uses when a recipe
+   * of this type does not specify one.
+   */
+  template <RecipeJson::type Type> struct DefaultAlgorithm {
+    static const RecipeJson::Algorithm value = RecipeJson::Algorithm::_INVALID_ALGORITHM_;
+  };
+  template <> struct DefaultAlgorithm<RecipeJson::type::SymmetricKey> {
+    static const RecipeJson::Algorithm value = RecipeJson::Algorithm::XSalsa20Poly1305;
+  };
+  template <> struct DefaultAlgorithm<RecipeJson::type::UnsealingKey> {
+    static const RecipeJson::Algorithm value = RecipeJson::Algorithm::X25519;
+  };
+  template <> struct DefaultAlgorithm<RecipeJson::type::SigningKey> {
+    static const RecipeJson::Algorithm value = RecipeJson::Algorithm::Ed25519;
+  };
+
+  /**
+   * @brief The lengthInBytes the Recipe constructor uses when a recipe
+   * with this algorithm does not specify one.
+   */
+  template <RecipeJson::Algorithm Algorithm> struct DefaultLengthInBytes {
+    static const size_t value = 32;
+  };
+  template <> struct DefaultLengthInBytes<RecipeJson::Algorithm::X25519> {
+    static const size_t value = crypto_box_SEEDBYTES;
+  };
+  template <> struct DefaultLengthInBytes<RecipeJson::Algorithm::XSalsa20Poly1305> {
+    static const size_t value = crypto_stream_xsalsa20_KEYBYTES;
+  };
+
+  /**
+   * @brief The lengthInBytes required for an algorithm, or 0 if any
+   * length is permitted.
+   */
+  template <RecipeJson::Algorithm Algorithm> struct RequiredLengthInBytes {
+    static const size_t value = 0;
+  };
+  template <> struct RequiredLengthInBytes<RecipeJson::Algorithm::X25519> {
+    static const size_t value = crypto_box_SEEDBYTES;
+  };
+  template <> struct RequiredLengthInBytes<RecipeJson::Algorithm::Ed25519> {
+    static const size_t value = crypto_sign_SEEDBYTES;
+  };
+  template <> struct RequiredLengthInBytes<RecipeJson::Algorithm::XSalsa20Poly1305> {
+    static const size_t value = crypto_stream_xsalsa20_KEYBYTES;
+  };
+
+  /**
+   * @brief Whether the Recipe constructor accepts this algorithm for this type.
+   */
+  template <RecipeJson::type Type, RecipeJson::Algorithm Algorithm> struct IsAlgorithmAllowed {
+    static const bool value =
+      Type == RecipeJson::type::Secret ||
+      Algorithm == DefaultAlgorithm<Type>::value;
+  };
+
+  /**
+   * @brief The hash function applied to the preimage, selected at compile time.
+   */
+  template <RecipeJson::HashFunction HashFunction> struct PreimageHash;
+  template <> struct PreimageHash<RecipeJson::HashFunction::BLAKE2b> {
+    static const SodiumBuffer derive(
+      const std::string& seedString,
+      const std::string& preimage,
+      const size_t lengthInBytes,
+      const size_t /* hashFunctionMemoryPasses */,
+      const size_t /* hashFunctionMemoryLimitInBytes */
+    ) {
+      return Recipe::hashPreimageWithBlake2b(
+        seedString,
+        (const unsigned char*) preimage.data(), preimage.length(),
+        lengthInBytes
+      );
+    }
+  };
+  template <> struct PreimageHash<RecipeJson::HashFunction::Argon2id> {
+    static const SodiumBuffer derive(
+      const std::string& seedString,
+      const std::string& preimage,
+      const size_t lengthInBytes,
+      const size_t hashFunctionMemoryPasses,
+      const size_t hashFunctionMemoryLimitInBytes
+    ) {
+      return Recipe::hashPreimageWithArgon2id(
+        seedString,
+        (const unsigned char*) preimage.data(), preimage.length(),
+        lengthInBytes,
+        hashFunctionMemoryPasses,
+        hashFunctionMemoryLimitInBytes
+      );
+    }
+  };
+}
+
+/**
+ * @brief A recipe whose parameters are fixed at compile time, for services
+ * that derive keys from recipes baked into their code.
+ *
+ * The template parameters describe the recipe's fields and are validated
+ * with static_assert against the same rules the Recipe constructor enforces,
+ * so an invalid fixed recipe fails to compile rather than throwing at runtime.
+ * The preimage (`<typeString> + <recipe>`) is built once, on construction,
+ * and derivePrimarySecret then calls the selected hash function directly:
+ * it never parses JSON and never branches on the type, algorithm,
+ * or hash function.
+ *
+ * The secret derived is identical to that of Recipe::derivePrimarySecret
+ * for the same seed and recipe string, so long as the template parameters
+ * match the fields in the recipe string, which the constructor checks
+ * by parsing the recipe once.
+ *
+ * ```cpp
+ * static const SpecializedRecipe<RecipeJson::type::SymmetricKey>
+ *   backupKeyRecipe(R"({"type":"SymmetricKey","purpose":"backups"})");
+ * const SymmetricKey key(
+ *   backupKeyRecipe.derivePrimarySecret(seedString), backupKeyRecipe.recipe
+ * );
+ * ```
+ *
+ * Password recipes are not supported, as their length depends on
+ * the word list.
+ *
+ * @tparam Type The recipe's type field (or the type required of it)
+ * @tparam HashFunction The recipe's hashFunction field
+ * @tparam LengthInBytes The recipe's lengthInBytes field
+ * @tparam Algorithm The recipe's algorithm field
+ * @tparam HashFunctionMemoryPasses The recipe's hashFunctionMemoryPasses (Argon2id only)
+ * @tparam HashFunctionMemoryLimitInBytes The recipe's hashFunctionMemoryLimitInBytes (Argon2id only)
+ *
+ * @ingroup BuildingBlocks
+ */
+template <
+  RecipeJson::type Type,
+  RecipeJson::HashFunction HashFunction = RecipeJson::HashFunction::BLAKE2b,
+  size_t LengthInBytes = SpecializedRecipeTraits::DefaultLengthInBytes<
+    SpecializedRecipeTraits::DefaultAlgorithm<Type>::value
+  >::value,
+  RecipeJson::Algorithm Algorithm = SpecializedRecipeTraits::DefaultAlgorithm<Type>::value,
+  size_t HashFunctionMemoryPasses =
+    HashFunction == RecipeJson::HashFunction::Argon2id ?
+      (size_t) Argon2idDefaults::hashFunctionMemoryPasses : 1,
+  size_t HashFunctionMemoryLimitInBytes = Argon2idDefaults::hashFunctionMemoryLimitInBytes
+>
+class SpecializedRecipe {
+  static_assert(
+    Type == RecipeJson::type::Secret ||
+    Type == RecipeJson::type::SymmetricKey ||
+    Type == RecipeJson::type::UnsealingKey ||
+    Type == RecipeJson::type::SigningKey,
+    "SpecializedRecipe supports Secret, SymmetricKey, UnsealingKey, and SigningKey recipes"
+  );
+  static_assert(
+    SpecializedRecipeTraits::IsAlgorithmAllowed<Type, Algorithm>::value,
+    "Invalid algorithm for this recipe type"
+  );
+  static_assert(
+    SpecializedRecipeTraits::RequiredLengthInBytes<Algorithm>::value == 0 ||
+    SpecializedRecipeTraits::RequiredLengthInBytes<Algorithm>::value == LengthInBytes,
+    "Invalid lengthInBytes for this algorithm"
+  );
+  static_assert(LengthInBytes > 0, "lengthInBytes must be positive");
+  static_assert(
+    HashFunction == RecipeJson::HashFunction::BLAKE2b ||
+    HashFunction == RecipeJson::HashFunction::Argon2id,
+    "Invalid hashFunction"
+  );
+
+  const std::string preimage;
+
+public:
+  /**
+   * @brief The JSON recipe string, exactly as it is hashed into the preimage
+   */
+  const std::string recipe;
+
+  /**
+   * @brief The type string at the start of the preimage
+   */
+  static const char* typeName() {
+    return SpecializedRecipeTraits::TypeName<Type>::value();
+  }
+
+  /**
+   * @brief The length of the secrets this recipe derives
+   */
+  static size_t lengthInBytes() {
+    return LengthInBytes;
+  }
+
+  /**
+   * @brief Construct from the recipe string the template parameters describe.
+   *
+   * @param recipe The recipe in @ref recipe_format, which must specify
+   * the same fields as the template parameters (or leave them to their defaults).
+   *
+   * @exception InvalidRecipeValueException Thrown if the recipe is invalid
+   * or its fields don't match the template parameters.
+   */
+  explicit SpecializedRecipe(const std::string& _recipe) :
+    preimage(std::string(typeName()) + _recipe),
+    recipe(_recipe)
+  {
+    const Recipe parsed(recipe, Type);
+    if (
+      parsed.type != Type ||
+      parsed.algorithm != Algorithm ||
+      parsed.hashFunction != HashFunction ||
+      parsed.lengthInBytes != LengthInBytes || (
+        HashFunction == RecipeJson::HashFunction::Argon2id && (
+          parsed.hashFunctionMemoryPasses != HashFunctionMemoryPasses ||
+          parsed.hashFunctionMemoryLimitInBytes != HashFunctionMemoryLimitInBytes
+        )
+      )
+    ) {
+      throw InvalidRecipeValueException("Recipe does not match the SpecializedRecipe's parameters");
+    }
+  }
+
+  /**
+   * @brief Derive the primary secret for this recipe from a seed,
+   * identical to Recipe::derivePrimarySecret(seedString, recipe, Type).
+   *
+   * @param seedString A seed value that is the primary salt for the hash function
+   */
+  const SodiumBuffer derivePrimarySecret(
+    const std::string& seedString
+  ) const {
+    return SpecializedRecipeTraits::PreimageHash<HashFunction>::derive(
+      seedString,
+      preimage,
+      LengthInBytes,
+      HashFunctionMemoryPasses,
+      HashFunctionMemoryLimitInBytes
+    );
+  }
+};
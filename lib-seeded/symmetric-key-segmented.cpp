@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include "symmetric-key-segmented.hpp"
+#include "parallel-for.hpp"
+#include "sealed-file.hpp"
+
+namespace SymmetricKeySegmentedErrors {
+  static const SeededError unsealFailed = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Symmetric key segmented unseal failed: the key or unsealing instructions must be different from those used to seal the message, or the ciphertext was modified/corrupted/truncated."
+  };
+  static const SeededError plaintextBufferTooSmall = {
+    SeededErrorCode::InvalidArgument, "Plaintext buffer too small"
+  };
+  static const SeededError rangeOutsideMessage = {
+    SeededErrorCode::InvalidArgument, "Range extends past the end of the message"
+  };
+}
+
+// The context that separates segment subkeys from other
+// values derived from the SymmetricKey's keyBytes
+static const char segmentKeyContext[] = "SymmetricKeySegmented";
+
+static void writeLittleEndian(unsigned char* out, const uint64_t value, const size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    out[i] = (unsigned char) (value >> (8 * i));
+  }
+}
+
+static uint64_t readLittleEndian(const unsigned char* in, const size_t length) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; i++) {
+    value |= ((uint64_t) in[i]) << (8 * i);
+  }
+  return value;
+}
+
+// The subkey every segment of a message is sealed with
+class SegmentKey {
+public:
+  unsigned char data[crypto_secretbox_KEYBYTES];
+
+  SegmentKey(
+    const SymmetricKey& key,
+    const unsigned char salt[crypto_secretbox_NONCEBYTES],
+    const std::string& unsealingInstructions
+  ) {
+    crypto_generichash_state st;
+    crypto_generichash_init(&st, key.keyBytes.data, key.keyBytes.length, sizeof data);
+    crypto_generichash_update(&st, (const unsigned char*) segmentKeyContext, sizeof segmentKeyContext - 1);
+    crypto_generichash_update(&st, salt, crypto_secretbox_NONCEBYTES);
+    crypto_generichash_update(&st, (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length());
+    crypto_generichash_final(&st, data, sizeof data);
+  }
+
+  ~SegmentKey() {
+    sodium_memzero(data, sizeof data);
+  }
+};
+
+// The layout of a message's segments, from its length and segment size
+struct SegmentLayout {
+  size_t messageLength;
+  size_t segmentSize;
+  size_t segmentCount;
+
+  SegmentLayout(const size_t _messageLength, const size_t _segmentSize) :
+    messageLength(_messageLength),
+    segmentSize(_segmentSize),
+    segmentCount((_messageLength + _segmentSize - 1) / _segmentSize)
+  {}
+
+  size_t plaintextOffset(const size_t index) const {
+    return index * segmentSize;
+  }
+
+  size_t plaintextLength(const size_t index) const {
+    return std::min(segmentSize, messageLength - plaintextOffset(index));
+  }
+
+  size_t ciphertextOffset(const size_t index) const {
+    return SymmetricKeySegmented::HeaderBytes +
+      index * (segmentSize + SymmetricKeySegmented::SegmentOverheadBytes);
+  }
+
+  void nonce(unsigned char nonce[crypto_secretbox_NONCEBYTES], const size_t index) const {
+    writeLittleEndian(nonce, index, 8);
+    writeLittleEndian(nonce + 8, messageLength, 8);
+    writeLittleEndian(nonce + 16, segmentSize, 4);
+    writeLittleEndian(nonce + 20, 0, 4);
+  }
+};
+
+size_t SymmetricKeySegmented::unsealedLength(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength
+) {
+  return ciphertextLength < HeaderBytes ? 0 : (size_t) readLittleEndian(ciphertext + 4, 8);
+}
+
+size_t SymmetricKeySegmented::seal(
+  const SymmetricKey& key,
+  const unsigned char* message,
+  const size_t messageLength,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
+  const std::string& unsealingInstructions,
+  const size_t segmentSize,
+  const size_t threadCount
+) {
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  if (segmentSize == 0 || segmentSize > MaxSegmentSize) {
+    throw std::invalid_argument("Invalid segment size");
+  }
+  const size_t ciphertextLength = sealedLength(messageLength, segmentSize);
+  if (ciphertextCapacity < ciphertextLength) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
+  writeLittleEndian(ciphertext, segmentSize, 4);
+  writeLittleEndian(ciphertext + 4, messageLength, 8);
+  unsigned char* salt = ciphertext + 12;
+  randombytes_buf(salt, crypto_secretbox_NONCEBYTES);
+
+  const SegmentKey segmentKey(key, salt, unsealingInstructions);
+  const SegmentLayout layout(messageLength, segmentSize);
+  parallelFor(layout.segmentCount, [&](const size_t index) {
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    layout.nonce(nonce, index);
+    crypto_secretbox_easy(
+      ciphertext + layout.ciphertextOffset(index),
+      message + layout.plaintextOffset(index), layout.plaintextLength(index),
+      nonce, segmentKey.data
+    );
+  }, threadCount);
+  return ciphertextLength;
+}
+
+std::vector<unsigned char> SymmetricKeySegmented::seal(
+  const SymmetricKey& key,
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions,
+  const size_t segmentSize,
+  const size_t threadCount
+) {
+  if (segmentSize == 0 || segmentSize > MaxSegmentSize) {
+    throw std::invalid_argument("Invalid segment size");
+  }
+  std::vector<unsigned char> ciphertext(sealedLength(messageLength, segmentSize));
+  seal(
+    key, message, messageLength, ciphertext.data(), ciphertext.size(),
+    unsealingInstructions, segmentSize, threadCount
+  );
+  return ciphertext;
+}
+
+void SymmetricKeySegmented::sealFile(
+  const SymmetricKey& key,
+  const std::string& inputPath,
+  const std::string& outputPath,
+  const std::string& unsealingInstructions,
+  const size_t segmentSize,
+  const size_t threadCount
+) {
+  const MappedFile input = SealedFile::openInput(inputPath, outputPath);
+  if (input.length() == 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  if (segmentSize == 0 || segmentSize > MaxSegmentSize) {
+    throw std::invalid_argument("Invalid segment size");
+  }
+  MappedFile output(outputPath, sealedLength(input.length(), segmentSize));
+  seal(
+    key, input.data(), input.length(), output.data(), output.length(),
+    unsealingInstructions, segmentSize, threadCount
+  );
+  output.commit();
+}
+
+// Check the header describes a message that fills the rest of the
+// ciphertext exactly, returning its message length (or 0 if it doesn't).
+static size_t checkHeader(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  size_t& segmentSize
+) {
+  if (ciphertextLength < SymmetricKeySegmented::HeaderBytes) {
+    return 0;
+  }
+  segmentSize = (size_t) readLittleEndian(ciphertext, 4);
+  const uint64_t messageLength = readLittleEndian(ciphertext + 4, 8);
+  if (
+    segmentSize == 0 || segmentSize > SymmetricKeySegmented::MaxSegmentSize ||
+    // Also rules out lengths too large for sealedLength to compute
+    messageLength == 0 || messageLength > ciphertextLength ||
+    SymmetricKeySegmented::sealedLength((size_t) messageLength, segmentSize) != ciphertextLength
+  ) {
+    return 0;
+  }
+  return (size_t) messageLength;
+}
+
+// Unseal every segment into plaintext, which has room for the whole
+// message, wiping it if any segment fails to unseal.
+static bool unsealSegments(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const SegmentLayout& layout,
+  unsigned char* plaintext,
+  const std::string& unsealingInstructions,
+  const size_t threadCount
+) {
+  const SegmentKey segmentKey(key, ciphertext + 12, unsealingInstructions);
+  std::atomic<bool> failed(false);
+  parallelFor(layout.segmentCount, [&](const size_t index) {
+    if (failed.load(std::memory_order_relaxed)) {
+      return;
+    }
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    layout.nonce(nonce, index);
+    if (crypto_secretbox_open_easy(
+      plaintext + layout.plaintextOffset(index),
+      ciphertext + layout.ciphertextOffset(index),
+      layout.plaintextLength(index) + SymmetricKeySegmented::SegmentOverheadBytes,
+      nonce, segmentKey.data
+    ) != 0) {
+      failed = true;
+    }
+  }, threadCount);
+  if (failed) {
+    sodium_memzero(plaintext, layout.messageLength);
+    return false;
+  }
+  return true;
+}
+
+Result<size_t> SymmetricKeySegmented::tryUnseal(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions,
+  const size_t threadCount
+) {
+  size_t segmentSize;
+  const size_t messageLength = checkHeader(ciphertext, ciphertextLength, segmentSize);
+  if (messageLength == 0) {
+    return SymmetricKeySegmentedErrors::unsealFailed;
+  }
+  if (plaintextCapacity < messageLength) {
+    return SymmetricKeySegmentedErrors::plaintextBufferTooSmall;
+  }
+  if (!unsealSegments(
+    key, ciphertext, SegmentLayout(messageLength, segmentSize), plaintext, unsealingInstructions, threadCount
+  )) {
+    return SymmetricKeySegmentedErrors::unsealFailed;
+  }
+  return Result<size_t>(ResultInPlace(), messageLength);
+}
+
+Result<SodiumBuffer> SymmetricKeySegmented::tryUnseal(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions,
+  const size_t threadCount
+) {
+  size_t segmentSize;
+  const size_t messageLength = checkHeader(ciphertext, ciphertextLength, segmentSize);
+  if (messageLength == 0) {
+    return SymmetricKeySegmentedErrors::unsealFailed;
+  }
+  Result<SodiumBuffer> plaintext(ResultInPlace(), messageLength);
+  if (!unsealSegments(
+    key, ciphertext, SegmentLayout(messageLength, segmentSize), plaintext.value().data, unsealingInstructions, threadCount
+  )) {
+    plaintext.fail(SymmetricKeySegmentedErrors::unsealFailed);
+  }
+  return plaintext;
+}
+
+Result<size_t> SymmetricKeySegmented::tryUnsealRange(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const size_t offset,
+  const size_t length,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) {
+  size_t segmentSize;
+  const size_t messageLength = checkHeader(ciphertext, ciphertextLength, segmentSize);
+  if (messageLength == 0) {
+    return SymmetricKeySegmentedErrors::unsealFailed;
+  }
+  if (offset > messageLength || length > messageLength - offset) {
+    return SymmetricKeySegmentedErrors::rangeOutsideMessage;
+  }
+  if (plaintextCapacity < length) {
+    return SymmetricKeySegmentedErrors::plaintextBufferTooSmall;
+  }
+  if (length == 0) {
+    return Result<size_t>(ResultInPlace(), 0);
+  }
+  const SegmentLayout layout(messageLength, segmentSize);
+  const size_t end = offset + length;
+  const size_t firstIndex = offset / segmentSize;
+  const size_t lastIndex = (end - 1) / segmentSize;
+  // The part of segment index that lies within the range
+  const auto rangeStart = [&](const size_t index) {
+    return std::max(offset, layout.plaintextOffset(index)) - layout.plaintextOffset(index);
+  };
+  const auto rangeEnd = [&](const size_t index) {
+    return std::min(end, layout.plaintextOffset(index) + layout.plaintextLength(index)) - layout.plaintextOffset(index);
+  };
+  const auto coversSegment = [&](const size_t index) {
+    return rangeStart(index) == 0 && rangeEnd(index) == layout.plaintextLength(index);
+  };
+  // Segments only partly in the range are unsealed into scratch space,
+  // and segments wholly in it straight into the plaintext
+  const SodiumBuffer scratch(coversSegment(firstIndex) && coversSegment(lastIndex) ? 0 : segmentSize);
+
+  const SegmentKey segmentKey(key, ciphertext + 12, unsealingInstructions);
+  size_t written = 0;
+  for (size_t index = firstIndex; index <= lastIndex; index++) {
+    const bool covered = coversSegment(index);
+    unsigned char nonce[crypto_secretbox_NONCEBYTES];
+    layout.nonce(nonce, index);
+    if (crypto_secretbox_open_easy(
+      covered ? plaintext + written : scratch.data,
+      ciphertext + layout.ciphertextOffset(index),
+      layout.plaintextLength(index) + SegmentOverheadBytes,
+      nonce, segmentKey.data
+    ) != 0) {
+      sodium_memzero(plaintext, length);
+      return SymmetricKeySegmentedErrors::unsealFailed;
+    }
+    const size_t rangeLength = rangeEnd(index) - rangeStart(index);
+    if (!covered) {
+      memcpy(plaintext + written, scratch.data + rangeStart(index), rangeLength);
+    }
+    written += rangeLength;
+  }
+  return Result<size_t>(ResultInPlace(), written);
+}
+
+size_t SymmetricKeySegmented::unsealRange(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const size_t offset,
+  const size_t length,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) {
+  return tryUnsealRange(
+    key, ciphertext, ciphertextLength, offset, length, plaintext, plaintextCapacity, unsealingInstructions
+  ).valueOrThrow();
+}
+
+SodiumBuffer SymmetricKeySegmented::unseal(
+  const SymmetricKey& key,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions,
+  const size_t threadCount
+) {
+  return tryUnseal(key, ciphertext, ciphertextLength, unsealingInstructions, threadCount).valueOrThrow();
+}
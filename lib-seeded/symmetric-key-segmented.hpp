@@ -0,0 +1,300 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "result.hpp"
+#include "symmetric-key.hpp"
+
+/**
+ * @brief Seals and unseals large in-memory messages with a SymmetricKey
+ * by splitting them into independently authenticated segments, which are
+ * sealed and unsealed concurrently on all cores.
+ *
+ * A segmented ciphertext is a header followed by one sealed segment for
+ * each segmentSize bytes of the message (the last may be shorter):
+ * ```
+ *   <segmentSize: 4 bytes, little endian> <messageLength: 8 bytes, little endian>
+ *   <salt: 24 random bytes>
+ *   <segment 0> <segment 1> ... <segment n-1>
+ * ```
+ * Each segment is a crypto_secretbox_easy box, 16 bytes longer than the
+ * part of the message it contains, sealed with a subkey derived from the
+ * SymmetricKey, the salt, and the unsealingInstructions:
+ * ```
+ *   BLAKE2b(key: keyBytes, message: "SymmetricKeySegmented" <salt> <unsealingInstructions>)
+ * ```
+ * and with a nonce that encodes the segment's index, the message length,
+ * and the segment size:
+ * ```
+ *   <index: 8 bytes LE> <messageLength: 8 bytes LE> <segmentSize: 4 bytes LE> <0: 4 bytes>
+ * ```
+ * So a segment fails to unseal if it is moved, if segments are removed
+ * or added, or if the header is modified, and the random salt ensures
+ * no two messages share a subkey.
+ *
+ * Since every segment but the last holds exactly segmentSize bytes of the
+ * message, the header is all the index needed to find the segments that
+ * hold any byte range, and unsealRange unseals just those segments.
+ * The header needs no seal of its own: the subkey depends on its salt,
+ * and every nonce on its message length and segment size, so a modified
+ * header makes every segment fail to unseal. For a segmented ciphertext
+ * stored in a file (see sealFile), open it with MappedFile so that reading
+ * a range only reads the pages holding its segments.
+ *
+ * The format (and algorithm) is the same whatever algorithm the key's
+ * recipe specifies, and differs from that of SymmetricKey::seal.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+namespace SymmetricKeySegmented {
+  /**
+   * @brief The length of the header
+   */
+  const size_t HeaderBytes = 4 + 8 + crypto_secretbox_NONCEBYTES;
+  /**
+   * @brief The number of bytes each segment adds to the part of the message it contains
+   */
+  const size_t SegmentOverheadBytes = crypto_secretbox_MACBYTES;
+  /**
+   * @brief The segment size used unless another is specified, which is large
+   * enough that per-segment costs are negligible and small enough that a
+   * message of a few megabytes is spread across cores
+   */
+  const size_t DefaultSegmentSize = 1024 * 1024;
+  /**
+   * @brief The largest segment size that may be used
+   */
+  const size_t MaxSegmentSize = 256 * 1024 * 1024;
+
+  /**
+   * @brief The length of the segmented ciphertext of a message of a given length
+   */
+  inline size_t sealedLength(const size_t messageLength, const size_t segmentSize = DefaultSegmentSize) {
+    return HeaderBytes + messageLength +
+      ((messageLength + segmentSize - 1) / segmentSize) * SegmentOverheadBytes;
+  }
+
+  /**
+   * @brief The length of the message in a segmented ciphertext, as
+   * given by its header, or 0 if the ciphertext is too short to have one.
+   * Use it to size the buffer to unseal into; unsealing checks it.
+   */
+  size_t unsealedLength(const unsigned char* ciphertext, const size_t ciphertextLength);
+
+  /**
+   * @brief Seal a message into a buffer the caller provides.
+   *
+   * @param key The key to seal with
+   * @param message The message to seal
+   * @param messageLength The length of the message in bytes
+   * @param ciphertext The buffer to write the segmented ciphertext into
+   * @param ciphertextCapacity The size of the ciphertext buffer, which must
+   * be at least sealedLength(messageLength, segmentSize)
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @param segmentSize The length of message sealed in each segment
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   * @return size_t The number of bytes written to ciphertext
+   *
+   * @exception std::invalid_argument Thrown if the message is empty, the segment
+   * size is 0 or greater than MaxSegmentSize, or the ciphertext buffer is too small.
+   */
+  size_t seal(
+    const SymmetricKey& key,
+    const unsigned char* message,
+    const size_t messageLength,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {},
+    const size_t segmentSize = DefaultSegmentSize,
+    const size_t threadCount = 0
+  );
+
+  /**
+   * @brief Seal a message.
+   *
+   * @param key The key to seal with
+   * @param message The message to seal
+   * @param messageLength The length of the message in bytes
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @param segmentSize The length of message sealed in each segment
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   * @return std::vector<unsigned char> The segmented ciphertext
+   *
+   * @exception std::invalid_argument Thrown if the message is empty or the segment
+   * size is 0 or greater than MaxSegmentSize.
+   */
+  std::vector<unsigned char> seal(
+    const SymmetricKey& key,
+    const unsigned char* message,
+    const size_t messageLength,
+    const std::string& unsealingInstructions = {},
+    const size_t segmentSize = DefaultSegmentSize,
+    const size_t threadCount = 0
+  );
+
+  /**
+   * @brief Seal a file into another file holding its segmented ciphertext,
+   * mapping both into memory so the segments are sealed straight from one
+   * to the other.
+   *
+   * @param key The key to seal with
+   * @param inputPath The path of the file to seal, which must not be empty
+   * @param outputPath The path of the file to create (or overwrite),
+   * which must not be the input file
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the file.
+   * @param segmentSize The length of message sealed in each segment
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   *
+   * @exception std::invalid_argument Thrown if the input file is empty or is
+   * the output file, or the segment size is 0 or greater than MaxSegmentSize.
+   * @exception std::system_error Thrown if either file can't be opened or written.
+   */
+  void sealFile(
+    const SymmetricKey& key,
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::string& unsealingInstructions = {},
+    const size_t segmentSize = DefaultSegmentSize,
+    const size_t threadCount = 0
+  );
+
+  /**
+   * @brief Unseal a segmented ciphertext into a buffer the caller
+   * provides, without throwing.
+   *
+   * If any segment fails to unseal, nothing is left in the buffer.
+   *
+   * @param key The key the message was sealed with
+   * @param ciphertext The segmented ciphertext
+   * @param ciphertextLength The length of the segmented ciphertext
+   * @param plaintext The buffer to write the message into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least unsealedLength(ciphertext, ciphertextLength)
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   * @return Result<size_t> The number of bytes written to plaintext,
+   * or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const SymmetricKey& key,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {},
+    const size_t threadCount = 0
+  );
+
+  /**
+   * @brief Unseal a segmented ciphertext without throwing.
+   *
+   * @param key The key the message was sealed with
+   * @param ciphertext The segmented ciphertext
+   * @param ciphertextLength The length of the segmented ciphertext
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   * @return Result<SodiumBuffer> The message, or the error unseal
+   * would have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const SymmetricKey& key,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const std::string& unsealingInstructions = {},
+    const size_t threadCount = 0
+  );
+
+  /**
+   * @brief Unseal part of a message from its segmented ciphertext,
+   * into a buffer the caller provides, without throwing.
+   *
+   * Only the segments that hold the range are read and unsealed.
+   * If any of them fails to unseal, nothing is left in the buffer.
+   *
+   * @param key The key the message was sealed with
+   * @param ciphertext The segmented ciphertext
+   * @param ciphertextLength The length of the segmented ciphertext
+   * @param offset The offset in the message of the first byte to unseal
+   * @param length The number of bytes to unseal, which must not
+   * extend past the end of the message
+   * @param plaintext The buffer to write the bytes into
+   * @param plaintextCapacity The size of the plaintext buffer, which
+   * must be at least length
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written to plaintext (length),
+   * or the error unsealRange would have thrown.
+   */
+  Result<size_t> tryUnsealRange(
+    const SymmetricKey& key,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const size_t offset,
+    const size_t length,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief Unseal part of a message from its segmented ciphertext,
+   * into a buffer the caller provides.
+   *
+   * @param key The key the message was sealed with
+   * @param ciphertext The segmented ciphertext
+   * @param ciphertextLength The length of the segmented ciphertext
+   * @param offset The offset in the message of the first byte to unseal
+   * @param length The number of bytes to unseal
+   * @param plaintext The buffer to write the bytes into
+   * @param plaintextCapacity The size of the plaintext buffer
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written to plaintext (length)
+   *
+   * @exception CryptographicVerificationFailureException Thrown if a segment
+   * holding the range is not authentic, or was sealed with a different key
+   * or unsealingInstructions.
+   * @exception std::invalid_argument Thrown if the range extends past the
+   * end of the message or the plaintext buffer is too small.
+   */
+  size_t unsealRange(
+    const SymmetricKey& key,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const size_t offset,
+    const size_t length,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  );
+
+  /**
+   * @brief Unseal a segmented ciphertext.
+   *
+   * @param key The key the message was sealed with
+   * @param ciphertext The segmented ciphertext
+   * @param ciphertextLength The length of the segmented ciphertext
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @param threadCount The maximum number of threads to use, or 0 for one per core
+   * @return SodiumBuffer The message
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not authentic, or was sealed with a different key or unsealingInstructions.
+   */
+  SodiumBuffer unseal(
+    const SymmetricKey& key,
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const std::string& unsealingInstructions = {},
+    const size_t threadCount = 0
+  );
+}
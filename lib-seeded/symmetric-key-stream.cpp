@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "symmetric-key-stream.hpp"
+#include "exceptions.hpp"
+
+// The personalization that separates the stream subkey from other
+// values derived from the SymmetricKey's keyBytes
+static const char streamKeyContext[] = "SymmetricKeyStream";
+
+static void deriveStreamKey(
+  unsigned char streamKey[crypto_secretstream_xchacha20poly1305_KEYBYTES],
+  const SymmetricKey& key
+) {
+  crypto_generichash(
+    streamKey, crypto_secretstream_xchacha20poly1305_KEYBYTES,
+    (const unsigned char*) streamKeyContext, sizeof streamKeyContext - 1,
+    key.keyBytes.data, key.keyBytes.length
+  );
+}
+
+static void hashUnsealingInstructions(
+  unsigned char hash[crypto_generichash_BYTES],
+  const std::string& unsealingInstructions
+) {
+  crypto_generichash(
+    hash, crypto_generichash_BYTES,
+    (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length(),
+    NULL, 0
+  );
+}
+
+// The associated data authenticated with every chunk:
+//   <chunkSize: 4 bytes, little endian> <BLAKE2b hash of the unsealingInstructions>
+static std::vector<unsigned char> chunkAssociatedData(
+  const size_t chunkSize,
+  const unsigned char unsealingInstructionsHash[crypto_generichash_BYTES]
+) {
+  std::vector<unsigned char> associatedData(4 + crypto_generichash_BYTES);
+  for (size_t i = 0; i < 4; i++) {
+    associatedData[i] = (unsigned char) (chunkSize >> (8 * i));
+  }
+  memcpy(associatedData.data() + 4, unsealingInstructionsHash, crypto_generichash_BYTES);
+  return associatedData;
+}
+
+/////
+//  SymmetricKeyStreamSealer
+////
+
+static size_t validChunkSize(const size_t chunkSize) {
+  if (chunkSize == 0 || chunkSize > SymmetricKeyStream::MaxChunkSize) {
+    throw std::invalid_argument("Invalid stream chunk size");
+  }
+  return chunkSize;
+}
+
+SymmetricKeyStreamSealer::SymmetricKeyStreamSealer(
+  const SymmetricKey& key,
+  const std::string& unsealingInstructions,
+  const SymmetricKeyStreamOutput& _output,
+  const size_t _chunkSize
+) :
+  output(_output),
+  chunkSize(validChunkSize(_chunkSize)),
+  plaintextChunk(chunkSize)
+{
+  ciphertextChunk.resize(chunkSize + SymmetricKeyStream::ChunkOverheadBytes);
+
+  unsigned char unsealingInstructionsHash[crypto_generichash_BYTES];
+  hashUnsealingInstructions(unsealingInstructionsHash, unsealingInstructions);
+  associatedData = chunkAssociatedData(chunkSize, unsealingInstructionsHash);
+
+  for (size_t i = 0; i < 4; i++) {
+    header[i] = associatedData[i];
+  }
+  unsigned char streamKey[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+  deriveStreamKey(streamKey, key);
+  crypto_secretstream_xchacha20poly1305_init_push(&state, header + 4, streamKey);
+  sodium_memzero(streamKey, sizeof streamKey);
+}
+
+SymmetricKeyStreamSealer::~SymmetricKeyStreamSealer() {
+  sodium_memzero(&state, sizeof state);
+}
+
+void SymmetricKeyStreamSealer::init() {
+  if (initialized) {
+    throw std::logic_error("Stream already started");
+  }
+  initialized = true;
+  output(header, sizeof header);
+}
+
+void SymmetricKeyStreamSealer::sealChunk(
+  const unsigned char* plaintext,
+  const size_t length,
+  const unsigned char tag
+) {
+  unsigned long long ciphertextLength;
+  crypto_secretstream_xchacha20poly1305_push(
+    &state, ciphertextChunk.data(), &ciphertextLength,
+    plaintext, length,
+    associatedData.data(), associatedData.size(),
+    tag
+  );
+  output(ciphertextChunk.data(), (size_t) ciphertextLength);
+}
+
+void SymmetricKeyStreamSealer::update(
+  const unsigned char* plaintext,
+  const size_t length
+) {
+  if (!initialized || finalized) {
+    throw std::logic_error("Stream update must come between init and final");
+  }
+  size_t offset = 0;
+  while (offset < length) {
+    if (plaintextChunkLength == 0 && length - offset >= chunkSize) {
+      // Seal whole chunks directly from the caller's buffer
+      sealChunk(plaintext + offset, chunkSize, crypto_secretstream_xchacha20poly1305_TAG_MESSAGE);
+      offset += chunkSize;
+      continue;
+    }
+    const size_t toCopy = std::min(length - offset, chunkSize - plaintextChunkLength);
+    memcpy(plaintextChunk.data + plaintextChunkLength, plaintext + offset, toCopy);
+    plaintextChunkLength += toCopy;
+    offset += toCopy;
+    if (plaintextChunkLength == chunkSize) {
+      sealChunk(plaintextChunk.data, chunkSize, crypto_secretstream_xchacha20poly1305_TAG_MESSAGE);
+      plaintextChunkLength = 0;
+    }
+  }
+}
+
+void SymmetricKeyStreamSealer::final() {
+  if (!initialized || finalized) {
+    throw std::logic_error("Stream final must come once, after init");
+  }
+  finalized = true;
+  sealChunk(plaintextChunk.data, plaintextChunkLength, crypto_secretstream_xchacha20poly1305_TAG_FINAL);
+  plaintextChunkLength = 0;
+  sodium_memzero(&state, sizeof state);
+}
+
+/////
+//  SymmetricKeyStreamUnsealer
+////
+
+SymmetricKeyStreamUnsealer::SymmetricKeyStreamUnsealer(
+  const SymmetricKey& key,
+  const std::string& unsealingInstructions,
+  const SymmetricKeyStreamOutput& _output
+) : output(_output) {
+  deriveStreamKey(streamKey, key);
+  hashUnsealingInstructions(unsealingInstructionsHash, unsealingInstructions);
+  pending.reserve(SymmetricKeyStream::HeaderBytes);
+}
+
+SymmetricKeyStreamUnsealer::~SymmetricKeyStreamUnsealer() {
+  sodium_memzero(streamKey, sizeof streamKey);
+  sodium_memzero(&state, sizeof state);
+}
+
+void SymmetricKeyStreamUnsealer::fail() {
+  failed = true;
+  sodium_memzero(&state, sizeof state);
+  throw CryptographicVerificationFailureException(
+    "Symmetric key stream unseal failed: the key or unsealing instructions must be different from those used to seal the stream, or the stream was modified/corrupted/truncated."
+  );
+}
+
+void SymmetricKeyStreamUnsealer::start(const unsigned char* header) {
+  chunkSize = 0;
+  for (size_t i = 0; i < 4; i++) {
+    chunkSize |= ((size_t) header[i]) << (8 * i);
+  }
+  if (chunkSize == 0 || chunkSize > SymmetricKeyStream::MaxChunkSize) {
+    fail();
+  }
+  if (crypto_secretstream_xchacha20poly1305_init_pull(&state, header + 4, streamKey) != 0) {
+    fail();
+  }
+  sodium_memzero(streamKey, sizeof streamKey);
+  associatedData = chunkAssociatedData(chunkSize, unsealingInstructionsHash);
+  plaintextChunk.reset(new SodiumBuffer(chunkSize));
+  pending.reserve(chunkSize + SymmetricKeyStream::ChunkOverheadBytes);
+  started = true;
+}
+
+void SymmetricKeyStreamUnsealer::unsealChunk(
+  const unsigned char* ciphertext,
+  const size_t length,
+  const bool isFinal
+) {
+  unsigned long long plaintextLength;
+  unsigned char tag;
+  if (
+    length < SymmetricKeyStream::ChunkOverheadBytes ||
+    crypto_secretstream_xchacha20poly1305_pull(
+      &state, plaintextChunk->data, &plaintextLength, &tag,
+      ciphertext, length,
+      associatedData.data(), associatedData.size()
+    ) != 0 ||
+    // Only the last chunk, which is shorter than the others, may be final
+    (tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL) != isFinal
+  ) {
+    fail();
+  }
+  output(plaintextChunk->data, (size_t) plaintextLength);
+}
+
+void SymmetricKeyStreamUnsealer::update(
+  const unsigned char* ciphertext,
+  const size_t length
+) {
+  if (failed || finalized) {
+    fail();
+  }
+  size_t offset = 0;
+  if (!started) {
+    const size_t toCopy = std::min(length, SymmetricKeyStream::HeaderBytes - pending.size());
+    pending.insert(pending.end(), ciphertext, ciphertext + toCopy);
+    offset += toCopy;
+    if (pending.size() < SymmetricKeyStream::HeaderBytes) {
+      return;
+    }
+    start(pending.data());
+    pending.clear();
+  }
+  const size_t fullChunkLength = chunkSize + SymmetricKeyStream::ChunkOverheadBytes;
+  while (offset < length) {
+    if (pending.size() == 0 && length - offset >= fullChunkLength) {
+      // Unseal whole chunks directly from the caller's buffer
+      unsealChunk(ciphertext + offset, fullChunkLength, false);
+      offset += fullChunkLength;
+      continue;
+    }
+    const size_t toCopy = std::min(length - offset, fullChunkLength - pending.size());
+    pending.insert(pending.end(), ciphertext + offset, ciphertext + offset + toCopy);
+    offset += toCopy;
+    if (pending.size() == fullChunkLength) {
+      unsealChunk(pending.data(), fullChunkLength, false);
+      pending.clear();
+    }
+  }
+}
+
+void SymmetricKeyStreamUnsealer::final() {
+  if (failed || finalized || !started) {
+    fail();
+  }
+  unsealChunk(pending.data(), pending.size(), true);
+  pending.clear();
+  finalized = true;
+  sodium_memzero(&state, sizeof state);
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sodium.h"
+#include "sodium-buffer.hpp"
+#include "symmetric-key.hpp"
+
+/**
+ * @brief Receives the output of a SymmetricKeyStreamSealer or
+ * SymmetricKeyStreamUnsealer as it is produced.
+ *
+ * The data is only valid for the duration of the call.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+typedef std::function<void(const unsigned char* data, const size_t length)> SymmetricKeyStreamOutput;
+
+/**
+ * @brief Constants of the SymmetricKey stream format shared
+ * by SymmetricKeyStreamSealer and SymmetricKeyStreamUnsealer.
+ *
+ * A sealed stream is a header followed by a sequence of chunks:
+ * ```
+ *   <chunkSize: 4 bytes, little endian> <secretstream header: 24 bytes>
+ *   <chunk> <chunk> ... <final chunk>
+ * ```
+ * Each chunk is a libsodium crypto_secretstream_xchacha20poly1305 message,
+ * which is 17 bytes longer than the plaintext it contains. Every chunk but
+ * the last holds exactly chunkSize bytes of plaintext; the last holds
+ * fewer (possibly none) and is tagged as final, so a stream that has been
+ * truncated, extended, or reordered fails to unseal.
+ *
+ * The stream is encrypted with a subkey derived from the SymmetricKey,
+ * and every chunk is authenticated together with the chunk size and a
+ * hash of the unsealingInstructions, so the same key and instructions
+ * must be used to unseal it.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+namespace SymmetricKeyStream {
+  /**
+   * @brief The length of the stream header
+   */
+  const size_t HeaderBytes = 4 + crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+  /**
+   * @brief The number of bytes each chunk adds to the plaintext it contains
+   */
+  const size_t ChunkOverheadBytes = crypto_secretstream_xchacha20poly1305_ABYTES;
+  /**
+   * @brief The plaintext chunk size used unless another is specified
+   */
+  const size_t DefaultChunkSize = 64 * 1024;
+  /**
+   * @brief The largest chunk size that may be sealed or unsealed, which
+   * bounds the memory an unsealer will allocate for a stream it's given
+   */
+  const size_t MaxChunkSize = 16 * 1024 * 1024;
+  /**
+   * @brief The length of a sealed stream of a given plaintext length
+   */
+  inline size_t sealedLength(const size_t plaintextLength, const size_t chunkSize = DefaultChunkSize) {
+    return HeaderBytes + plaintextLength + (plaintextLength / chunkSize + 1) * ChunkOverheadBytes;
+  }
+}
+
+/**
+ * @brief Seals a message of any length, incrementally and in constant memory,
+ * with a SymmetricKey.
+ *
+ * Call init to write the stream header, update with each part of
+ * the plaintext as it becomes available, and final once all of it has been
+ * passed. The sealed stream is passed to the output function as it is
+ * produced, one chunk at a time, so that neither the plaintext nor the
+ * ciphertext ever needs to be held in memory in full.
+ *
+ * ```cpp
+ * SymmetricKeyStreamSealer sealer(key, "backup",
+ *   [&](const unsigned char* data, const size_t length) { out.write((const char*) data, length); }
+ * );
+ * sealer.init();
+ * while (in.read((char*) buffer, sizeof buffer) || in.gcount() > 0) {
+ *   sealer.update(buffer, in.gcount());
+ * }
+ * sealer.final();
+ * ```
+ *
+ * Streams are unsealed with SymmetricKeyStreamUnsealer. Their format
+ * (see SymmetricKeyStream) differs from that of SymmetricKey::seal,
+ * and their nonces are random, so sealing the same stream twice
+ * produces different ciphertexts.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class SymmetricKeyStreamSealer {
+  crypto_secretstream_xchacha20poly1305_state state;
+  unsigned char header[SymmetricKeyStream::HeaderBytes];
+  std::vector<unsigned char> associatedData;
+  const SymmetricKeyStreamOutput output;
+  const size_t chunkSize;
+  SodiumBuffer plaintextChunk;
+  size_t plaintextChunkLength = 0;
+  std::vector<unsigned char> ciphertextChunk;
+  bool initialized = false;
+  bool finalized = false;
+
+  void sealChunk(const unsigned char* plaintext, const size_t length, const unsigned char tag);
+
+public:
+  /**
+   * @brief Prepare to seal a stream
+   *
+   * @param key The key to seal with
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the stream.
+   * @param output The function to pass the sealed stream to
+   * @param chunkSize The length of plaintext sealed in each chunk
+   * @throws std::invalid_argument if the chunk size is 0 or
+   * greater than SymmetricKeyStream::MaxChunkSize
+   */
+  SymmetricKeyStreamSealer(
+    const SymmetricKey& key,
+    const std::string& unsealingInstructions,
+    const SymmetricKeyStreamOutput& output,
+    const size_t chunkSize = SymmetricKeyStream::DefaultChunkSize
+  );
+
+  ~SymmetricKeyStreamSealer();
+
+  SymmetricKeyStreamSealer(const SymmetricKeyStreamSealer&) = delete;
+  SymmetricKeyStreamSealer& operator=(const SymmetricKeyStreamSealer&) = delete;
+
+  /**
+   * @brief Start the stream, writing its header to the output
+   *
+   * @throws std::logic_error if the stream has already been started
+   */
+  void init();
+
+  /**
+   * @brief Seal the next part of the plaintext, writing each chunk
+   * to the output as it fills.
+   *
+   * @throws std::logic_error if called before init or after final
+   */
+  void update(const unsigned char* plaintext, const size_t length);
+
+  /**
+   * @brief Seal the rest of the plaintext as the final chunk and
+   * write it to the output.
+   *
+   * @throws std::logic_error if called before init or after final
+   */
+  void final();
+};
+
+/**
+ * @brief Unseals a stream sealed by SymmetricKeyStreamSealer,
+ * incrementally and in constant memory.
+ *
+ * Pass the sealed stream to update, in parts of any length, and call
+ * final once all of it has been passed. Each chunk's plaintext is passed
+ * to the output as soon as the chunk has been authenticated, so the
+ * output receives authentic plaintext before the end of the stream is
+ * reached. A stream that was cut short is only detected by final, so
+ * don't act on the plaintext until final has returned.
+ *
+ * @ingroup DerivedFromSeeds
+ */
+class SymmetricKeyStreamUnsealer {
+  crypto_secretstream_xchacha20poly1305_state state;
+  std::vector<unsigned char> associatedData;
+  unsigned char streamKey[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+  unsigned char unsealingInstructionsHash[crypto_generichash_BYTES];
+  const SymmetricKeyStreamOutput output;
+  size_t chunkSize = 0;
+  std::vector<unsigned char> pending;
+  std::unique_ptr<SodiumBuffer> plaintextChunk;
+  bool started = false;
+  bool finalized = false;
+  bool failed = false;
+
+  [[noreturn]] void fail();
+  void start(const unsigned char* header);
+  void unsealChunk(const unsigned char* ciphertext, const size_t length, const bool isFinal);
+
+public:
+  /**
+   * @brief Prepare to unseal a stream
+   *
+   * @param key The key the stream was sealed with
+   * @param unsealingInstructions The unsealingInstructions the stream
+   * was sealed with, if any.
+   * @param output The function to pass the plaintext to
+   */
+  SymmetricKeyStreamUnsealer(
+    const SymmetricKey& key,
+    const std::string& unsealingInstructions,
+    const SymmetricKeyStreamOutput& output
+  );
+
+  ~SymmetricKeyStreamUnsealer();
+
+  SymmetricKeyStreamUnsealer(const SymmetricKeyStreamUnsealer&) = delete;
+  SymmetricKeyStreamUnsealer& operator=(const SymmetricKeyStreamUnsealer&) = delete;
+
+  /**
+   * @brief Unseal the next part of the sealed stream, writing the
+   * plaintext of each chunk to the output once it is authenticated.
+   *
+   * @throws CryptographicVerificationFailureException if the stream
+   * is not authentic, was sealed with a different key or
+   * unsealingInstructions, or continues past its final chunk
+   */
+  void update(const unsigned char* ciphertext, const size_t length);
+
+  /**
+   * @brief Finish unsealing the stream, writing the plaintext
+   * of its final chunk to the output.
+   *
+   * @throws CryptographicVerificationFailureException if the stream
+   * is not authentic or was truncated
+   */
+  void final();
+};
@@ -1,40 +1,158 @@
+#include <algorithm>
 #include <exception>
+#include <utility>
+#include <vector>
 #include "symmetric-key.hpp"
 #include "packaged-sealed-message.hpp"
 #include "recipe.hpp"
 #include "exceptions.hpp"
 #include "common-names.hpp"
+#include "convert.hpp"
+#include "json-fields.hpp"
+#include "crypto_secretbox_verified_open.h"
+#include "crypto_fragments.h"
+#include "sealed-file.hpp"
 
-void _crypto_secretbox_nonce_salted(
+// The nonce is BLAKE2b(key: secret_key, message: <salt> <message>),
+// where the message may be split into fragments.
+static void _crypto_secretbox_nonce_salted_fragments(
   unsigned char *nonce,
-  const unsigned char *secret_key,
-  const unsigned char *message,
-  const size_t message_length,
+  const SodiumBuffer& secret_key,
+  const Fragment* message_fragments,
+  const size_t fragment_count,
   const char* salt,
   const size_t salt_length
 ) {
     crypto_generichash_state st;
-    crypto_generichash_init(&st, secret_key, crypto_box_SECRETKEYBYTES, crypto_box_NONCEBYTES);
-//    crypto_generichash_update(&st, secret_key, crypto_box_SECRETKEYBYTES);
+    crypto_generichash_init(&st, secret_key.data, secret_key.length, crypto_box_NONCEBYTES);
     if (salt_length > 0) {
       crypto_generichash_update(&st, (const unsigned char*) salt, salt_length);
     }
-    crypto_generichash_update(&st, message, message_length);
+    for (size_t i = 0; i < fragment_count; i++) {
+      crypto_generichash_update(&st, message_fragments[i].data, message_fragments[i].length);
+    }
     crypto_generichash_final(&st, nonce, crypto_box_NONCEBYTES);
+    sodium_memzero(&st, sizeof st);
+}
+
+void _crypto_secretbox_nonce_salted(
+  unsigned char *nonce,
+  const SodiumBuffer& secret_key,
+  const unsigned char *message,
+  const size_t message_length,
+  const char* salt,
+  const size_t salt_length
+) {
+    const Fragment message_fragment = {message, message_length};
+    _crypto_secretbox_nonce_salted_fragments(nonce, secret_key, &message_fragment, 1, salt, salt_length);
+}
+
+// The context that separates random-nonce message keys from other
+// values derived from the SymmetricKey's keyBytes
+static const char randomNonceKeyContext[] = "SymmetricKeyRandomNonce";
+
+// The key a message's secret box is sealed with.
+// With synthetic nonces, the nonce is derived from the unsealingInstructions
+// and so binds them to the message, and the box is sealed with keyBytes.
+// With random nonces, the box is sealed with a subkey that binds the
+// message to its unsealingInstructions, as XSalsa20Poly1305 has no
+// associated data:
+//   BLAKE2b(key: keyBytes, message: "SymmetricKeyRandomNonce" <unsealingInstructions>)
+class SecretBoxKey {
+  unsigned char subkey[crypto_secretbox_KEYBYTES];
+
+public:
+  const unsigned char* data;
+
+  SecretBoxKey(
+    const SodiumBuffer& keyBytes,
+    const bool randomNonce,
+    const std::string& unsealingInstructions
+  ) : data(keyBytes.data) {
+    if (randomNonce) {
+      crypto_generichash_state st;
+      crypto_generichash_init(&st, keyBytes.data, keyBytes.length, sizeof subkey);
+      crypto_generichash_update(&st, (const unsigned char*) randomNonceKeyContext, sizeof randomNonceKeyContext - 1);
+      crypto_generichash_update(&st, (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length());
+      crypto_generichash_final(&st, subkey, sizeof subkey);
+      sodium_memzero(&st, sizeof st);
+      data = subkey;
+    }
+  }
+
+  ~SecretBoxKey() {
+    sodium_memzero(subkey, sizeof subkey);
+  }
+};
+
+static const char aes256GcmUnavailable[] =
+  "AES256GCM requires a CPU with AES-NI and PCLMUL instructions, which this one lacks";
+
+// The length of the nonce that precedes the sealed message in the ciphertext
+static size_t nonceBytes(const RecipeJson::Algorithm algorithm) {
+  return
+    algorithm == RecipeJson::Algorithm::AES256GCM ? crypto_aead_aes256gcm_NPUBBYTES :
+    algorithm == RecipeJson::Algorithm::XChaCha20Poly1305 ? crypto_aead_xchacha20poly1305_ietf_NPUBBYTES :
+    crypto_secretbox_NONCEBYTES;
+}
+
+// The length of the authentication tag added to the sealed message
+static size_t macBytes(const RecipeJson::Algorithm algorithm) {
+  return
+    algorithm == RecipeJson::Algorithm::AES256GCM ? crypto_aead_aes256gcm_ABYTES :
+    algorithm == RecipeJson::Algorithm::XChaCha20Poly1305 ? crypto_aead_xchacha20poly1305_ietf_ABYTES :
+    crypto_secretbox_MACBYTES;
+}
+
+// The AES256GCM state for keyBytes, or NULL if needed is false or the
+// CPU can't run AES256GCM.  Its 512-byte length keeps the buffer
+// sodium_malloc places at the end of a page aligned as the state requires.
+static SodiumBuffer* aes256GcmStateFor(
+  const bool needed,
+  const SodiumBuffer& keyBytes
+) {
+  if (!needed || keyBytes.length != crypto_aead_aes256gcm_KEYBYTES || !crypto_aead_aes256gcm_is_available()) {
+    return NULL;
+  }
+  SodiumBuffer* state = new SodiumBuffer(sizeof(crypto_aead_aes256gcm_state));
+  crypto_aead_aes256gcm_beforenm((crypto_aead_aes256gcm_state*) state->data, keyBytes.data);
+  return state;
 }
 
 SymmetricKey::SymmetricKey(
   const SodiumBuffer& _keyBytes,
-  const std::string _recipe
-) : keyBytes(_keyBytes), recipe(_recipe) {
+  const std::string& _recipe,
+  const Result<Recipe>& parsedRecipe
+) :
+  keyBytes(_keyBytes),
+  recipe(_recipe),
+  // Keys whose recipes don't parse can only have been constructed
+  // from their keyBytes, and seal with the original algorithm.
+  algorithm(parsedRecipe.ok() ?
+    parsedRecipe.value().algorithm : RecipeJson::Algorithm::XSalsa20Poly1305),
+  nonceType(parsedRecipe.ok() ?
+    parsedRecipe.value().nonceType : RecipeJson::NonceType::Synthetic),
+  aes256GcmState(aes256GcmStateFor(algorithm == RecipeJson::Algorithm::AES256GCM, keyBytes))
+{
   if (keyBytes.length != crypto_secretbox_KEYBYTES) {
     throw std::invalid_argument("Invalid key length");
   }
 }
 
+SymmetricKey::SymmetricKey(
+  const SodiumBuffer& _keyBytes,
+  const std::string _recipe
+) : SymmetricKey(_keyBytes, _recipe, Recipe::tryParse(_recipe, RecipeJson::type::SymmetricKey)) {}
+
 SymmetricKey::SymmetricKey(
   const SymmetricKey &other
-) : SymmetricKey(other.keyBytes, other.recipe) {}
+) :
+  keyBytes(other.keyBytes),
+  recipe(other.recipe),
+  algorithm(other.algorithm),
+  nonceType(other.nonceType),
+  aes256GcmState(other.aes256GcmState ? new SodiumBuffer(*other.aes256GcmState) : NULL)
+  {}
 
 SymmetricKey::SymmetricKey(
   const std::string& seedString,
@@ -56,34 +174,155 @@ SymmetricKey SymmetricKey::deriveFromSeed(
   );
 }
 
-const std::vector<unsigned char> SymmetricKey::sealToCiphertextOnly(
+size_t SymmetricKey::sealedLength(const size_t messageLength) const {
+  return nonceBytes(algorithm) + messageLength + macBytes(algorithm);
+}
+
+size_t SymmetricKey::unsealedLength(const size_t ciphertextLength) const {
+  const size_t overhead = nonceBytes(algorithm) + macBytes(algorithm);
+  return ciphertextLength > overhead ? ciphertextLength - overhead : 0;
+}
+
+size_t SymmetricKey::sealToCiphertextOnly(
   const unsigned char* message,
   const size_t messageLength,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
   const std::string& unsealingInstructions
 ) const {
   if (messageLength <= 0) {
     throw std::invalid_argument("Invalid message length");
   }
-  const size_t ciphertextLength =
-    crypto_secretbox_NONCEBYTES + messageLength + crypto_secretbox_MACBYTES;
-  std::vector<unsigned char> ciphertext(ciphertextLength);
-  unsigned char* noncePtr = ciphertext.data();
+  const size_t ciphertextLength = sealedLength(messageLength);
+  if (ciphertextCapacity < ciphertextLength) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
+  const bool randomNonce = nonceType == RecipeJson::NonceType::Random;
+  unsigned char* noncePtr = ciphertext;
+
+  if (algorithm != RecipeJson::Algorithm::XSalsa20Poly1305) {
+    // An AEAD, which authenticates the unsealingInstructions as associated data
+    const size_t aeadNonceBytes = nonceBytes(algorithm);
+    if (algorithm == RecipeJson::Algorithm::AES256GCM && !crypto_aead_aes256gcm_is_available()) {
+      throw AlgorithmUnavailableException(aes256GcmUnavailable);
+    }
+    if (randomNonce) {
+      randombytes_buf(noncePtr, aeadNonceBytes);
+    } else {
+      // Use the (leading bytes of the) nonce XSalsa20Poly1305 would use
+      unsigned char syntheticNonce[crypto_secretbox_NONCEBYTES];
+      _crypto_secretbox_nonce_salted(
+        syntheticNonce, keyBytes, message, messageLength,
+        unsealingInstructions.c_str(), unsealingInstructions.length());
+      memcpy(noncePtr, syntheticNonce, aeadNonceBytes);
+    }
+    const unsigned char* ad = (const unsigned char*) unsealingInstructions.data();
+    if (algorithm == RecipeJson::Algorithm::AES256GCM) {
+      crypto_aead_aes256gcm_encrypt_afternm(
+        noncePtr + aeadNonceBytes, NULL, message, messageLength,
+        ad, unsealingInstructions.length(),
+        NULL, noncePtr, (const crypto_aead_aes256gcm_state*) aes256GcmState->data
+      );
+    } else {
+      crypto_aead_xchacha20poly1305_ietf_encrypt(
+        noncePtr + aeadNonceBytes, NULL, message, messageLength,
+        ad, unsealingInstructions.length(),
+        NULL, noncePtr, keyBytes.data
+      );
+    }
+    return ciphertextLength;
+  }
+
   unsigned char* secretBoxStartPtr = noncePtr + crypto_secretbox_NONCEBYTES;
 
-  // Write a nonce derived from the message and symmeetric key
-  _crypto_secretbox_nonce_salted(
-    noncePtr, keyBytes.data, message, messageLength,
-    unsealingInstructions.c_str(), unsealingInstructions.length());
+  if (randomNonce) {
+    randombytes_buf(noncePtr, crypto_secretbox_NONCEBYTES);
+  } else {
+    // Write a nonce derived from the message and symmeetric key
+    _crypto_secretbox_nonce_salted(
+      noncePtr, keyBytes, message, messageLength,
+      unsealingInstructions.c_str(), unsealingInstructions.length());
+  }
   
   // Create the ciphertext as a secret box
+  const SecretBoxKey secretBoxKey(keyBytes, randomNonce, unsealingInstructions);
   crypto_secretbox_easy(
     secretBoxStartPtr,
     message,
     messageLength,
     noncePtr,
-    keyBytes.data
+    secretBoxKey.data
   );
 
+  return ciphertextLength;
+}
+
+size_t SymmetricKey::sealToCiphertextOnly(
+  const Fragment* messageFragments,
+  const size_t fragmentCount,
+  unsigned char* ciphertext,
+  const size_t ciphertextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  const size_t messageLength = Fragments::totalLength(messageFragments, fragmentCount);
+  if (algorithm == RecipeJson::Algorithm::AES256GCM) {
+    // LibSodium's AES-GCM can't be fed incrementally
+    SodiumBuffer message(messageLength);
+    Fragments::gather(message.data, messageFragments, fragmentCount, 0, messageLength);
+    return sealToCiphertextOnly(message.data, messageLength, ciphertext, ciphertextCapacity, unsealingInstructions);
+  }
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  const size_t ciphertextLength = sealedLength(messageLength);
+  if (ciphertextCapacity < ciphertextLength) {
+    throw std::invalid_argument("Ciphertext buffer too small");
+  }
+  const bool randomNonce = nonceType == RecipeJson::NonceType::Random;
+  unsigned char* noncePtr = ciphertext;
+
+  if (algorithm == RecipeJson::Algorithm::XChaCha20Poly1305) {
+    if (randomNonce) {
+      randombytes_buf(noncePtr, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+    } else {
+      unsigned char syntheticNonce[crypto_secretbox_NONCEBYTES];
+      _crypto_secretbox_nonce_salted_fragments(
+        syntheticNonce, keyBytes, messageFragments, fragmentCount,
+        unsealingInstructions.c_str(), unsealingInstructions.length());
+      memcpy(noncePtr, syntheticNonce, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+    }
+    crypto_aead_xchacha20poly1305_ietf_encrypt_fragments(
+      noncePtr + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, messageFragments, fragmentCount,
+      (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length(),
+      noncePtr, keyBytes.data
+    );
+    return ciphertextLength;
+  }
+
+  if (randomNonce) {
+    randombytes_buf(noncePtr, crypto_secretbox_NONCEBYTES);
+  } else {
+    _crypto_secretbox_nonce_salted_fragments(
+      noncePtr, keyBytes, messageFragments, fragmentCount,
+      unsealingInstructions.c_str(), unsealingInstructions.length());
+  }
+  const SecretBoxKey secretBoxKey(keyBytes, randomNonce, unsealingInstructions);
+  crypto_secretbox_easy_fragments(
+    noncePtr + crypto_secretbox_NONCEBYTES, messageFragments, fragmentCount, noncePtr, secretBoxKey.data
+  );
+  return ciphertextLength;
+}
+
+const std::vector<unsigned char> SymmetricKey::sealToCiphertextOnly(
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions
+) const {
+  if (messageLength <= 0) {
+    throw std::invalid_argument("Invalid message length");
+  }
+  std::vector<unsigned char> ciphertext(sealedLength(messageLength));
+  sealToCiphertextOnly(message, messageLength, ciphertext.data(), ciphertext.size(), unsealingInstructions);
   return ciphertext;
 }
 
@@ -98,11 +337,7 @@ const PackagedSealedMessage SymmetricKey::seal(
   const SodiumBuffer& message,
   const std::string& unsealingInstructions
 ) const {
-  return PackagedSealedMessage(
-    sealToCiphertextOnly(message, unsealingInstructions),
-    recipe,
-    unsealingInstructions
-  );
+  return seal(message.data, message.length, unsealingInstructions);
 }
 
   const PackagedSealedMessage SymmetricKey::seal(
@@ -117,11 +352,7 @@ const PackagedSealedMessage SymmetricKey::seal(
   const std::vector<unsigned char>& message,
   const std::string& unsealingInstructions
 ) const {
-    return PackagedSealedMessage( 
-      sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions),
-      recipe,
-      unsealingInstructions
-  );
+    return seal(message.data(), message.size(), unsealingInstructions);
 }
 
 
@@ -130,48 +361,481 @@ const PackagedSealedMessage SymmetricKey::seal(
   const size_t messageLength,
   const std::string& unsealingInstructions
 ) const {
-    return PackagedSealedMessage( 
-      sealToCiphertextOnly(message, messageLength, unsealingInstructions),
-      recipe,
-      unsealingInstructions
+  // Move the ciphertext into the package rather than copying it
+  std::vector<unsigned char> ciphertext(sealToCiphertextOnly(message, messageLength, unsealingInstructions));
+  return PackagedSealedMessage(std::move(ciphertext), recipe, unsealingInstructions);
+}
+
+// The context that separates key IDs from other
+// values derived from the SymmetricKey's keyBytes
+static const char keyIdContext[] = "SymmetricKeyId";
+
+const std::vector<unsigned char> SymmetricKey::keyId() const {
+  std::vector<unsigned char> id(PackagedSealedMessage::KeyIdBytes);
+  crypto_generichash(
+    id.data(), id.size(),
+    (const unsigned char*) keyIdContext, sizeof keyIdContext - 1,
+    keyBytes.data, keyBytes.length
   );
+  return id;
 }
 
-const SodiumBuffer SymmetricKey::unsealMessageContents(
+const PackagedSealedMessage SymmetricKey::sealWithKeyId(
+  const unsigned char* message,
+  const size_t messageLength,
+  const std::string& unsealingInstructions
+) const {
+  std::vector<unsigned char> ciphertext(sealToCiphertextOnly(message, messageLength, unsealingInstructions));
+  return PackagedSealedMessage(std::move(ciphertext), recipe, unsealingInstructions, keyId());
+}
+
+const PackagedSealedMessage SymmetricKey::sealWithKeyId(
+  const std::vector<unsigned char>& message,
+  const std::string& unsealingInstructions
+) const {
+  return sealWithKeyId(message.data(), message.size(), unsealingInstructions);
+}
+
+namespace SymmetricKeyErrors {
+  static const SeededError invalidMessageLength = {
+    SeededErrorCode::InvalidArgument, "Invalid message length"
+  };
+  static const SeededError unsealFailed = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Symmetric key unseal failed: the key or unsealing instructions must be different from those used to seal the message, or the ciphertext was modified/corrupted."
+  };
+  static const SeededError invalidKeyLength = {
+    SeededErrorCode::InvalidArgument, "Invalid key length"
+  };
+  static const SeededError plaintextBufferTooSmall = {
+    SeededErrorCode::InvalidArgument, "Plaintext buffer too small"
+  };
+  static const SeededError algorithmUnavailable = {
+    SeededErrorCode::AlgorithmUnavailable, aes256GcmUnavailable
+  };
+}
+
+// Recalculate the synthetic nonce from an unsealed plaintext to validate
+// that the provided unsealingInstructions are those it was sealed with,
+// wiping the plaintext if they aren't.
+static bool syntheticNonceMatches(
+  unsigned char* plaintext,
+  const size_t plaintextLength,
+  const unsigned char* nonce,
+  const SodiumBuffer& keyBytes,
+  const std::string& unsealingInstructions
+) {
+  unsigned char recalculatedNonce[crypto_secretbox_NONCEBYTES];
+  _crypto_secretbox_nonce_salted(
+    recalculatedNonce, keyBytes, plaintext, plaintextLength,
+    unsealingInstructions.c_str(), unsealingInstructions.length()
+  );
+  if (memcmp(recalculatedNonce, nonce, crypto_secretbox_NONCEBYTES) != 0) {
+    sodium_memzero(plaintext, plaintextLength);
+    return false;
+  }
+  return true;
+}
+
+// As syntheticNonceMatches, for a plaintext written across fragments
+static bool syntheticNonceMatches(
+  const OutputFragment* plaintextFragments,
+  const size_t plaintextFragmentCount,
+  const size_t plaintextLength,
+  const unsigned char* nonce,
+  const SodiumBuffer& keyBytes,
+  const std::string& unsealingInstructions
+) {
+  std::vector<Fragment> plaintext;
+  Fragments::forEachPiece(plaintextFragments, plaintextFragmentCount, 0, plaintextLength,
+    [&plaintext](unsigned char* data, const size_t length, const size_t) {
+      plaintext.push_back({data, length});
+    }
+  );
+  unsigned char recalculatedNonce[crypto_secretbox_NONCEBYTES];
+  _crypto_secretbox_nonce_salted_fragments(
+    recalculatedNonce, keyBytes, plaintext.data(), plaintext.size(),
+    unsealingInstructions.c_str(), unsealingInstructions.length()
+  );
+  if (memcmp(recalculatedNonce, nonce, crypto_secretbox_NONCEBYTES) != 0) {
+    Fragments::forEachPiece(plaintextFragments, plaintextFragmentCount, 0, plaintextLength,
+      [](unsigned char* data, const size_t length, const size_t) {
+        sodium_memzero(data, length);
+      }
+    );
+    return false;
+  }
+  return true;
+}
+
+// Unseal a secret box that has already been verified into a plaintext
+// buffer of exactly the right length.  If the nonce was synthetic, check
+// that it matches the one that sealing would have derived from the
+// plaintext and unsealingInstructions, wiping the plaintext on failure.
+static bool openVerified(
+  unsigned char* plaintext,
   const unsigned char* ciphertext,
   const size_t ciphertextLength,
+  const SecretBoxKey& secretBoxKey,
+  const SodiumBuffer& keyBytes,
+  const bool randomNonce,
   const std::string& unsealingInstructions
-) const {
+) {
+  const unsigned char* noncePtr = ciphertext;
+  const unsigned char* secretBoxStartPtr = noncePtr + crypto_secretbox_NONCEBYTES;
+  const size_t secretBoxLength = ciphertextLength - crypto_secretbox_NONCEBYTES;
+  const size_t plaintextLength = secretBoxLength - crypto_secretbox_MACBYTES;
+  crypto_secretbox_easy_open_verified(
+    plaintext, secretBoxStartPtr, secretBoxLength, noncePtr, secretBoxKey.data
+  );
+  return randomNonce ||
+    // The secret box key has already authenticated the unsealingInstructions
+    syntheticNonceMatches(plaintext, plaintextLength, noncePtr, keyBytes, unsealingInstructions);
+}
+
+// Authenticate before allocating or writing, as failure is the
+// common case when trying messages against keys.
+static SeededError verifySealedMessage(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const SecretBoxKey& secretBoxKey
+) {
   if (ciphertextLength <= (crypto_secretbox_MACBYTES + crypto_secretbox_NONCEBYTES)) {
-    throw std::invalid_argument("Invalid message length");
+    return SymmetricKeyErrors::invalidMessageLength;
   }
-  SodiumBuffer plaintextBuffer(ciphertextLength - (crypto_secretbox_MACBYTES + crypto_secretbox_NONCEBYTES));
   const unsigned char* noncePtr = ciphertext;
-  const unsigned char* secretBoxStartPtr = noncePtr + crypto_secretbox_NONCEBYTES;
+  if (crypto_secretbox_easy_verify(
+    noncePtr + crypto_secretbox_NONCEBYTES, ciphertextLength - crypto_secretbox_NONCEBYTES, noncePtr, secretBoxKey.data
+  ) != 0) {
+    return SymmetricKeyErrors::unsealFailed;
+  }
+  return {SeededErrorCode::None, NULL};
+}
 
-  const int result = crypto_secretbox_open_easy(
-    plaintextBuffer.data,
-    secretBoxStartPtr,
-        ciphertextLength - crypto_secretbox_NONCEBYTES,
-    noncePtr,
-    keyBytes.data
-      );
-   if (result != 0) {
-     throw CryptographicVerificationFailureException("Symmetric key unseal failed: the key or unsealing instructions must be different from those used to seal the message, or the ciphertext was modified/corrupted.");
-   }
+static SeededError checkAeadCiphertext(
+  const RecipeJson::Algorithm algorithm,
+  const size_t ciphertextLength
+) {
+  if (ciphertextLength <= nonceBytes(algorithm) + macBytes(algorithm)) {
+    return SymmetricKeyErrors::invalidMessageLength;
+  }
+  if (algorithm == RecipeJson::Algorithm::AES256GCM && !crypto_aead_aes256gcm_is_available()) {
+    return SymmetricKeyErrors::algorithmUnavailable;
+  }
+  return {SeededErrorCode::None, NULL};
+}
 
-  // Recalculate nonce to validate that the provided
-  // unsealingInstructions is valid 
-  unsigned char recalculatedNonce[crypto_secretbox_NONCEBYTES];
-  _crypto_secretbox_nonce_salted(
-    recalculatedNonce, keyBytes.data, plaintextBuffer.data, plaintextBuffer.length,
-    unsealingInstructions.c_str(), unsealingInstructions.length()
+// Unlike the secret box, the AEADs authenticate the unsealingInstructions
+// as associated data, so there's no nonce to re-derive after decrypting.
+// If the ciphertext or unsealingInstructions aren't authentic, nothing
+// is left in the plaintext.
+static bool openAead(
+  const RecipeJson::Algorithm algorithm,
+  unsigned char* plaintext,
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const SodiumBuffer& keyBytes,
+  const SodiumBuffer* aes256GcmState,
+  const std::string& unsealingInstructions
+) {
+  const size_t aeadNonceBytes = nonceBytes(algorithm);
+  const unsigned char* ad = (const unsigned char*) unsealingInstructions.data();
+  if (algorithm == RecipeJson::Algorithm::AES256GCM) {
+    return crypto_aead_aes256gcm_decrypt_afternm(
+      plaintext, NULL, NULL,
+      ciphertext + aeadNonceBytes, ciphertextLength - aeadNonceBytes,
+      ad, unsealingInstructions.length(),
+      ciphertext, (const crypto_aead_aes256gcm_state*) aes256GcmState->data
+    ) == 0;
+  }
+  return crypto_aead_xchacha20poly1305_ietf_decrypt(
+    plaintext, NULL, NULL,
+    ciphertext + aeadNonceBytes, ciphertextLength - aeadNonceBytes,
+    ad, unsealingInstructions.length(),
+    ciphertext, keyBytes.data
+  ) == 0;
+}
+
+Result<SodiumBuffer> SymmetricKey::tryUnseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions
+) const {
+  if (algorithm != RecipeJson::Algorithm::XSalsa20Poly1305) {
+    const SeededError error = checkAeadCiphertext(algorithm, ciphertextLength);
+    if (error) {
+      return error;
+    }
+    Result<SodiumBuffer> plaintext(ResultInPlace(), unsealedLength(ciphertextLength));
+    if (!openAead(algorithm, plaintext.value().data, ciphertext, ciphertextLength, keyBytes, aes256GcmState.get(), unsealingInstructions)) {
+      plaintext.fail(SymmetricKeyErrors::unsealFailed);
+    }
+    return plaintext;
+  }
+  const bool randomNonce = nonceType == RecipeJson::NonceType::Random;
+  const SecretBoxKey secretBoxKey(keyBytes, randomNonce, unsealingInstructions);
+  const SeededError error = verifySealedMessage(ciphertext, ciphertextLength, secretBoxKey);
+  if (error) {
+    return error;
+  }
+  Result<SodiumBuffer> plaintext(ResultInPlace(), unsealedLength(ciphertextLength));
+  if (!openVerified(
+    plaintext.value().data, ciphertext, ciphertextLength, secretBoxKey, keyBytes, randomNonce, unsealingInstructions
+  )) {
+    plaintext.fail(SymmetricKeyErrors::unsealFailed);
+  }
+  return plaintext;
+}
+
+Result<size_t> SymmetricKey::tryUnseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  if (algorithm != RecipeJson::Algorithm::XSalsa20Poly1305) {
+    const SeededError error = checkAeadCiphertext(algorithm, ciphertextLength);
+    if (error) {
+      return error;
+    }
+    const size_t plaintextLength = unsealedLength(ciphertextLength);
+    if (plaintextCapacity < plaintextLength) {
+      return SymmetricKeyErrors::plaintextBufferTooSmall;
+    }
+    if (!openAead(algorithm, plaintext, ciphertext, ciphertextLength, keyBytes, aes256GcmState.get(), unsealingInstructions)) {
+      return SymmetricKeyErrors::unsealFailed;
+    }
+    return Result<size_t>(ResultInPlace(), plaintextLength);
+  }
+  const bool randomNonce = nonceType == RecipeJson::NonceType::Random;
+  const SecretBoxKey secretBoxKey(keyBytes, randomNonce, unsealingInstructions);
+  const SeededError error = verifySealedMessage(ciphertext, ciphertextLength, secretBoxKey);
+  if (error) {
+    return error;
+  }
+  const size_t plaintextLength = unsealedLength(ciphertextLength);
+  if (plaintextCapacity < plaintextLength) {
+    return SymmetricKeyErrors::plaintextBufferTooSmall;
+  }
+  if (!openVerified(
+    plaintext, ciphertext, ciphertextLength, secretBoxKey, keyBytes, randomNonce, unsealingInstructions
+  )) {
+    return SymmetricKeyErrors::unsealFailed;
+  }
+  return Result<size_t>(ResultInPlace(), plaintextLength);
+}
+
+size_t SymmetricKey::unseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext, ciphertextLength, plaintext, plaintextCapacity, unsealingInstructions).valueOrThrow();
+}
+
+Result<size_t> SymmetricKey::tryUnseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  if (algorithm == RecipeJson::Algorithm::AES256GCM) {
+    // LibSodium's AES-GCM can't be fed incrementally
+    const size_t ciphertextLength = Fragments::totalLength(ciphertextFragments, fragmentCount);
+    SodiumBuffer ciphertext(ciphertextLength);
+    Fragments::gather(ciphertext.data, ciphertextFragments, fragmentCount, 0, ciphertextLength);
+    return tryUnseal(ciphertext.data, ciphertextLength, plaintext, plaintextCapacity, unsealingInstructions);
+  }
+  const OutputFragment plaintextFragment = {plaintext, plaintextCapacity};
+  return tryUnseal(ciphertextFragments, fragmentCount, &plaintextFragment, 1, unsealingInstructions);
+}
+
+Result<size_t> SymmetricKey::tryUnseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  const OutputFragment* plaintextFragments,
+  const size_t plaintextFragmentCount,
+  const std::string& unsealingInstructions
+) const {
+  const size_t ciphertextLength = Fragments::totalLength(ciphertextFragments, fragmentCount);
+  const size_t plaintextCapacity = Fragments::totalLength(plaintextFragments, plaintextFragmentCount);
+  if (algorithm == RecipeJson::Algorithm::AES256GCM) {
+    // LibSodium's AES-GCM can't be fed incrementally, or write across
+    // buffers, so the plaintext is unsealed into locked memory and
+    // copied out from there
+    SodiumBuffer ciphertext(ciphertextLength);
+    Fragments::gather(ciphertext.data, ciphertextFragments, fragmentCount, 0, ciphertextLength);
+    SodiumBuffer plaintext(std::min(plaintextCapacity, ciphertextLength));
+    const Result<size_t> plaintextLength =
+      tryUnseal(ciphertext.data, ciphertextLength, plaintext.data, plaintext.length, unsealingInstructions);
+    if (plaintextLength.ok()) {
+      Fragments::scatter(plaintextFragments, plaintextFragmentCount, 0, plaintext.data, plaintextLength.value());
+    }
+    return plaintextLength;
+  }
+  const size_t nonceLength = nonceBytes(algorithm);
+  if (ciphertextLength <= nonceLength + macBytes(algorithm)) {
+    return SymmetricKeyErrors::invalidMessageLength;
+  }
+  unsigned char nonce[crypto_secretbox_NONCEBYTES];
+  Fragments::gather(nonce, ciphertextFragments, fragmentCount, 0, nonceLength);
+  const size_t plaintextLength = unsealedLength(ciphertextLength);
+
+  if (algorithm == RecipeJson::Algorithm::XChaCha20Poly1305) {
+    if (plaintextCapacity < plaintextLength) {
+      return SymmetricKeyErrors::plaintextBufferTooSmall;
+    }
+    if (crypto_aead_xchacha20poly1305_ietf_decrypt_fragments(
+      plaintextFragments, plaintextFragmentCount,
+      ciphertextFragments, fragmentCount, nonceLength, ciphertextLength - nonceLength,
+      (const unsigned char*) unsealingInstructions.data(), unsealingInstructions.length(),
+      nonce, keyBytes.data
+    ) != 0) {
+      return SymmetricKeyErrors::unsealFailed;
+    }
+    return Result<size_t>(ResultInPlace(), plaintextLength);
+  }
+
+  const bool randomNonce = nonceType == RecipeJson::NonceType::Random;
+  const SecretBoxKey secretBoxKey(keyBytes, randomNonce, unsealingInstructions);
+  const size_t secretBoxLength = ciphertextLength - crypto_secretbox_NONCEBYTES;
+  if (crypto_secretbox_easy_verify_fragments(
+    ciphertextFragments, fragmentCount, crypto_secretbox_NONCEBYTES, secretBoxLength, nonce, secretBoxKey.data
+  ) != 0) {
+    return SymmetricKeyErrors::unsealFailed;
+  }
+  if (plaintextCapacity < plaintextLength) {
+    return SymmetricKeyErrors::plaintextBufferTooSmall;
+  }
+  crypto_secretbox_easy_open_verified_fragments(
+    plaintextFragments, plaintextFragmentCount,
+    ciphertextFragments, fragmentCount, crypto_secretbox_NONCEBYTES, secretBoxLength, nonce, secretBoxKey.data
   );
-  if (memcmp(recalculatedNonce, noncePtr, crypto_secretbox_NONCEBYTES) != 0) {
-     throw CryptographicVerificationFailureException("Symmetric key unseal failed: the key or unsealing instructions must be different from those used to seal the message, or the ciphertext was modified/corrupted.");
+  if (!randomNonce && !syntheticNonceMatches(
+    plaintextFragments, plaintextFragmentCount, plaintextLength, nonce, keyBytes, unsealingInstructions
+  )) {
+    return SymmetricKeyErrors::unsealFailed;
+  }
+  return Result<size_t>(ResultInPlace(), plaintextLength);
+}
+
+size_t SymmetricKey::unseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertextFragments, fragmentCount, plaintext, plaintextCapacity, unsealingInstructions).valueOrThrow();
+}
+
+size_t SymmetricKey::unseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  const OutputFragment* plaintextFragments,
+  const size_t plaintextFragmentCount,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(
+    ciphertextFragments, fragmentCount, plaintextFragments, plaintextFragmentCount, unsealingInstructions
+  ).valueOrThrow();
+}
+
+void SymmetricKey::sealFile(
+  const std::string& inputPath,
+  const std::string& outputPath,
+  const std::string& unsealingInstructions
+) const {
+  const MappedFile input = SealedFile::openInput(inputPath, outputPath);
+  if (input.length() == 0) {
+    throw std::invalid_argument("Invalid message length");
   }
+  const size_t ciphertextLength = sealedLength(input.length());
+  MappedFile output(outputPath, SealedFile::length(ciphertextLength, recipe, unsealingInstructions));
+  sealToCiphertextOnly(
+    input.data(), input.length(),
+    SealedFile::writeAllButCiphertext(output, ciphertextLength, recipe, unsealingInstructions), ciphertextLength,
+    unsealingInstructions
+  );
+  output.commit();
+}
+
+const std::string SymmetricKey::unsealFile(
+  const std::string& inputPath,
+  const std::string& outputPath
+) const {
+  const MappedFile input = SealedFile::openInput(inputPath, outputPath);
+  const SealedFile::Contents contents = SealedFile::read(input);
+  MappedFile output(outputPath, unsealedLength(contents.ciphertextLength));
+  unseal(contents.ciphertext, contents.ciphertextLength, output.data(), output.length(), contents.unsealingInstructions);
+  output.commit();
+  return contents.unsealingInstructions;
+}
+
+/* static */ const std::string SymmetricKey::unsealFile(
+  const std::string& inputPath,
+  const std::string& outputPath,
+  const std::string& seedString
+) {
+  const std::string recipe = SealedFile::read(MappedFile(inputPath)).recipe;
+  return SymmetricKey::deriveFromSeed(seedString, recipe).unsealFile(inputPath, outputPath);
+}
+
+SealedBatch SymmetricKey::sealBatch(
+  const BatchMessage* messages,
+  const size_t count,
+  const size_t threadCount
+) const {
+  return MessageBatch::seal(messages, count, MessageBatch::onThreads(threadCount),
+    [this](const size_t messageLength) { return sealedLength(messageLength); },
+    [this](const BatchMessage& message, unsigned char* ciphertext, const size_t ciphertextCapacity) {
+      sealToCiphertextOnly(
+        message.data, message.length, ciphertext, ciphertextCapacity,
+        MessageBatch::unsealingInstructions(message)
+      );
+    }
+  );
+}
+
+UnsealedBatch SymmetricKey::unsealBatch(
+  const BatchMessage* ciphertexts,
+  const size_t count,
+  const size_t threadCount
+) const {
+  return MessageBatch::unseal(ciphertexts, count, MessageBatch::onThreads(threadCount),
+    [this](const size_t ciphertextLength) { return unsealedLength(ciphertextLength); },
+    [this](const BatchMessage& ciphertext, unsigned char* plaintext, const size_t plaintextCapacity) {
+      return tryUnseal(
+        ciphertext.data, ciphertext.length, plaintext, plaintextCapacity,
+        MessageBatch::unsealingInstructions(ciphertext)
+      );
+    }
+  );
+}
+
+Result<SodiumBuffer> SymmetricKey::tryUnseal(
+  const std::vector<unsigned char> &ciphertext,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext.data(), ciphertext.size(), unsealingInstructions);
+}
+
+Result<SodiumBuffer> SymmetricKey::tryUnseal(
+  const PackagedSealedMessage &packagedSealedMessage
+) const {
+  return tryUnseal(packagedSealedMessage.ciphertext, packagedSealedMessage.unsealingInstructions);
+}
 
-  return plaintextBuffer;
+const SodiumBuffer SymmetricKey::unsealMessageContents(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext, ciphertextLength, unsealingInstructions).valueOrThrow();
 }
 
 const SodiumBuffer SymmetricKey::unseal(
@@ -209,18 +873,33 @@ namespace SymmetricKeyJsonField {
   static const std::string recipe = CommonNames::recipe;
 }
 
-SymmetricKey SymmetricKey::fromJson(
+Result<SymmetricKey> SymmetricKey::tryFromJson(
   const std::string& symmetricKeyAsJson
 ) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(symmetricKeyAsJson);
-    return SymmetricKey(
-      SodiumBuffer::fromHexString(jsonObject.at(SymmetricKeyJsonField::keyBytes)),
-      jsonObject.value(SymmetricKeyJsonField::recipe, "")
-    );
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(symmetricKeyAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* keyBytesHex = JsonFields::requiredString(jsonObject, SymmetricKeyJsonField::keyBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, SymmetricKeyJsonField::recipe);
+  if (keyBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
   }
+  const SeededError hexError = hexStrError(*keyBytesHex);
+  if (hexError) {
+    return hexError;
+  }
+  const SodiumBuffer keyBytes = SodiumBuffer::fromHexString(*keyBytesHex);
+  if (keyBytes.length != crypto_secretbox_KEYBYTES) {
+    return SymmetricKeyErrors::invalidKeyLength;
+  }
+  return Result<SymmetricKey>(ResultInPlace(), keyBytes, *recipe);
+}
+
+SymmetricKey SymmetricKey::fromJson(
+  const std::string& symmetricKeyAsJson
+) {
+  return tryFromJson(symmetricKeyAsJson).valueOrThrow();
 }
 
 const std::string SymmetricKey::toJson(
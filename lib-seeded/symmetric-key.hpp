@@ -1,8 +1,13 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include "sodium-buffer.hpp"
 #include "packaged-sealed-message.hpp"
+#include "result.hpp"
+#include "recipe.hpp"
+#include "message-batch.hpp"
+#include "fragments.hpp"
 
 /**
  * @brief A SymmetricKey can be used to seal and unseal messages.
@@ -34,6 +39,29 @@
  * the composite ciphertext is is 40 bytes longer than the message length
  * (24 for then nonce, plus the 16 added to create the secret box)
  * 
+ * By default the nonce is synthetic: it is derived from the key, the message,
+ * and the unsealingInstructions, so sealing is deterministic but takes two
+ * passes over the message (as does unsealing, which must re-derive the nonce).
+ * If the recipe sets `"nonceType": "Random"`, the nonce is random and the
+ * unsealingInstructions are bound to the message by sealing it with a subkey
+ * derived from them, so sealing and unsealing each take a single pass.
+ * The ciphertext format is the same in both modes, but a message must be
+ * unsealed by a key whose recipe has the same nonceType.
+ * 
+ * If the recipe sets `"algorithm": "XChaCha20Poly1305"`, messages are sealed
+ * with LibSodium's crypto_aead_xchacha20poly1305_ietf AEAD instead, with the
+ * unsealingInstructions as associated data, so unsealing never re-derives the
+ * nonce from the message. The ciphertext is the 24-byte nonce followed by the
+ * AEAD ciphertext and its 16-byte tag (40 bytes longer than the message).
+ * 
+ * If the recipe sets `"algorithm": "AES256GCM"`, messages are sealed with
+ * LibSodium's crypto_aead_aes256gcm, also with the unsealingInstructions
+ * as associated data. The ciphertext is the 12-byte nonce followed by the
+ * AES-GCM ciphertext and its 16-byte tag (28 bytes longer than the message).
+ * AES256GCM requires a CPU with AES-NI and PCLMUL instructions; elsewhere,
+ * sealing and unsealing with such a key throws AlgorithmUnavailableException.
+ * There is no fallback, as no other algorithm could unseal the messages.
+ * 
  * @ingroup DerivedFromSeeds
  */
 class SymmetricKey {
@@ -49,6 +77,30 @@ class SymmetricKey {
    */
   const std::string recipe;
 
+  /**
+   * @brief The algorithm the recipe specifies for sealing messages
+   * (XSalsa20Poly1305 if the recipe doesn't parse)
+   */
+  const RecipeJson::Algorithm algorithm;
+  /**
+   * @brief How the recipe specifies each message's nonce is generated
+   * (Synthetic if the recipe doesn't parse)
+   */
+  const RecipeJson::NonceType nonceType;
+
+  private:
+  // The expanded AES key and GHASH key, precomputed from keyBytes in
+  // locked memory so that each seal and unseal skips the key schedule.
+  // NULL unless the algorithm is AES256GCM and the CPU can run it.
+  const std::unique_ptr<SodiumBuffer> aes256GcmState;
+
+  SymmetricKey(
+    const SodiumBuffer& keyBytes,
+    const std::string& recipe,
+    const Result<Recipe>& parsedRecipe
+  );
+
+  public:
   /**
    * @brief Construct a SymmetricKey from its members
    */
@@ -124,6 +176,72 @@ class SymmetricKey {
     const std::string& unsealingInstructions = {}
   ) const;
 
+  /**
+   * @brief The length of the ciphertext produced by sealing a message
+   * of a given length with this key (the message length plus 40 bytes,
+   * or 28 bytes for AES256GCM).
+   */
+  size_t sealedLength(const size_t messageLength) const;
+
+  /**
+   * @brief The length of the plaintext contained in a ciphertext of a
+   * given length, or 0 if the ciphertext is too short to be valid.
+   */
+  size_t unsealedLength(const size_t ciphertextLength) const;
+
+  /**
+   * @brief Seal a plaintext message into a buffer the caller provides,
+   * without allocating.
+   * 
+   * @param message The plaintxt message to seal 
+   * @param messageLength The length of the plaintext message in bytes
+   * @param ciphertext The buffer to write the sealed _ciphertext_ into
+   * @param ciphertextCapacity The size of the ciphertext buffer, which must
+   * be at least sealedLength(messageLength)
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return size_t The number of bytes written to ciphertext
+   * 
+   * @exception std::invalid_argument Thrown if the message is empty or
+   * the ciphertext buffer is too small.
+   */
+  size_t sealToCiphertextOnly(
+    const unsigned char* message,
+    const size_t messageLength,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a message held in non-contiguous fragments into a buffer
+   * the caller provides, without first copying the fragments together.
+   *
+   * The ciphertext is the one sealToCiphertextOnly would produce
+   * for the concatenation of the fragments.
+   * (LibSodium has no incremental AES-GCM, so for AES256GCM keys the
+   * fragments are copied into locked memory and sealed from there.)
+   *
+   * @param messageFragments The fragments of the plaintext message
+   * @param fragmentCount The number of fragments
+   * @param ciphertext The buffer to write the sealed _ciphertext_ into
+   * @param ciphertextCapacity The size of the ciphertext buffer, which must
+   * be at least sealedLength of the fragments' total length
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return size_t The number of bytes written to ciphertext
+   *
+   * @exception std::invalid_argument Thrown if the message is empty or
+   * the ciphertext buffer is too small.
+   */
+  size_t sealToCiphertextOnly(
+    const Fragment* messageFragments,
+    const size_t fragmentCount,
+    unsigned char* ciphertext,
+    const size_t ciphertextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
   /**
    * @brief Seal a plaintext message
    * 
@@ -213,6 +331,49 @@ class SymmetricKey {
     const std::string& unsealingInstructions = {}
   ) const;
 
+  /**
+   * @brief A short identifier of this key (PackagedSealedMessage::KeyIdBytes
+   * long) for a Keyring to index it by.
+   *
+   * It is a BLAKE2b hash keyed with the keyBytes, so it reveals nothing
+   * about them, and only holders of the key can tell which key it identifies.
+   */
+  const std::vector<unsigned char> keyId() const;
+
+  /**
+   * @brief Seal a plaintext message and package it along with its recipe,
+   * unsealingInstructions, and this key's keyId, so that a Keyring
+   * holding this key can find it without trying every key it holds.
+   *
+   * The key ID links every message sealed this way to the same key,
+   * so only use it where that needn't be hidden.
+   *
+   * @param message The plaintext message to seal
+   * @param messageLength The length of the plaintext to seal
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const PackagedSealedMessage The sealed message, with its keyId
+   */
+  const PackagedSealedMessage sealWithKeyId(
+    const unsigned char* message,
+    const size_t messageLength,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a plaintext message and package it along with its recipe,
+   * unsealingInstructions, and this key's keyId.
+   *
+   * @param message The plaintext message to seal
+   * @param unsealingInstructions If this optional string is
+   * passed, the same string must be passed to unseal the message.
+   * @return const PackagedSealedMessage The sealed message, with its keyId
+   */
+  const PackagedSealedMessage sealWithKeyId(
+    const std::vector<unsigned char>& message,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
   /**
    * @brief Unseal a message 
    * 
@@ -274,6 +435,322 @@ class SymmetricKey {
     const std::string& seedString
   );
 
+  /**
+   * @brief Unseal a message without throwing.
+   *
+   * Use this instead of unseal where failure is expected to be common,
+   * such as when trying a message against several keys.
+   * The ciphertext is authenticated before any memory is allocated for
+   * its plaintext, so a message sealed with a different key, or a
+   * corrupted message, fails without allocating.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a message without throwing.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const std::vector<unsigned char> &ciphertext,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a message into a buffer the caller provides,
+   * without allocating or throwing.
+   *
+   * If the message fails to unseal, nothing is left in the buffer.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least unsealedLength(ciphertextLength)
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written to plaintext,
+   * or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a message into a buffer the caller provides,
+   * without allocating.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least unsealedLength(ciphertextLength)
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written to plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffer is too small.
+   */
+  size_t unseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments into a
+   * buffer the caller provides, without first copying the fragments
+   * together, and without throwing.
+   *
+   * The outcome is the same as that of tryUnseal on the concatenation
+   * of the fragments.
+   * (LibSodium has no incremental AES-GCM, so for AES256GCM keys the
+   * fragments are copied into locked memory and unsealed from there.)
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of fragments
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least unsealedLength of the fragments' total length
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written to plaintext,
+   * or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments into a
+   * buffer the caller provides, without first copying the fragments together.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of fragments
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least unsealedLength of the fragments' total length
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written to plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffer is too small.
+   */
+  size_t unseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments, writing
+   * the plaintext across non-contiguous buffers the caller provides,
+   * without copying either together, and without throwing.
+   *
+   * The outcome is the same as that of tryUnseal on the concatenation
+   * of the fragments, with the plaintext written across the buffers in
+   * order. If it fails, nothing is left in the buffers.
+   * (LibSodium has no incremental AES-GCM, so for AES256GCM keys the
+   * message is unsealed in locked memory and copied into the buffers.)
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of ciphertext fragments
+   * @param plaintextFragments The buffers to write the plaintext into,
+   * whose total length must be at least unsealedLength of the ciphertext
+   * fragments' total length
+   * @param plaintextFragmentCount The number of plaintext buffers
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written across the
+   * plaintext buffers, or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    const OutputFragment* plaintextFragments,
+    const size_t plaintextFragmentCount,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments, writing
+   * the plaintext across non-contiguous buffers the caller provides,
+   * without copying either together.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of ciphertext fragments
+   * @param plaintextFragments The buffers to write the plaintext into,
+   * whose total length must be at least unsealedLength of the ciphertext
+   * fragments' total length
+   * @param plaintextFragmentCount The number of plaintext buffers
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written across the plaintext buffers
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffers are too small.
+   */
+  size_t unseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    const OutputFragment* plaintextFragments,
+    const size_t plaintextFragmentCount,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Seal a file into another file, mapping both into memory so
+   * the message is sealed straight from one to the other.
+   *
+   * The sealed file holds this key's recipe and the unsealingInstructions
+   * along with the ciphertext, like a PackagedSealedMessage (see SealedFile).
+   *
+   * @param inputPath The path of the file to seal, which must not be empty
+   * @param outputPath The path of the sealed file to create (or overwrite),
+   * which must not be the input file
+   * @param unsealingInstructions If this optional string is
+   * passed, it is stored in the sealed file and must be honored
+   * by whoever unseals it.
+   *
+   * @exception std::invalid_argument Thrown if the input file is empty
+   * or is the output file, or if the ciphertext would be 4GB or longer.
+   * @exception std::system_error Thrown if either file can't be opened or written.
+   */
+  void sealFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a file written by sealFile into another file, mapping
+   * both into memory so the message is unsealed straight from one to the other.
+   *
+   * If the file fails to unseal, no output file is left behind.
+   *
+   * @param inputPath The path of the sealed file
+   * @param outputPath The path of the file to write the message to,
+   * which must not be the input file
+   * @return const std::string The unsealingInstructions stored with the
+   * message, which the caller must honor.
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the file
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the file isn't a sealed file,
+   * or is the output file.
+   * @exception std::system_error Thrown if either file can't be opened or written.
+   */
+  const std::string unsealFile(
+    const std::string& inputPath,
+    const std::string& outputPath
+  ) const;
+
+  /**
+   * @brief Unseal a file written by sealFile by re-deriving the SymmetricKey
+   * from a seed and the recipe stored in the file.
+   *
+   * @param inputPath The path of the sealed file
+   * @param outputPath The path of the file to write the message to
+   * @param seedString The seed string used to generate the SymmetricKey that
+   * sealed the file
+   * @return const std::string The unsealingInstructions stored with the
+   * message, which the caller must honor.
+   */
+  static const std::string unsealFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::string& seedString
+  );
+
+  /**
+   * @brief Seal a batch of messages into one contiguous arena,
+   * allocating once for the whole batch rather than once per message.
+   *
+   * Each ciphertext is the one sealToCiphertextOnly would produce for
+   * the same message and unsealingInstructions.
+   *
+   * @param messages The messages to seal, each with its own (optional)
+   * unsealingInstructions
+   * @param count The number of messages
+   * @param threadCount The maximum number of threads to seal with, or 0
+   * for one per core. Threads are started for each call, so only use
+   * more than one for batches that take milliseconds to seal.
+   * @return SealedBatch The ciphertexts, in the order of the messages
+   *
+   * @exception std::invalid_argument Thrown if any message is empty.
+   */
+  SealedBatch sealBatch(
+    const BatchMessage* messages,
+    const size_t count,
+    const size_t threadCount = 1
+  ) const;
+
+  /**
+   * @brief Unseal a batch of ciphertexts into one contiguous arena,
+   * allocating once for the whole batch rather than once per message,
+   * and without throwing.
+   *
+   * A ciphertext that fails to unseal doesn't stop the others from being
+   * unsealed; the batch reports the error tryUnseal would have returned.
+   *
+   * @param ciphertexts The ciphertexts to unseal, each with the
+   * unsealingInstructions it was sealed with (if any)
+   * @param count The number of ciphertexts
+   * @param threadCount The maximum number of threads to unseal with, or 0
+   * for one per core. Threads are started for each call, so only use
+   * more than one for batches that take milliseconds to unseal.
+   * @return UnsealedBatch The plaintexts, in the order of the ciphertexts,
+   * with the outcome of unsealing each
+   */
+  UnsealedBatch unsealBatch(
+    const BatchMessage* ciphertexts,
+    const size_t count,
+    const size_t threadCount = 1
+  ) const;
+
+  /**
+   * @brief Unseal a packaged message without throwing.
+   *
+   * @param packagedSealedMessage The message to be unsealed
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const PackagedSealedMessage& packagedSealedMessage
+  ) const;
+
 
   /**
    * @brief Serialize this object to a JSON-formatted string
@@ -315,6 +792,15 @@ class SymmetricKey {
     const std::string& symmetricKeyAsJson
   );
 
+  /**
+   * @brief Reconstitute a SymmetricKey from JSON without throwing.
+   *
+   * @return Result<SymmetricKey> The key, or the error fromJson would have thrown.
+   */
+  static Result<SymmetricKey> tryFromJson(
+    const std::string& symmetricKeyAsJson
+  );
+
 protected:
 
   /**
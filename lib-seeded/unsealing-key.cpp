@@ -5,6 +5,10 @@
 #include "convert.hpp"
 #include "exceptions.hpp"
 #include "common-names.hpp"
+#include "json-fields.hpp"
+#include "crypto_secretbox_verified_open.h"
+#include "crypto_fragments.h"
+#include "sealed-file.hpp"
 
 UnsealingKey::UnsealingKey(
     const SodiumBuffer _unsealingKeyBytes,
@@ -57,31 +61,344 @@ UnsealingKey::UnsealingKey(
   unsealingKeyBytes(other.unsealingKeyBytes)
   {}
 
-const SodiumBuffer UnsealingKey::unseal(
+namespace UnsealingKeyErrors {
+  static const SeededError invalidMessageLength = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Public/Private unseal failed: Invalid message length"
+  };
+  static const SeededError unsealFailed = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Public/Private unseal failed: the private key doesn't match the public key used to seal the message, the unsealing instructions do not match those used to seal the message, or the ciphertext was modified/corrupted."
+  };
+  static const SeededError invalidPublicKeySize = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid public key size"
+  };
+  static const SeededError invalidPrivateKeySize = {
+    SeededErrorCode::InvalidRecipeValue, "Invalid private key size for public/private key pair"
+  };
+  static const SeededError plaintextBufferTooSmall = {
+    SeededErrorCode::InvalidArgument, "Plaintext buffer too small"
+  };
+  static const SeededError notARecipient = {
+    SeededErrorCode::CryptographicVerificationFailure,
+    "Public/Private unseal failed: the message wasn't sealed for this key, or the unsealing instructions do not match those used to seal the message."
+  };
+}
+
+// Authenticate before allocating or writing, as failure is the common
+// case when trying messages against keys.  On success, the shared key
+// and nonce needed to open the box are left in sharedKey and nonce,
+// and the caller must wipe sharedKey once it's done with it.
+static SeededError verifySealedMessage(
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES],
+  unsigned char nonce[crypto_box_NONCEBYTES],
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::vector<unsigned char>& sealingKeyBytes,
+  const SodiumBuffer& unsealingKeyBytes,
+  const std::string& unsealingInstructions
+) {
+  if (ciphertextLength <= crypto_box_SEALBYTES) {
+    return UnsealingKeyErrors::invalidMessageLength;
+  }
+  if (
+    crypto_box_salted_seal_beforenm(
+      sharedKey, nonce, ciphertext, sealingKeyBytes.data(), unsealingKeyBytes.data,
+      unsealingInstructions.c_str(), unsealingInstructions.length()
+    ) != 0 ||
+    crypto_secretbox_easy_verify(
+      ciphertext + crypto_box_PUBLICKEYBYTES, ciphertextLength - crypto_box_PUBLICKEYBYTES, nonce, sharedKey
+    ) != 0
+  ) {
+    sodium_memzero(sharedKey, crypto_box_BEFORENMBYTES);
+    return UnsealingKeyErrors::unsealFailed;
+  }
+  return {SeededErrorCode::None, NULL};
+}
+
+Result<SodiumBuffer> UnsealingKey::tryUnseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions
+) const {
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  const SeededError error = verifySealedMessage(
+    sharedKey, nonce, ciphertext, ciphertextLength, sealingKeyBytes, unsealingKeyBytes, unsealingInstructions
+  );
+  if (error) {
+    return error;
+  }
+  Result<SodiumBuffer> plaintext(ResultInPlace(), ciphertextLength - crypto_box_SEALBYTES);
+  crypto_secretbox_easy_open_verified(
+    plaintext.value().data,
+    ciphertext + crypto_box_PUBLICKEYBYTES, ciphertextLength - crypto_box_PUBLICKEYBYTES,
+    nonce, sharedKey
+  );
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  return plaintext;
+}
+
+Result<size_t> UnsealingKey::tryUnseal(
   const unsigned char* ciphertext,
   const size_t ciphertextLength,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
   const std::string& unsealingInstructions
 ) const {
+  if (ciphertextLength > crypto_box_SEALBYTES && plaintextCapacity < ciphertextLength - crypto_box_SEALBYTES) {
+    return UnsealingKeyErrors::plaintextBufferTooSmall;
+  }
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  const SeededError error = verifySealedMessage(
+    sharedKey, nonce, ciphertext, ciphertextLength, sealingKeyBytes, unsealingKeyBytes, unsealingInstructions
+  );
+  if (error) {
+    return error;
+  }
+  crypto_secretbox_easy_open_verified(
+    plaintext,
+    ciphertext + crypto_box_PUBLICKEYBYTES, ciphertextLength - crypto_box_PUBLICKEYBYTES,
+    nonce, sharedKey
+  );
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  return Result<size_t>(ResultInPlace(), ciphertextLength - crypto_box_SEALBYTES);
+}
+
+size_t UnsealingKey::unseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext, ciphertextLength, plaintext, plaintextCapacity, unsealingInstructions).valueOrThrow();
+}
+
+Result<size_t> UnsealingKey::tryUnseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  const OutputFragment plaintextFragment = {plaintext, plaintextCapacity};
+  return tryUnseal(ciphertextFragments, fragmentCount, &plaintextFragment, 1, unsealingInstructions);
+}
+
+Result<size_t> UnsealingKey::tryUnseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  const OutputFragment* plaintextFragments,
+  const size_t plaintextFragmentCount,
+  const std::string& unsealingInstructions
+) const {
+  const size_t ciphertextLength = Fragments::totalLength(ciphertextFragments, fragmentCount);
   if (ciphertextLength <= crypto_box_SEALBYTES) {
-    throw CryptographicVerificationFailureException("Public/Private unseal failed: Invalid message length");
-  }
-  SodiumBuffer plaintext(ciphertextLength -crypto_box_SEALBYTES);
-
-  const int result = crypto_box_salted_seal_open(
-    plaintext.data,
-    ciphertext,
-    ciphertextLength,
-    sealingKeyBytes.data(),
-    unsealingKeyBytes.data,
-    unsealingInstructions.c_str(),
-    unsealingInstructions.length()
+    return UnsealingKeyErrors::invalidMessageLength;
+  }
+  if (Fragments::totalLength(plaintextFragments, plaintextFragmentCount) < ciphertextLength - crypto_box_SEALBYTES) {
+    return UnsealingKeyErrors::plaintextBufferTooSmall;
+  }
+  unsigned char ephemeralPublicKey[crypto_box_PUBLICKEYBYTES];
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  Fragments::gather(ephemeralPublicKey, ciphertextFragments, fragmentCount, 0, sizeof ephemeralPublicKey);
+  if (
+    crypto_box_salted_seal_beforenm(
+      sharedKey, nonce, ephemeralPublicKey, sealingKeyBytes.data(), unsealingKeyBytes.data,
+      unsealingInstructions.c_str(), unsealingInstructions.length()
+    ) != 0 ||
+    crypto_secretbox_easy_verify_fragments(
+      ciphertextFragments, fragmentCount, crypto_box_PUBLICKEYBYTES, ciphertextLength - crypto_box_PUBLICKEYBYTES,
+      nonce, sharedKey
+    ) != 0
+  ) {
+    sodium_memzero(sharedKey, sizeof sharedKey);
+    return UnsealingKeyErrors::unsealFailed;
+  }
+  crypto_secretbox_easy_open_verified_fragments(
+    plaintextFragments, plaintextFragmentCount,
+    ciphertextFragments, fragmentCount, crypto_box_PUBLICKEYBYTES, ciphertextLength - crypto_box_PUBLICKEYBYTES,
+    nonce, sharedKey
   );
-  if (result != 0) {
-    throw CryptographicVerificationFailureException("Public/Private unseal failed: the private key doesn't match the public key used to seal the message, the unsealing instructions do not match those used to seal the message, or the ciphertext was modified/corrupted.");
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  return Result<size_t>(ResultInPlace(), ciphertextLength - crypto_box_SEALBYTES);
+}
+
+size_t UnsealingKey::unseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  unsigned char* plaintext,
+  const size_t plaintextCapacity,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertextFragments, fragmentCount, plaintext, plaintextCapacity, unsealingInstructions).valueOrThrow();
+}
+
+size_t UnsealingKey::unseal(
+  const Fragment* ciphertextFragments,
+  const size_t fragmentCount,
+  const OutputFragment* plaintextFragments,
+  const size_t plaintextFragmentCount,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(
+    ciphertextFragments, fragmentCount, plaintextFragments, plaintextFragmentCount, unsealingInstructions
+  ).valueOrThrow();
+}
+
+const std::string UnsealingKey::unsealFile(
+  const std::string& inputPath,
+  const std::string& outputPath
+) const {
+  const MappedFile input = SealedFile::openInput(inputPath, outputPath);
+  const SealedFile::Contents contents = SealedFile::read(input);
+  MappedFile output(outputPath,
+    contents.ciphertextLength > crypto_box_SEALBYTES ? contents.ciphertextLength - crypto_box_SEALBYTES : 0
+  );
+  unseal(contents.ciphertext, contents.ciphertextLength, output.data(), output.length(), contents.unsealingInstructions);
+  output.commit();
+  return contents.unsealingInstructions;
+}
+
+/* static */ const std::string UnsealingKey::unsealFile(
+  const std::string& inputPath,
+  const std::string& outputPath,
+  const std::string& seedString
+) {
+  const std::string recipe = SealedFile::read(MappedFile(inputPath)).recipe;
+  return UnsealingKey::deriveFromSeed(seedString, recipe).unsealFile(inputPath, outputPath);
+}
+
+// The layout of the envelopes SealingKey::sealForRecipients produces
+static const size_t recipientCountBytes = 4;
+static const size_t recipientSlotBytes = crypto_box_SEALBYTES - crypto_box_PUBLICKEYBYTES + crypto_secretbox_KEYBYTES;
+static const size_t payloadOverheadBytes = crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+
+Result<SodiumBuffer> UnsealingKey::tryUnsealForRecipient(
+  const unsigned char* envelope,
+  const size_t envelopeLength,
+  const std::string& unsealingInstructions
+) const {
+  if (envelopeLength < recipientCountBytes + crypto_box_PUBLICKEYBYTES) {
+    return UnsealingKeyErrors::invalidMessageLength;
   }
+  uint64_t recipientCount = 0;
+  for (size_t i = 0; i < recipientCountBytes; i++) {
+    recipientCount |= ((uint64_t) envelope[i]) << (8 * i);
+  }
+  if (recipientCount == 0 ||
+    recipientCount > (envelopeLength - recipientCountBytes - crypto_box_PUBLICKEYBYTES) / recipientSlotBytes
+  ) {
+    return UnsealingKeyErrors::invalidMessageLength;
+  }
+  const size_t slotsLength = recipientCountBytes + crypto_box_PUBLICKEYBYTES + (size_t) recipientCount * recipientSlotBytes;
+  if (envelopeLength <= slotsLength + payloadOverheadBytes) {
+    return UnsealingKeyErrors::invalidMessageLength;
+  }
+
+  // Every slot was sealed with the same ephemeral key, so one shared key
+  // and nonce can be tried against each slot's MAC
+  unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  if (crypto_box_salted_seal_beforenm(
+    sharedKey, nonce, envelope + recipientCountBytes, sealingKeyBytes.data(), unsealingKeyBytes.data,
+    unsealingInstructions.c_str(), unsealingInstructions.length()
+  ) != 0) {
+    sodium_memzero(sharedKey, sizeof sharedKey);
+    return UnsealingKeyErrors::unsealFailed;
+  }
+  SodiumBuffer dataKey(crypto_secretbox_KEYBYTES);
+  bool found = false;
+  const unsigned char* slot = envelope + recipientCountBytes + crypto_box_PUBLICKEYBYTES;
+  for (uint64_t i = 0; i < recipientCount && !found; i++, slot += recipientSlotBytes) {
+    if (crypto_secretbox_easy_verify(slot, recipientSlotBytes, nonce, sharedKey) == 0) {
+      crypto_secretbox_easy_open_verified(dataKey.data, slot, recipientSlotBytes, nonce, sharedKey);
+      found = true;
+    }
+  }
+  sodium_memzero(sharedKey, sizeof sharedKey);
+  if (!found) {
+    return UnsealingKeyErrors::notARecipient;
+  }
+
+  const unsigned char* payloadNonce = envelope + slotsLength;
+  const unsigned char* payload = payloadNonce + crypto_secretbox_NONCEBYTES;
+  const size_t payloadLength = envelopeLength - slotsLength - crypto_secretbox_NONCEBYTES;
+  if (crypto_secretbox_easy_verify(payload, payloadLength, payloadNonce, dataKey.data) != 0) {
+    return UnsealingKeyErrors::unsealFailed;
+  }
+  Result<SodiumBuffer> plaintext(ResultInPlace(), payloadLength - crypto_secretbox_MACBYTES);
+  crypto_secretbox_easy_open_verified(plaintext.value().data, payload, payloadLength, payloadNonce, dataKey.data);
   return plaintext;
 }
 
+const SodiumBuffer UnsealingKey::unsealForRecipient(
+  const std::vector<unsigned char>& envelope,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnsealForRecipient(envelope.data(), envelope.size(), unsealingInstructions).valueOrThrow();
+}
+
+// Unseal a batch with the given forEach (MessageBatch::onThreads or onPool)
+static UnsealedBatch unsealBatchWith(
+  const UnsealingKey& key,
+  const BatchMessage* ciphertexts,
+  const size_t count,
+  const std::function<void(size_t, const std::function<void(size_t)>&)>& forEach
+) {
+  return MessageBatch::unseal(ciphertexts, count, forEach,
+    [](const size_t ciphertextLength) {
+      return ciphertextLength > crypto_box_SEALBYTES ? ciphertextLength - crypto_box_SEALBYTES : 0;
+    },
+    [&key](const BatchMessage& ciphertext, unsigned char* plaintext, const size_t plaintextCapacity) {
+      return key.tryUnseal(
+        ciphertext.data, ciphertext.length, plaintext, plaintextCapacity,
+        MessageBatch::unsealingInstructions(ciphertext)
+      );
+    }
+  );
+}
+
+UnsealedBatch UnsealingKey::unsealBatch(
+  const BatchMessage* ciphertexts,
+  const size_t count,
+  const size_t threadCount
+) const {
+  return unsealBatchWith(*this, ciphertexts, count, MessageBatch::onThreads(threadCount));
+}
+
+UnsealedBatch UnsealingKey::unsealBatch(
+  const BatchMessage* ciphertexts,
+  const size_t count,
+  WorkerPool& pool
+) const {
+  return unsealBatchWith(*this, ciphertexts, count, MessageBatch::onPool(pool));
+}
+
+Result<SodiumBuffer> UnsealingKey::tryUnseal(
+  const std::vector<unsigned char> &ciphertext,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext.data(), ciphertext.size(), unsealingInstructions);
+}
+
+Result<SodiumBuffer> UnsealingKey::tryUnseal(
+  const PackagedSealedMessage &packagedSealedMessage
+) const {
+  return tryUnseal(packagedSealedMessage.ciphertext, packagedSealedMessage.unsealingInstructions);
+}
+
+const SodiumBuffer UnsealingKey::unseal(
+  const unsigned char* ciphertext,
+  const size_t ciphertextLength,
+  const std::string& unsealingInstructions
+) const {
+  return tryUnseal(ciphertext, ciphertextLength, unsealingInstructions).valueOrThrow();
+}
+
 const SodiumBuffer UnsealingKey::unseal(
   const std::vector<unsigned char> &ciphertext,
   const std::string& unsealingInstructions
@@ -100,6 +417,10 @@ const SealingKey UnsealingKey::getSealingKey() const {
   return SealingKey(sealingKeyBytes, recipe);
 }
 
+const std::vector<unsigned char> UnsealingKey::keyId() const {
+  return getSealingKey().keyId();
+}
+
 
 /////
 //  JSON
@@ -110,18 +431,41 @@ namespace UnsealingKeyJsonField {
   static const std::string recipe = CommonNames::recipe;
 }
 
-UnsealingKey UnsealingKey::fromJson(
+Result<UnsealingKey> UnsealingKey::tryFromJson(
   const std::string& unsealingKeyAsJson
 ) {
-  try {
-    nlohmann::json jsonObject = nlohmann::json::parse(unsealingKeyAsJson);
-    return UnsealingKey(
-      SodiumBuffer::fromHexString(jsonObject.at(UnsealingKeyJsonField::unsealingKeyBytes)),
-      hexStrToByteVector(jsonObject.at(UnsealingKeyJsonField::sealingKeyBytes)),
-      jsonObject.value(UnsealingKeyJsonField::recipe, ""));
-  } catch (nlohmann::json::exception e) {
-    throw JsonParsingException(e.what());
+  nlohmann::json jsonObject;
+  if (!JsonFields::parseObject(unsealingKeyAsJson, jsonObject)) {
+    return JsonFields::parsingError;
+  }
+  const std::string* unsealingKeyBytesHex = JsonFields::requiredString(jsonObject, UnsealingKeyJsonField::unsealingKeyBytes);
+  const std::string* sealingKeyBytesHex = JsonFields::requiredString(jsonObject, UnsealingKeyJsonField::sealingKeyBytes);
+  const std::string* recipe = JsonFields::optionalString(jsonObject, UnsealingKeyJsonField::recipe);
+  if (unsealingKeyBytesHex == NULL || sealingKeyBytesHex == NULL || recipe == NULL) {
+    return JsonFields::parsingError;
+  }
+  SeededError hexError = hexStrError(*unsealingKeyBytesHex);
+  if (!hexError) {
+    hexError = hexStrError(*sealingKeyBytesHex);
+  }
+  if (hexError) {
+    return hexError;
   }
+  const SodiumBuffer unsealingKeyBytes = SodiumBuffer::fromHexString(*unsealingKeyBytesHex);
+  const std::vector<unsigned char> sealingKeyBytes = hexStrToByteVector(*sealingKeyBytesHex);
+  if (sealingKeyBytes.size() != crypto_box_PUBLICKEYBYTES) {
+    return UnsealingKeyErrors::invalidPublicKeySize;
+  }
+  if (unsealingKeyBytes.length != crypto_box_SECRETKEYBYTES) {
+    return UnsealingKeyErrors::invalidPrivateKeySize;
+  }
+  return Result<UnsealingKey>(ResultInPlace(), unsealingKeyBytes, sealingKeyBytes, *recipe);
+}
+
+UnsealingKey UnsealingKey::fromJson(
+  const std::string& unsealingKeyAsJson
+) {
+  return tryFromJson(unsealingKeyAsJson).valueOrThrow();
 }
 
 const std::string UnsealingKey::toJson(
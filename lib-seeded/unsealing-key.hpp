@@ -2,6 +2,9 @@
 
 #include "sodium-buffer.hpp"
 #include "sealing-key.hpp"
+#include "result.hpp"
+#include "message-batch.hpp"
+#include "fragments.hpp"
 
 /**
  * @brief an UnsealingKey is used to _unseal_ messages sealed with its
@@ -91,6 +94,15 @@ public:
     const std::string& unsealingKeyAsJson
   );
 
+  /**
+   * @brief Reconstitute an UnsealingKey from JSON without throwing.
+   *
+   * @return Result<UnsealingKey> The key, or the error fromJson would have thrown.
+   */
+  static Result<UnsealingKey> tryFromJson(
+    const std::string& unsealingKeyAsJson
+  );
+
 
   /**
    * @brief Construct by copying another UnsealingKey
@@ -105,6 +117,12 @@ public:
    */
   const SealingKey getSealingKey() const;
 
+  /**
+   * @brief A short identifier of this key for a Keyring to index it by,
+   * the same as that of its SealingKey (see SealingKey::keyId).
+   */
+  const std::vector<unsigned char> keyId() const;
+
   /**
    * @brief Unseal a message 
    * 
@@ -155,6 +173,325 @@ public:
     const PackagedSealedMessage& packagedSealedMessage
   ) const;
 
+  /**
+   * @brief Unseal a message without throwing.
+   *
+   * Use this instead of unseal where failure is expected to be common,
+   * such as when trying a message against several keys.
+   * The ciphertext is authenticated before any memory is allocated for
+   * its plaintext, so a message sealed for a different key, or a
+   * corrupted message, fails without allocating.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    const std::string& unsealingInstructions
+  ) const;
+
+  /**
+   * @brief Unseal a message without throwing.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const std::vector<unsigned char> &ciphertext,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a message into a buffer the caller provides,
+   * without allocating or throwing.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least the ciphertext length minus 48 bytes
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written to plaintext,
+   * or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a message into a buffer the caller provides,
+   * without allocating.
+   *
+   * @param ciphertext The sealed message to be unsealed
+   * @param ciphertextLength The length of the sealed message
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least the ciphertext length minus 48 bytes
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written to plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffer is too small.
+   */
+  size_t unseal(
+    const unsigned char* ciphertext,
+    const size_t ciphertextLength,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments into a
+   * buffer the caller provides, without first copying the fragments
+   * together, and without throwing.
+   *
+   * The outcome is the same as that of tryUnseal on the concatenation
+   * of the fragments.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of fragments
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least the fragments' total length minus 48 bytes
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written to plaintext,
+   * or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments into a
+   * buffer the caller provides, without first copying the fragments together.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of fragments
+   * @param plaintext The buffer to write the plaintext into
+   * @param plaintextCapacity The size of the plaintext buffer, which must
+   * be at least the fragments' total length minus 48 bytes
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written to plaintext
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffer is too small.
+   */
+  size_t unseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    unsigned char* plaintext,
+    const size_t plaintextCapacity,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments, writing
+   * the plaintext across non-contiguous buffers the caller provides,
+   * without copying either together, and without throwing.
+   *
+   * The outcome is the same as that of tryUnseal on the concatenation
+   * of the fragments, with the plaintext written across the buffers in
+   * order. If it fails, nothing is written to the buffers.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of ciphertext fragments
+   * @param plaintextFragments The buffers to write the plaintext into,
+   * whose total length must be at least the ciphertext fragments'
+   * total length minus 48 bytes
+   * @param plaintextFragmentCount The number of plaintext buffers
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<size_t> The number of bytes written across the
+   * plaintext buffers, or the error unseal would have thrown.
+   */
+  Result<size_t> tryUnseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    const OutputFragment* plaintextFragments,
+    const size_t plaintextFragmentCount,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a ciphertext held in non-contiguous fragments, writing
+   * the plaintext across non-contiguous buffers the caller provides,
+   * without copying either together.
+   *
+   * @param ciphertextFragments The fragments of the sealed message
+   * @param fragmentCount The number of ciphertext fragments
+   * @param plaintextFragments The buffers to write the plaintext into,
+   * whose total length must be at least the ciphertext fragments'
+   * total length minus 48 bytes
+   * @param plaintextFragmentCount The number of plaintext buffers
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return size_t The number of bytes written across the plaintext buffers
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the ciphertext
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the plaintext buffers are too small.
+   */
+  size_t unseal(
+    const Fragment* ciphertextFragments,
+    const size_t fragmentCount,
+    const OutputFragment* plaintextFragments,
+    const size_t plaintextFragmentCount,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a file written by sealFile into another file, mapping
+   * both into memory so the message is unsealed straight from one to the other.
+   *
+   * If the file fails to unseal, no output file is left behind.
+   *
+   * @param inputPath The path of the sealed file
+   * @param outputPath The path of the file to write the message to,
+   * which must not be the input file
+   * @return const std::string The unsealingInstructions stored with the
+   * message, which the caller must honor.
+   *
+   * @exception CryptographicVerificationFailureException Thrown if the file
+   * is not valid and cannot be unsealed.
+   * @exception std::invalid_argument Thrown if the file isn't a sealed file,
+   * or is the output file.
+   * @exception std::system_error Thrown if either file can't be opened or written.
+   */
+  const std::string unsealFile(
+    const std::string& inputPath,
+    const std::string& outputPath
+  ) const;
+
+  /**
+   * @brief Unseal a file written by sealFile by re-deriving the UnsealingKey
+   * from a seed and the recipe stored in the file.
+   *
+   * @param inputPath The path of the sealed file
+   * @param outputPath The path of the file to write the message to
+   * @param seedString The seed string used to generate the UnsealingKey that
+   * sealed the file
+   * @return const std::string The unsealingInstructions stored with the
+   * message, which the caller must honor.
+   */
+  static const std::string unsealFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::string& seedString
+  );
+
+  /**
+   * @brief Unseal a batch of ciphertexts into one contiguous arena,
+   * allocating once for the whole batch rather than once per message,
+   * and without throwing.
+   *
+   * A ciphertext that fails to unseal doesn't stop the others from being
+   * unsealed; the batch reports the error tryUnseal would have returned.
+   *
+   * @param ciphertexts The ciphertexts to unseal, each with the
+   * unsealingInstructions it was sealed with (if any)
+   * @param count The number of ciphertexts
+   * @param threadCount The maximum number of threads to unseal with, or 0
+   * for one per core. Threads are started for each call, so only use
+   * more than one for batches that take milliseconds to unseal.
+   * @return UnsealedBatch The plaintexts, in the order of the ciphertexts,
+   * with the outcome of unsealing each
+   */
+  UnsealedBatch unsealBatch(
+    const BatchMessage* ciphertexts,
+    const size_t count,
+    const size_t threadCount = 1
+  ) const;
+
+  /**
+   * @brief Unseal a batch of ciphertexts into one contiguous arena, as
+   * unsealBatch does, spreading the work across the threads of a WorkerPool.
+   *
+   * Since the pool's threads persist between calls, this suits draining a
+   * queue in many batches, where starting threads for each would cost more
+   * than the scalar multiplications they share.
+   *
+   * @param ciphertexts The ciphertexts to unseal, each with the
+   * unsealingInstructions it was sealed with (if any)
+   * @param count The number of ciphertexts
+   * @param pool The threads to unseal with
+   * @return UnsealedBatch The plaintexts, in the order of the ciphertexts,
+   * with the outcome of unsealing each
+   */
+  UnsealedBatch unsealBatch(
+    const BatchMessage* ciphertexts,
+    const size_t count,
+    WorkerPool& pool
+  ) const;
+
+  /**
+   * @brief Find this key's slot in an envelope sealed by
+   * SealingKey::sealForRecipients and unseal the message, without throwing.
+   *
+   * @param envelope The envelope
+   * @param envelopeLength The length of the envelope
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return Result<SodiumBuffer> The plaintext, or the error
+   * unsealForRecipient would have thrown.
+   */
+  Result<SodiumBuffer> tryUnsealForRecipient(
+    const unsigned char* envelope,
+    const size_t envelopeLength,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Find this key's slot in an envelope sealed by
+   * SealingKey::sealForRecipients and unseal the message.
+   *
+   * @param envelope The envelope
+   * @param unsealingInstructions The unsealingInstructions the message
+   * was sealed with, if any.
+   * @return const SodiumBuffer The plaintext message
+   *
+   * @exception CryptographicVerificationFailureException Thrown if this key
+   * isn't one of the recipients, the unsealingInstructions don't match,
+   * or the envelope was modified/corrupted.
+   */
+  const SodiumBuffer unsealForRecipient(
+    const std::vector<unsigned char>& envelope,
+    const std::string& unsealingInstructions = {}
+  ) const;
+
+  /**
+   * @brief Unseal a packaged message without throwing.
+   *
+   * @param packagedSealedMessage The message to be unsealed
+   * @return Result<SodiumBuffer> The plaintext, or the error unseal would
+   * have thrown.
+   */
+  Result<SodiumBuffer> tryUnseal(
+    const PackagedSealedMessage& packagedSealedMessage
+  ) const;
+
   /**
    * @brief Unseal a message by re-deriving the UnsealingKey from its seed. 
    * 
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <system_error>
+#include "worker-pool.hpp"
+#include "parallel-for.hpp"
+
+WorkerPool::WorkerPool(const size_t threadCount) : nextIndex(0), failed(false) {
+#ifndef EMSCRIPTEN
+  const size_t threads = threadCount == 0 ? defaultThreadCount() : threadCount;
+  for (size_t i = 1; i < threads; i++) {
+    try {
+      workers.emplace_back(&WorkerPool::runWorker, this);
+    } catch (const std::system_error&) {
+      // Proceed with the threads we were able to start
+      break;
+    }
+  }
+#endif
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+#ifndef EMSCRIPTEN
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+#endif
+}
+
+size_t WorkerPool::threadCount() const {
+#ifdef EMSCRIPTEN
+  return 1;
+#else
+  return workers.size() + 1;
+#endif
+}
+
+// Claim and process chunks of the current call's indexes until none remain
+void WorkerPool::work() {
+  try {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const size_t start = nextIndex.fetch_add(chunkSize);
+      if (start >= count) {
+        break;
+      }
+      const size_t end = std::min(count, start + chunkSize);
+      for (size_t index = start; index < end; index++) {
+        (*body)(index);
+      }
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (!firstException) {
+      firstException = std::current_exception();
+    }
+    failed = true;
+  }
+}
+
+void WorkerPool::runWorker() {
+  std::unique_lock<std::mutex> lock(stateMutex);
+  // Not the current generation: the first call may have started before
+  // this thread did, and is waiting for it
+  size_t seenGeneration = 0;
+  while (true) {
+    workAvailable.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+    if (stopping) {
+      return;
+    }
+    seenGeneration = generation;
+    lock.unlock();
+    work();
+    lock.lock();
+    if (--busyWorkers == 0) {
+      workDone.notify_one();
+    }
+  }
+}
+
+void WorkerPool::run(const size_t _count, const std::function<void(size_t)>& _body) {
+  std::lock_guard<std::mutex> callLock(callMutex);
+  if (threadCount() <= 1 || _count <= 1) {
+    for (size_t index = 0; index < _count; index++) {
+      _body(index);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    body = &_body;
+    count = _count;
+    // Eight chunks per thread balances load without contending on the counter
+    chunkSize = std::max((size_t) 1, _count / (threadCount() * 8));
+    nextIndex = 0;
+    failed = false;
+    firstException = nullptr;
+    busyWorkers = threadCount() - 1;
+    generation++;
+  }
+  workAvailable.notify_all();
+  work();
+  std::exception_ptr exception;
+  {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workDone.wait(lock, [this]() { return busyWorkers == 0; });
+    body = NULL;
+    exception = firstException;
+    firstException = nullptr;
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
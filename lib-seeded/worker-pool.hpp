@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+#ifndef EMSCRIPTEN
+  #include <thread>
+#endif
+
+/**
+ * @brief A set of threads kept running between calls, so that work which
+ * arrives in many batches (such as draining a queue of sealed messages)
+ * doesn't pay to start threads for each batch, as parallelFor does.
+ *
+ * parallelFor on a pool behaves like the free function parallelFor:
+ * threads claim indexes in small chunks, the calling thread works too,
+ * and the first exception a call throws is rethrown once all threads
+ * have stopped. Calls from several threads at once take turns.
+ * A body must not itself call parallelFor on the same pool.
+ *
+ * Under Emscripten, which has no threads, all work runs on the calling thread.
+ *
+ * @ingroup BuildingBlocks
+ */
+class WorkerPool {
+#ifndef EMSCRIPTEN
+  std::vector<std::thread> workers;
+#endif
+  // Held for the duration of each parallelFor call
+  std::mutex callMutex;
+  // Guards the fields below, which describe the current call
+  std::mutex stateMutex;
+  std::condition_variable workAvailable;
+  std::condition_variable workDone;
+  const std::function<void(size_t)>* body = NULL;
+  size_t count = 0;
+  size_t chunkSize = 1;
+  size_t generation = 0;
+  size_t busyWorkers = 0;
+  bool stopping = false;
+  std::atomic<size_t> nextIndex;
+  std::atomic<bool> failed;
+  std::exception_ptr firstException;
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void work();
+  void runWorker();
+  void run(const size_t count, const std::function<void(size_t)>& body);
+
+public:
+  /**
+   * @brief Start the pool's threads
+   *
+   * @param threadCount The number of threads to work with, including
+   * the thread that calls parallelFor, or 0 for defaultThreadCount()
+   */
+  explicit WorkerPool(const size_t threadCount = 0);
+
+  /**
+   * @brief Stop and join the pool's threads
+   */
+  ~WorkerPool();
+
+  /**
+   * @brief The number of threads that work on each call, including the caller
+   */
+  size_t threadCount() const;
+
+  /**
+   * @brief Call `body(index)` for every index in [0, count), spreading
+   * the calls across the pool's threads, and return once all have been made.
+   */
+  template <typename Body>
+  void parallelFor(const size_t count, const Body& body) {
+    const std::function<void(size_t)> function = [&body](const size_t index) { body(index); };
+    run(count, function);
+  }
+};
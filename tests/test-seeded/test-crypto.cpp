@@ -1,6 +1,16 @@
 #include "gtest/gtest.h"
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+	#include <sys/stat.h>
+#endif
 #include "lib-seeded.hpp"
 #include "../lib-seeded/convert.hpp"
 
@@ -26,6 +36,19 @@ std::string defaultTestSigningRecipeJson = R"KGO({
 })KGO";
 
 
+TEST(SodiumBuffer, MoveLeavesOriginalWithoutData) {
+	SodiumBuffer* original = new SodiumBuffer(std::string("secret"));
+	const unsigned char* data = original->data;
+	const SodiumBuffer moved(std::move(*original));
+	ASSERT_EQ(original->data, (unsigned char*) NULL);
+	// The moved-from buffer no longer owns the memory, so destroying
+	// it leaves the moved-to buffer's data intact
+	delete original;
+	ASSERT_EQ(moved.data, data);
+	ASSERT_EQ(moved.length, 6);
+	ASSERT_EQ(moved.toUtf8String(), "secret");
+}
+
 TEST(Secret, FidoUseCase) {
 	std::string kdo = R"KDO({
 	"type": "Secret",
@@ -326,6 +349,41 @@ TEST(SigningKey, Verification) {
 }
 
 
+TEST(SignatureVerificationKey, VerifiesBatchesAndPinpointsInvalidSignatures) {
+	const SigningKey alice = SigningKey::deriveFromSeed("alice", R"({"type":"SigningKey"})");
+	const SigningKey bob = SigningKey::deriveFromSeed("bob", R"({"type":"SigningKey"})");
+	const SignatureVerificationKey aliceKey = alice.getSignatureVerificationKey();
+	const SignatureVerificationKey bobKey = bob.getSignatureVerificationKey();
+	std::vector<std::vector<unsigned char>> messages;
+	std::vector<std::vector<unsigned char>> signatures;
+	for (size_t i = 0; i < 100; i++) {
+		const std::string message = "event " + std::to_string(i);
+		messages.push_back(std::vector<unsigned char>(message.begin(), message.end()));
+		signatures.push_back((i % 2 == 0 ? alice : bob).generateSignature(messages.back()));
+	}
+	std::vector<BatchSignedMessage> batch;
+	for (size_t i = 0; i < messages.size(); i++) {
+		batch.push_back({
+			i % 2 == 0 ? &aliceKey : &bobKey,
+			messages[i].data(), messages[i].size(), signatures[i].data(), signatures[i].size()
+		});
+	}
+	const VerifiedBatch verified = SignatureVerificationKey::verifyBatch(batch.data(), batch.size(), 0);
+	ASSERT_EQ(verified.size(), batch.size());
+	ASSERT_TRUE(verified.allValid());
+
+	batch[10].key = &bobKey;
+	signatures[41][0] ^= 1;
+	batch[77].signatureLength = 3;
+	batch[88].key = NULL;
+	WorkerPool pool(2);
+	const VerifiedBatch pooled = SignatureVerificationKey::verifyBatch(batch.data(), batch.size(), pool);
+	ASSERT_EQ(pooled.invalidCount, 4);
+	for (size_t i = 0; i < batch.size(); i++) {
+		ASSERT_EQ(pooled.ok(i), i != 10 && i != 41 && i != 77 && i != 88);
+	}
+}
+
 TEST(SymmetricKey, EncryptsAndDecryptsWithoutUnsealingInstructions) {
 	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
 
@@ -415,6 +473,981 @@ TEST(SymmetricKey, EncryptsAndDecryptsPackagedAndDecryptsWithoutRederiving) {
 
 
 
+static std::vector<unsigned char> sealStream(
+	const SymmetricKey& key,
+	const std::vector<unsigned char>& plaintext,
+	const std::string& unsealingInstructions,
+	const size_t chunkSize,
+	const size_t updateSize
+) {
+	std::vector<unsigned char> sealed;
+	SymmetricKeyStreamSealer sealer(key, unsealingInstructions,
+		[&](const unsigned char* data, const size_t length) { sealed.insert(sealed.end(), data, data + length); },
+		chunkSize
+	);
+	sealer.init();
+	for (size_t offset = 0; offset < plaintext.size(); offset += updateSize) {
+		sealer.update(plaintext.data() + offset, std::min(updateSize, plaintext.size() - offset));
+	}
+	sealer.final();
+	return sealed;
+}
+
+static std::vector<unsigned char> unsealStream(
+	const SymmetricKey& key,
+	const std::vector<unsigned char>& sealed,
+	const std::string& unsealingInstructions,
+	const size_t updateSize
+) {
+	std::vector<unsigned char> plaintext;
+	SymmetricKeyStreamUnsealer unsealer(key, unsealingInstructions,
+		[&](const unsigned char* data, const size_t length) { plaintext.insert(plaintext.end(), data, data + length); }
+	);
+	for (size_t offset = 0; offset < sealed.size(); offset += updateSize) {
+		unsealer.update(sealed.data() + offset, std::min(updateSize, sealed.size() - offset));
+	}
+	unsealer.final();
+	return plaintext;
+}
+
+TEST(SymmetricKey, SealsAndUnsealsWithRandomNonces) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, R"({"type": "SymmetricKey", "nonceType": "Random"})");
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	const std::vector<unsigned char> messageVector = { 'y', 'o', 't', 'o' };
+
+	const auto sealedMessage = testSymmetricKey.seal(messageVector, unsealingInstructions);
+	ASSERT_EQ(sealedMessage.ciphertext.size(), testSymmetricKey.sealedLength(messageVector.size()));
+	ASSERT_NE(sealedMessage.ciphertext, testSymmetricKey.seal(messageVector, unsealingInstructions).ciphertext);
+	ASSERT_EQ(testSymmetricKey.unseal(sealedMessage).toVector(), messageVector);
+	ASSERT_EQ(SymmetricKey::unseal(sealedMessage, orderedTestKey).toVector(), messageVector);
+	ASSERT_EQ(
+		SymmetricKey::fromJson(testSymmetricKey.toJson()).unseal(sealedMessage).toVector(),
+		messageVector
+	);
+	ASSERT_EQ(
+		testSymmetricKey.tryUnseal(sealedMessage.ciphertext, "").error().code,
+		SeededErrorCode::CryptographicVerificationFailure
+	);
+
+	// A key with the same bytes but a synthetic nonce can't unseal it
+	const SymmetricKey syntheticNonceKey(testSymmetricKey.keyBytes, "");
+	ASSERT_FALSE(syntheticNonceKey.tryUnseal(sealedMessage.ciphertext, unsealingInstructions).ok());
+}
+
+TEST(SymmetricKey, SealsAndUnsealsWithXChaCha20Poly1305) {
+	const std::vector<unsigned char> messageVector = { 'y', 'o', 't', 'o' };
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	const SymmetricKey testSymmetricKey(orderedTestKey, R"({"type": "SymmetricKey", "algorithm": "XChaCha20Poly1305"})");
+	ASSERT_EQ(testSymmetricKey.algorithm, RecipeJson::Algorithm::XChaCha20Poly1305);
+
+	const auto sealedMessage = testSymmetricKey.seal(messageVector, unsealingInstructions);
+	ASSERT_EQ(sealedMessage.ciphertext.size(), messageVector.size() + 40);
+	// Synthetic nonces are deterministic
+	ASSERT_EQ(sealedMessage.ciphertext, testSymmetricKey.seal(messageVector, unsealingInstructions).ciphertext);
+	ASSERT_EQ(SymmetricKey::unseal(sealedMessage, orderedTestKey).toVector(), messageVector);
+	const SymmetricKey copy = SymmetricKey::fromSerializedBinaryForm(testSymmetricKey.toSerializedBinaryForm());
+	ASSERT_EQ(copy.algorithm, RecipeJson::Algorithm::XChaCha20Poly1305);
+	ASSERT_EQ(copy.unseal(sealedMessage).toVector(), messageVector);
+	ASSERT_EQ(
+		testSymmetricKey.tryUnseal(sealedMessage.ciphertext, "").error().code,
+		SeededErrorCode::CryptographicVerificationFailure
+	);
+	// The same key bytes with the XSalsa20Poly1305 algorithm can't unseal it
+	ASSERT_FALSE(SymmetricKey(testSymmetricKey.keyBytes, "").tryUnseal(sealedMessage).ok());
+}
+
+TEST(SymmetricKey, SealsAndUnsealsWithAES256GCM) {
+	const std::vector<unsigned char> messageVector = { 'y', 'o', 't', 'o' };
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	for (const std::string recipe : {
+		R"({"type": "SymmetricKey", "algorithm": "AES256GCM"})",
+		R"({"type": "SymmetricKey", "algorithm": "AES256GCM", "nonceType": "Random"})"
+	}) {
+		const SymmetricKey testSymmetricKey(orderedTestKey, recipe);
+		ASSERT_EQ(testSymmetricKey.algorithm, RecipeJson::Algorithm::AES256GCM);
+		if (!crypto_aead_aes256gcm_is_available()) {
+			ASSERT_THROW(testSymmetricKey.seal(messageVector, unsealingInstructions), AlgorithmUnavailableException);
+			continue;
+		}
+		const auto sealedMessage = testSymmetricKey.seal(messageVector, unsealingInstructions);
+		ASSERT_EQ(sealedMessage.ciphertext.size(), messageVector.size() + 28);
+		ASSERT_EQ(SymmetricKey::unseal(sealedMessage, orderedTestKey).toVector(), messageVector);
+		ASSERT_EQ(
+			testSymmetricKey.tryUnseal(sealedMessage.ciphertext, "").error().code,
+			SeededErrorCode::CryptographicVerificationFailure
+		);
+		std::vector<unsigned char> modified(sealedMessage.ciphertext);
+		modified.back() ^= 1;
+		ASSERT_THROW(testSymmetricKey.unseal(modified, unsealingInstructions), CryptographicVerificationFailureException);
+	}
+	ASSERT_THROW(
+		SymmetricKey(orderedTestKey, R"({"algorithm": "AES256GCM", "lengthInBytes": 16})"),
+		InvalidRecipeValueException
+	);
+}
+
+TEST(SymmetricKey, SealsAndUnsealsStreams) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	for (const size_t plaintextLength : {0, 1, 63, 64, 65, 1000}) {
+		std::vector<unsigned char> plaintext(plaintextLength);
+		randombytes_buf(plaintext.data(), plaintext.size());
+		for (const size_t updateSize : {1, 7, 64, 5000}) {
+			const std::vector<unsigned char> sealed = sealStream(testSymmetricKey, plaintext, unsealingInstructions, 64, updateSize);
+			ASSERT_EQ(sealed.size(), SymmetricKeyStream::sealedLength(plaintextLength, 64));
+			ASSERT_EQ(unsealStream(testSymmetricKey, sealed, unsealingInstructions, updateSize), plaintext);
+			ASSERT_EQ(unsealStream(testSymmetricKey, sealed, unsealingInstructions, 13), plaintext);
+		}
+	}
+}
+
+TEST(SymmetricKey, RejectsModifiedStreams) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const SymmetricKey otherSymmetricKey("other seed", defaultTestSymmetricRecipeJson);
+	std::vector<unsigned char> plaintext(200);
+	randombytes_buf(plaintext.data(), plaintext.size());
+	const std::vector<unsigned char> sealed = sealStream(testSymmetricKey, plaintext, "instructions", 64, 200);
+
+	ASSERT_THROW(unsealStream(otherSymmetricKey, sealed, "instructions", 100), CryptographicVerificationFailureException);
+	ASSERT_THROW(unsealStream(testSymmetricKey, sealed, "other instructions", 100), CryptographicVerificationFailureException);
+
+	// Truncated at a chunk boundary
+	const std::vector<unsigned char> truncated(sealed.begin(), sealed.begin() + SymmetricKeyStream::HeaderBytes + 2 * (64 + SymmetricKeyStream::ChunkOverheadBytes));
+	ASSERT_THROW(unsealStream(testSymmetricKey, truncated, "instructions", 100), CryptographicVerificationFailureException);
+
+	// Extended past the final chunk
+	std::vector<unsigned char> extended(sealed);
+	extended.push_back(0);
+	ASSERT_THROW(unsealStream(testSymmetricKey, extended, "instructions", 100), CryptographicVerificationFailureException);
+
+	std::vector<unsigned char> modified(sealed);
+	modified[SymmetricKeyStream::HeaderBytes + 70] ^= 1;
+	ASSERT_THROW(unsealStream(testSymmetricKey, modified, "instructions", 100), CryptographicVerificationFailureException);
+}
+
+TEST(SymmetricKey, CopiesAndReconstructedKeysUnsealEveryAlgorithm) {
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	for (const std::string recipe : {
+		R"({"type":"SymmetricKey"})",
+		R"({"type":"SymmetricKey","nonceType":"Random"})",
+		R"({"type":"SymmetricKey","algorithm":"XChaCha20Poly1305"})",
+		R"({"type":"SymmetricKey","algorithm":"AES256GCM"})",
+	}) {
+		const SymmetricKey original(orderedTestKey, recipe);
+		if (original.algorithm == RecipeJson::Algorithm::AES256GCM && !crypto_aead_aes256gcm_is_available()) {
+			continue;
+		}
+		const SymmetricKey copy(original);
+		const SymmetricKey reconstructed(original.keyBytes, original.recipe);
+		const std::vector<unsigned char> message = {'y', 'o', 't', 'o'};
+		const auto ciphertext = original.sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions);
+		ASSERT_EQ(copy.unseal(ciphertext, unsealingInstructions).toVector(), message);
+		ASSERT_EQ(reconstructed.unseal(copy.sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions), unsealingInstructions).toVector(), message);
+		ASSERT_FALSE(copy.tryUnseal(ciphertext, "").ok());
+	}
+}
+
+static void writeTestFile(const std::string& path, const std::vector<unsigned char>& contents) {
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*) contents.data(), contents.size());
+}
+
+static std::vector<unsigned char> readTestFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool testFileExists(const std::string& path) {
+	return std::ifstream(path).good();
+}
+
+TEST(SymmetricKey, SealsAndUnsealsFiles) {
+	const std::string recipe = defaultTestSymmetricRecipeJson;
+	const SymmetricKey testSymmetricKey("yo", recipe);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	const std::vector<unsigned char> message = {'y', 'o', 't', 'o', ' ', 'm', 'o', 'f', 'o'};
+	const std::string plaintextPath = "symmetric-key-file.plaintext";
+	const std::string sealedPath = "symmetric-key-file.sealed";
+	const std::string unsealedPath = "symmetric-key-file.unsealed";
+	writeTestFile(plaintextPath, message);
+
+	testSymmetricKey.sealFile(plaintextPath, sealedPath, unsealingInstructions);
+	// The sealed file is a serialized PackagedSealedMessage
+	const PackagedSealedMessage packaged = PackagedSealedMessage::fromSerializedBinaryForm(readTestFile(sealedPath));
+	ASSERT_EQ(packaged.recipe, recipe);
+	ASSERT_EQ(packaged.unsealingInstructions, unsealingInstructions);
+	ASSERT_EQ(testSymmetricKey.unseal(packaged).toVector(), message);
+
+	ASSERT_EQ(testSymmetricKey.unsealFile(sealedPath, unsealedPath), unsealingInstructions);
+	ASSERT_EQ(readTestFile(unsealedPath), message);
+	std::remove(unsealedPath.c_str());
+	ASSERT_EQ(SymmetricKey::unsealFile(sealedPath, unsealedPath, "yo"), unsealingInstructions);
+	ASSERT_EQ(readTestFile(unsealedPath), message);
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+	// A new output file gets the mode the umask gives it, and one that
+	// replaces an existing file keeps that file's mode
+	const mode_t umaskBits = umask(0);
+	umask(umaskBits);
+	struct stat status;
+	ASSERT_EQ(stat(unsealedPath.c_str(), &status), 0);
+	ASSERT_EQ(status.st_mode & 0777, 0666 & ~umaskBits);
+	ASSERT_EQ(chmod(unsealedPath.c_str(), 0640), 0);
+	testSymmetricKey.unsealFile(sealedPath, unsealedPath);
+	ASSERT_EQ(stat(unsealedPath.c_str(), &status), 0);
+	ASSERT_EQ(status.st_mode & 0777, 0640);
+#endif
+	std::remove(unsealedPath.c_str());
+
+	// A modified file fails to unseal and leaves no output behind
+	std::vector<unsigned char> modified = readTestFile(sealedPath);
+	modified[10] ^= 1;
+	writeTestFile(sealedPath, modified);
+	ASSERT_THROW(testSymmetricKey.unsealFile(sealedPath, unsealedPath), CryptographicVerificationFailureException);
+	ASSERT_FALSE(testFileExists(unsealedPath));
+
+	// Nor does it truncate or delete a file already at the output path
+	const std::vector<unsigned char> existing = {'k', 'e', 'e', 'p'};
+	writeTestFile(unsealedPath, existing);
+	ASSERT_THROW(testSymmetricKey.unsealFile(sealedPath, unsealedPath), CryptographicVerificationFailureException);
+	ASSERT_EQ(readTestFile(unsealedPath), existing);
+	ASSERT_THROW(SymmetricKey::unsealFile(sealedPath, unsealedPath, "not yo"), CryptographicVerificationFailureException);
+	ASSERT_EQ(readTestFile(unsealedPath), existing);
+	std::remove(unsealedPath.c_str());
+
+	ASSERT_THROW(testSymmetricKey.sealFile(plaintextPath, plaintextPath), std::invalid_argument);
+	ASSERT_EQ(readTestFile(plaintextPath), message);
+	std::remove(plaintextPath.c_str());
+	std::remove(sealedPath.c_str());
+}
+
+TEST(SymmetricKey, SealsAndUnsealsBatches) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	const std::string messages[] = {"yoto", "mofo", "a somewhat longer message than the others"};
+	std::vector<BatchMessage> batch;
+	for (const std::string& message : messages) {
+		batch.push_back({(const unsigned char*) message.data(), message.size(), batch.size() == 1 ? &unsealingInstructions : NULL});
+	}
+	const SealedBatch sealed = testSymmetricKey.sealBatch(batch.data(), batch.size(), 2);
+	ASSERT_EQ(sealed.size(), 3);
+	ASSERT_EQ(sealed.arena.size(), sealed.offsets.back());
+	std::vector<BatchMessage> ciphertexts;
+	for (size_t i = 0; i < sealed.size(); i++) {
+		ASSERT_EQ(sealed.length(i), testSymmetricKey.sealedLength(messages[i].size()));
+		// Each ciphertext is the one sealToCiphertextOnly produces
+		ASSERT_EQ(
+			std::vector<unsigned char>(sealed.data(i), sealed.data(i) + sealed.length(i)),
+			testSymmetricKey.sealToCiphertextOnly((const unsigned char*) messages[i].data(), messages[i].size(), i == 1 ? unsealingInstructions : "")
+		);
+		ciphertexts.push_back({sealed.data(i), sealed.length(i), batch[i].unsealingInstructions});
+	}
+	// Unsealing the second without its instructions fails without affecting the others
+	ciphertexts[1].unsealingInstructions = NULL;
+	const UnsealedBatch unsealed = testSymmetricKey.unsealBatch(ciphertexts.data(), ciphertexts.size());
+	ASSERT_EQ(unsealed.size(), 3);
+	ASSERT_TRUE(unsealed.ok(0));
+	ASSERT_EQ(std::string((const char*) unsealed.data(0), unsealed.length(0)), messages[0]);
+	ASSERT_EQ(unsealed.errors[1].code, SeededErrorCode::CryptographicVerificationFailure);
+	ASSERT_EQ(unsealed.length(1), 0);
+	ASSERT_TRUE(unsealed.ok(2));
+	ASSERT_EQ(std::string((const char*) unsealed.data(2), unsealed.length(2)), messages[2]);
+}
+
+// Split bytes into fragments at the given offsets, which may repeat
+// (producing empty fragments)
+static std::vector<Fragment> splitIntoFragments(
+	const std::vector<unsigned char>& bytes,
+	const std::vector<size_t>& splits
+) {
+	std::vector<Fragment> fragments;
+	size_t start = 0;
+	for (size_t split : splits) {
+		fragments.push_back({bytes.data() + start, split - start});
+		start = split;
+	}
+	fragments.push_back({bytes.data() + start, bytes.size() - start});
+	return fragments;
+}
+
+// Split a buffer into output fragments at the given offsets
+static std::vector<OutputFragment> splitIntoOutputFragments(
+	std::vector<unsigned char>& bytes,
+	const std::vector<size_t>& splits
+) {
+	std::vector<OutputFragment> fragments;
+	for (const Fragment& fragment : splitIntoFragments(bytes, splits)) {
+		fragments.push_back({bytes.data() + (fragment.data - bytes.data()), fragment.length});
+	}
+	return fragments;
+}
+
+TEST(SymmetricKey, SealsAndUnsealsFragments) {
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	std::vector<unsigned char> message(200);
+	for (size_t i = 0; i < message.size(); i++) {
+		message[i] = (unsigned char) i;
+	}
+	// Splits on and around the keystream's block boundaries, including an empty fragment
+	const std::vector<Fragment> messageFragments = splitIntoFragments(message, {5, 31, 32, 32, 33, 63, 64, 65, 150});
+	for (const std::string recipe : {
+		R"({"type":"SymmetricKey"})",
+		R"({"type":"SymmetricKey","nonceType":"Random"})",
+		R"({"type":"SymmetricKey","algorithm":"XChaCha20Poly1305"})",
+		R"({"type":"SymmetricKey","algorithm":"XChaCha20Poly1305","nonceType":"Random"})",
+		R"({"type":"SymmetricKey","algorithm":"AES256GCM"})",
+	}) {
+		const SymmetricKey testSymmetricKey(orderedTestKey, recipe);
+		if (testSymmetricKey.algorithm == RecipeJson::Algorithm::AES256GCM && !crypto_aead_aes256gcm_is_available()) {
+			continue;
+		}
+		std::vector<unsigned char> ciphertext(testSymmetricKey.sealedLength(message.size()));
+		ASSERT_EQ(testSymmetricKey.sealToCiphertextOnly(
+			messageFragments.data(), messageFragments.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+		), ciphertext.size());
+		if (testSymmetricKey.nonceType == RecipeJson::NonceType::Synthetic) {
+			ASSERT_EQ(ciphertext, testSymmetricKey.sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions));
+		}
+		ASSERT_EQ(testSymmetricKey.unseal(ciphertext, unsealingInstructions).toVector(), message);
+
+		// Splits within the nonce, the MAC, and the message
+		const std::vector<Fragment> ciphertextFragments = splitIntoFragments(ciphertext, {3, 20, 20, 24, 30, 40, 100, ciphertext.size() - 8});
+		std::vector<unsigned char> plaintext(message.size());
+		ASSERT_EQ(testSymmetricKey.unseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+		), message.size());
+		ASSERT_EQ(plaintext, message);
+		ASSERT_EQ(testSymmetricKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size(), ""
+		).error().code, SeededErrorCode::CryptographicVerificationFailure);
+		ASSERT_EQ(testSymmetricKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size() - 1, unsealingInstructions
+		).error().code, SeededErrorCode::InvalidArgument);
+
+		// Scattered across buffers split on and around the keystream's block
+		// boundaries, with bytes to spare that are left untouched
+		std::vector<unsigned char> scattered(message.size() + 10, 0xff);
+		const std::vector<OutputFragment> plaintextFragments = splitIntoOutputFragments(scattered, {1, 32, 32, 63, 64, 65, 130});
+		ASSERT_EQ(testSymmetricKey.unseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintextFragments.data(), plaintextFragments.size(), unsealingInstructions
+		), message.size());
+		ASSERT_EQ(std::vector<unsigned char>(scattered.begin(), scattered.begin() + message.size()), message);
+		ASSERT_EQ(std::vector<unsigned char>(scattered.begin() + message.size(), scattered.end()), std::vector<unsigned char>(10, 0xff));
+		std::fill(scattered.begin(), scattered.end(), 0);
+		ASSERT_EQ(testSymmetricKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintextFragments.data(), plaintextFragments.size(), ""
+		).error().code, SeededErrorCode::CryptographicVerificationFailure);
+		ASSERT_EQ(scattered, std::vector<unsigned char>(scattered.size(), 0));
+		std::vector<unsigned char> tooSmall(message.size() - 1);
+		const std::vector<OutputFragment> tooSmallFragments = splitIntoOutputFragments(tooSmall, {50, 100});
+		ASSERT_EQ(testSymmetricKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), tooSmallFragments.data(), tooSmallFragments.size(), unsealingInstructions
+		).error().code, SeededErrorCode::InvalidArgument);
+		ciphertext[ciphertext.size() / 2] ^= 1;
+		ASSERT_THROW(testSymmetricKey.unseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+		), CryptographicVerificationFailureException);
+	}
+}
+
+TEST(SymmetricKey, SealsAndUnsealsSegmentedMessages) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	for (size_t messageLength : {1, 63, 64, 65, 1000}) {
+		std::vector<unsigned char> message(messageLength);
+		for (size_t i = 0; i < messageLength; i++) {
+			message[i] = (unsigned char) i;
+		}
+		const std::vector<unsigned char> sealed = SymmetricKeySegmented::seal(
+			testSymmetricKey, message.data(), message.size(), unsealingInstructions, 64, 4
+		);
+		ASSERT_EQ(sealed.size(), SymmetricKeySegmented::sealedLength(messageLength, 64));
+		ASSERT_EQ(SymmetricKeySegmented::unsealedLength(sealed.data(), sealed.size()), messageLength);
+		ASSERT_EQ(
+			SymmetricKeySegmented::unseal(testSymmetricKey, sealed.data(), sealed.size(), unsealingInstructions, 4).toVector(),
+			message
+		);
+		ASSERT_EQ(
+			SymmetricKeySegmented::tryUnseal(testSymmetricKey, sealed.data(), sealed.size(), "").error().code,
+			SeededErrorCode::CryptographicVerificationFailure
+		);
+	}
+
+	std::vector<unsigned char> message(1000, 'y');
+	const std::vector<unsigned char> sealed = SymmetricKeySegmented::seal(
+		testSymmetricKey, message.data(), message.size(), unsealingInstructions, 64, 4
+	);
+	const size_t sealedSegmentLength = 64 + SymmetricKeySegmented::SegmentOverheadBytes;
+	// Swapping two segments
+	std::vector<unsigned char> reordered(sealed);
+	std::swap_ranges(
+		reordered.begin() + SymmetricKeySegmented::HeaderBytes,
+		reordered.begin() + SymmetricKeySegmented::HeaderBytes + sealedSegmentLength,
+		reordered.begin() + SymmetricKeySegmented::HeaderBytes + sealedSegmentLength
+	);
+	ASSERT_THROW(
+		SymmetricKeySegmented::unseal(testSymmetricKey, reordered.data(), reordered.size(), unsealingInstructions),
+		CryptographicVerificationFailureException
+	);
+	// Truncating to whole segments, with the header changed to match
+	std::vector<unsigned char> truncated(sealed.begin(), sealed.begin() + SymmetricKeySegmented::HeaderBytes + 2 * sealedSegmentLength);
+	truncated[4] = 128; truncated[5] = 0;
+	ASSERT_FALSE(
+		SymmetricKeySegmented::tryUnseal(testSymmetricKey, truncated.data(), truncated.size(), unsealingInstructions).ok()
+	);
+	// A failed unseal leaves nothing in the caller's buffer
+	std::vector<unsigned char> modified(sealed);
+	modified.back() ^= 1;
+	std::vector<unsigned char> plaintext(message.size());
+	ASSERT_FALSE(SymmetricKeySegmented::tryUnseal(
+		testSymmetricKey, modified.data(), modified.size(), plaintext.data(), plaintext.size(), unsealingInstructions, 4
+	).ok());
+	ASSERT_EQ(plaintext, std::vector<unsigned char>(message.size(), 0));
+}
+
+TEST(SymmetricKey, UnsealsRangesOfSegmentedMessages) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{}";
+	std::vector<unsigned char> message(1000);
+	for (size_t i = 0; i < message.size(); i++) {
+		message[i] = (unsigned char) (i * 7);
+	}
+	std::vector<unsigned char> sealed = SymmetricKeySegmented::seal(
+		testSymmetricKey, message.data(), message.size(), unsealingInstructions, 64
+	);
+	const size_t ranges[][2] = {{0, 1}, {0, 64}, {10, 20}, {60, 10}, {64, 128}, {50, 900}, {990, 10}, {0, 1000}, {1000, 0}};
+	for (const auto& range : ranges) {
+		std::vector<unsigned char> plaintext(range[1]);
+		ASSERT_EQ(SymmetricKeySegmented::unsealRange(
+			testSymmetricKey, sealed.data(), sealed.size(), range[0], range[1],
+			plaintext.data(), plaintext.size(), unsealingInstructions
+		), range[1]);
+		ASSERT_EQ(plaintext, std::vector<unsigned char>(message.begin() + range[0], message.begin() + range[0] + range[1]));
+	}
+	std::vector<unsigned char> plaintext(10);
+	ASSERT_EQ(SymmetricKeySegmented::tryUnsealRange(
+		testSymmetricKey, sealed.data(), sealed.size(), 995, 10, plaintext.data(), plaintext.size(), unsealingInstructions
+	).error().code, SeededErrorCode::InvalidArgument);
+
+	// Only the segments holding the range are unsealed
+	const size_t sealedSegmentLength = 64 + SymmetricKeySegmented::SegmentOverheadBytes;
+	sealed[SymmetricKeySegmented::HeaderBytes + 3 * sealedSegmentLength] ^= 1;
+	ASSERT_EQ(SymmetricKeySegmented::unsealRange(
+		testSymmetricKey, sealed.data(), sealed.size(), 130, 10, plaintext.data(), plaintext.size(), unsealingInstructions
+	), 10);
+	ASSERT_THROW(SymmetricKeySegmented::unsealRange(
+		testSymmetricKey, sealed.data(), sealed.size(), 185, 10, plaintext.data(), plaintext.size(), unsealingInstructions
+	), CryptographicVerificationFailureException);
+	ASSERT_EQ(plaintext, std::vector<unsigned char>(10, 0));
+	// The header is bound to every segment
+	sealed[SymmetricKeySegmented::HeaderBytes + 3 * sealedSegmentLength] ^= 1;
+	sealed[20] ^= 1;
+	ASSERT_FALSE(SymmetricKeySegmented::tryUnsealRange(
+		testSymmetricKey, sealed.data(), sealed.size(), 0, 10, plaintext.data(), plaintext.size(), unsealingInstructions
+	).ok());
+
+	// Reading a range of a sealed file through a mapping
+	const std::string plaintextPath = "segmented-file.plaintext";
+	const std::string sealedPath = "segmented-file.sealed";
+	writeTestFile(plaintextPath, message);
+	SymmetricKeySegmented::sealFile(testSymmetricKey, plaintextPath, sealedPath, unsealingInstructions, 64);
+	{
+		const MappedFile sealedFile(sealedPath);
+		ASSERT_EQ(SymmetricKeySegmented::unsealRange(
+			testSymmetricKey, sealedFile.data(), sealedFile.length(), 500, 10, plaintext.data(), plaintext.size(), unsealingInstructions
+		), 10);
+		ASSERT_EQ(plaintext, std::vector<unsigned char>(message.begin() + 500, message.begin() + 510));
+	}
+	std::remove(plaintextPath.c_str());
+	std::remove(sealedPath.c_str());
+}
+
+TEST(SymmetricKey, TryUnsealReportsErrorsWithoutThrowing) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const SymmetricKey otherSymmetricKey("other seed", defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+
+	// Cover messages shorter than, equal to, and longer than the
+	// 32 bytes of message that share the Poly1305 key's keystream block
+	for (size_t length : {1, 31, 32, 33, 100}) {
+		const std::vector<unsigned char> messageVector(length, 'y');
+		const auto sealedMessage = testSymmetricKey.seal(messageVector, unsealingInstructions);
+
+		const Result<SodiumBuffer> unsealed = testSymmetricKey.tryUnseal(sealedMessage);
+		ASSERT_TRUE(unsealed.ok());
+		ASSERT_EQ(messageVector, unsealed.value().toVector());
+
+		const Result<SodiumBuffer> wrongKey = otherSymmetricKey.tryUnseal(sealedMessage);
+		ASSERT_FALSE(wrongKey.ok());
+		ASSERT_EQ(wrongKey.error().code, SeededErrorCode::CryptographicVerificationFailure);
+
+		const Result<SodiumBuffer> wrongInstructions = testSymmetricKey.tryUnseal(sealedMessage.ciphertext, "");
+		ASSERT_FALSE(wrongInstructions.ok());
+		ASSERT_EQ(wrongInstructions.error().code, SeededErrorCode::CryptographicVerificationFailure);
+	}
+
+	const std::vector<unsigned char> tooShort(crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES);
+	ASSERT_EQ(testSymmetricKey.tryUnseal(tooShort).error().code, SeededErrorCode::InvalidArgument);
+	ASSERT_THROW(testSymmetricKey.unseal(tooShort), std::invalid_argument);
+}
+
+TEST(UnsealingKey, TryUnsealReportsErrorsWithoutThrowing) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const UnsealingKey otherUnsealingKey("other seed", defaultTestPublicRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+
+	for (size_t length : {1, 32, 100}) {
+		const std::vector<unsigned char> messageVector(length, 'y');
+		const auto sealedMessage = testUnsealingKey.getSealingKey().seal(messageVector, unsealingInstructions);
+
+		const Result<SodiumBuffer> unsealed = testUnsealingKey.tryUnseal(sealedMessage);
+		ASSERT_TRUE(unsealed.ok());
+		ASSERT_EQ(messageVector, unsealed.value().toVector());
+
+		ASSERT_FALSE(otherUnsealingKey.tryUnseal(sealedMessage).ok());
+		ASSERT_EQ(
+			testUnsealingKey.tryUnseal(sealedMessage.ciphertext, "").error().code,
+			SeededErrorCode::CryptographicVerificationFailure
+		);
+		ASSERT_THROW(otherUnsealingKey.unseal(sealedMessage), CryptographicVerificationFailureException);
+	}
+}
+
+TEST(SymmetricKey, SealsAndUnsealsIntoCallerBuffers) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const std::string unsealingInstructions = "{\"userMustAcknowledgeThisMessage\": \"yoto mofo\"}";
+	const std::vector<unsigned char> messageVector = { 'y', 'o', 't', 'o' };
+
+	std::vector<unsigned char> ciphertext(testSymmetricKey.sealedLength(messageVector.size()) + 8);
+	const size_t ciphertextLength = testSymmetricKey.sealToCiphertextOnly(
+		messageVector.data(), messageVector.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+	);
+	ASSERT_EQ(ciphertextLength, testSymmetricKey.sealedLength(messageVector.size()));
+	ciphertext.resize(ciphertextLength);
+	// Sealing into a buffer produces the same ciphertext as sealing into a vector
+	ASSERT_EQ(ciphertext, testSymmetricKey.seal(messageVector, unsealingInstructions).ciphertext);
+
+	std::vector<unsigned char> plaintext(testSymmetricKey.unsealedLength(ciphertext.size()));
+	ASSERT_EQ(plaintext.size(), messageVector.size());
+	ASSERT_EQ(testSymmetricKey.unseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+	), messageVector.size());
+	ASSERT_EQ(plaintext, messageVector);
+
+	ASSERT_EQ(testSymmetricKey.tryUnseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size() - 1, unsealingInstructions
+	).error().code, SeededErrorCode::InvalidArgument);
+	// A failed unseal leaves nothing in the buffer
+	ASSERT_EQ(testSymmetricKey.tryUnseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), ""
+	).error().code, SeededErrorCode::CryptographicVerificationFailure);
+	ASSERT_EQ(plaintext, std::vector<unsigned char>(messageVector.size(), 0));
+
+	ASSERT_THROW(testSymmetricKey.sealToCiphertextOnly(
+		messageVector.data(), messageVector.size(), ciphertext.data(), ciphertext.size() - 1
+	), std::invalid_argument);
+}
+
+TEST(UnsealingKey, SealsAndUnsealsFiles) {
+	const UnsealingKey testUnsealingKey("yo", defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::vector<unsigned char> message = {'y', 'o', 't', 'o'};
+	const std::string plaintextPath = "unsealing-key-file.plaintext";
+	const std::string sealedPath = "unsealing-key-file.sealed";
+	const std::string unsealedPath = "unsealing-key-file.unsealed";
+	writeTestFile(plaintextPath, message);
+
+	testSealingKey.sealFile(plaintextPath, sealedPath, "{}");
+	ASSERT_EQ(testUnsealingKey.unsealFile(sealedPath, unsealedPath), "{}");
+	ASSERT_EQ(readTestFile(unsealedPath), message);
+	std::remove(unsealedPath.c_str());
+	ASSERT_EQ(UnsealingKey::unsealFile(sealedPath, unsealedPath, "yo"), "{}");
+	ASSERT_EQ(readTestFile(unsealedPath), message);
+
+	// A failed unseal leaves the file already at the output path untouched
+	ASSERT_THROW(UnsealingKey::unsealFile(sealedPath, unsealedPath, "not yo"), CryptographicVerificationFailureException);
+	ASSERT_EQ(readTestFile(unsealedPath), message);
+	std::remove(unsealedPath.c_str());
+	ASSERT_THROW(UnsealingKey::unsealFile(sealedPath, unsealedPath, "not yo"), CryptographicVerificationFailureException);
+	ASSERT_FALSE(testFileExists(unsealedPath));
+	std::remove(plaintextPath.c_str());
+	std::remove(sealedPath.c_str());
+}
+
+TEST(UnsealingKey, SealsAndUnsealsBatches) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::string unsealingInstructions = "{}";
+	const std::string messages[] = {"yoto", "mofo"};
+	const std::vector<BatchMessage> batch = {
+		{(const unsigned char*) messages[0].data(), messages[0].size(), &unsealingInstructions},
+		{(const unsigned char*) messages[1].data(), messages[1].size(), NULL},
+	};
+	const SealedBatch sealed = testSealingKey.sealBatch(batch.data(), batch.size());
+	ASSERT_EQ(sealed.size(), 2);
+	std::vector<BatchMessage> ciphertexts = {
+		{sealed.data(0), sealed.length(0), &unsealingInstructions},
+		{sealed.data(1), sealed.length(1), NULL},
+		{sealed.data(1), 3, NULL},
+	};
+	const UnsealedBatch unsealed = testUnsealingKey.unsealBatch(ciphertexts.data(), ciphertexts.size(), 0);
+	ASSERT_EQ(std::string((const char*) unsealed.data(0), unsealed.length(0)), messages[0]);
+	ASSERT_EQ(std::string((const char*) unsealed.data(1), unsealed.length(1)), messages[1]);
+	ASSERT_EQ(unsealed.errors[2].code, SeededErrorCode::CryptographicVerificationFailure);
+}
+
+TEST(UnsealingKey, UnsealsBatchesOnAWorkerPool) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::string unsealingInstructions = "{}";
+	const std::string wrongInstructions = "{\"nope\": true}";
+	std::vector<std::string> messages;
+	std::vector<BatchMessage> batch;
+	for (size_t i = 0; i < 200; i++) {
+		messages.push_back("message " + std::to_string(i));
+	}
+	for (const std::string& message : messages) {
+		batch.push_back({(const unsigned char*) message.data(), message.size(), &unsealingInstructions});
+	}
+	const SealedBatch sealed = testSealingKey.sealBatch(batch.data(), batch.size());
+	std::vector<BatchMessage> ciphertexts;
+	for (size_t i = 0; i < sealed.size(); i++) {
+		ciphertexts.push_back({sealed.data(i), sealed.length(i), i % 7 == 3 ? &wrongInstructions : &unsealingInstructions});
+	}
+	WorkerPool pool(4);
+	// The pool's threads are reused by the second batch
+	for (size_t pass = 0; pass < 2; pass++) {
+		const UnsealedBatch unsealed = testUnsealingKey.unsealBatch(ciphertexts.data(), ciphertexts.size(), pool);
+		ASSERT_EQ(unsealed.size(), messages.size());
+		for (size_t i = 0; i < unsealed.size(); i++) {
+			if (i % 7 == 3) {
+				ASSERT_EQ(unsealed.errors[i].code, SeededErrorCode::CryptographicVerificationFailure);
+				ASSERT_EQ(unsealed.length(i), 0);
+			} else {
+				ASSERT_TRUE(unsealed.ok(i));
+				ASSERT_EQ(std::string((const char*) unsealed.data(i), unsealed.length(i)), messages[i]);
+			}
+		}
+	}
+}
+
+TEST(WorkerPool, CallsEachIndexOnceAndRethrows) {
+	WorkerPool pool(3);
+	std::vector<std::atomic<int>> calls(1000);
+	pool.parallelFor(calls.size(), [&](const size_t i) { calls[i]++; });
+	pool.parallelFor(calls.size(), [&](const size_t i) { calls[i]++; });
+	for (const std::atomic<int>& count : calls) {
+		ASSERT_EQ(count.load(), 2);
+	}
+	ASSERT_THROW(pool.parallelFor(calls.size(), [](const size_t i) {
+		if (i == 500) {
+			throw std::invalid_argument("index 500");
+		}
+	}), std::invalid_argument);
+	// The pool remains usable after a call throws
+	size_t total = 0;
+	std::mutex totalMutex;
+	pool.parallelFor(100, [&](const size_t i) {
+		std::lock_guard<std::mutex> lock(totalMutex);
+		total += i;
+	});
+	ASSERT_EQ(total, 4950);
+}
+
+TEST(UnsealingKey, SealsAndUnsealsFragments) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::string unsealingInstructions = "{}";
+	std::vector<unsigned char> message(100, 'y');
+	const std::vector<Fragment> messageFragments = splitIntoFragments(message, {0, 1, 31, 32, 33, 64});
+
+	std::vector<unsigned char> ciphertext(SealingKey::sealedLength(message.size()));
+	ASSERT_EQ(testSealingKey.sealToCiphertextOnly(
+		messageFragments.data(), messageFragments.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+	), ciphertext.size());
+	ASSERT_EQ(testUnsealingKey.unseal(ciphertext, unsealingInstructions).toVector(), message);
+
+	const std::vector<unsigned char> contiguousCiphertext = testSealingKey.sealToCiphertextOnly(message.data(), message.size(), unsealingInstructions);
+	for (const std::vector<unsigned char>& sealed : {ciphertext, contiguousCiphertext}) {
+		// Splits within the ephemeral public key, the MAC, and the message
+		const std::vector<Fragment> ciphertextFragments = splitIntoFragments(sealed, {16, 40, 40, 50, 90});
+		std::vector<unsigned char> plaintext(message.size());
+		ASSERT_EQ(testUnsealingKey.unseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+		), message.size());
+		ASSERT_EQ(plaintext, message);
+		ASSERT_EQ(testUnsealingKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintext.data(), plaintext.size(), ""
+		).error().code, SeededErrorCode::CryptographicVerificationFailure);
+
+		std::vector<unsigned char> scattered(message.size());
+		const std::vector<OutputFragment> plaintextFragments = splitIntoOutputFragments(scattered, {0, 10, 32, 33, 64, 64});
+		ASSERT_EQ(testUnsealingKey.unseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintextFragments.data(), plaintextFragments.size(), unsealingInstructions
+		), message.size());
+		ASSERT_EQ(scattered, message);
+		ASSERT_EQ(testUnsealingKey.tryUnseal(
+			ciphertextFragments.data(), ciphertextFragments.size(), plaintextFragments.data(), plaintextFragments.size() - 1, unsealingInstructions
+		).error().code, SeededErrorCode::InvalidArgument);
+	}
+}
+
+TEST(SealingKey, SealsWithPooledEphemeralKeys) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::shared_ptr<EphemeralKeyPool> pool = std::make_shared<EphemeralKeyPool>(4, false);
+	ASSERT_EQ(pool->available(), 4);
+	testSealingKey.setEphemeralKeyPool(pool);
+	const SealingKey copy(testSealingKey);
+	const std::string message = "yoto mofo";
+	std::vector<std::vector<unsigned char>> ephemeralPublicKeys;
+	// Sealing more messages than the pool holds falls back to generating keypairs
+	for (size_t i = 0; i < 6; i++) {
+		const SealingKey& sealingKey = i % 2 == 0 ? testSealingKey : copy;
+		const PackagedSealedMessage packaged = sealingKey.seal(message, "{}");
+		ASSERT_EQ(testUnsealingKey.unseal(packaged).toUtf8String(), message);
+		ASSERT_EQ(pool->available(), i < 4 ? 3 - i : 0);
+		const std::vector<unsigned char> ephemeralPublicKey(
+			packaged.ciphertext.begin(), packaged.ciphertext.begin() + crypto_box_PUBLICKEYBYTES
+		);
+		// Each keypair is used only once
+		ASSERT_EQ(std::count(ephemeralPublicKeys.begin(), ephemeralPublicKeys.end(), ephemeralPublicKey), 0);
+		ephemeralPublicKeys.push_back(ephemeralPublicKey);
+	}
+	pool->refill();
+	ASSERT_EQ(pool->available(), 4);
+
+	// With a background refiller, sealing from many threads never runs out
+	testSealingKey.setEphemeralKeyPool(std::make_shared<EphemeralKeyPool>(8));
+	std::vector<BatchMessage> batch(64, {(const unsigned char*) message.data(), message.size(), NULL});
+	const SealedBatch sealed = testSealingKey.sealBatch(batch.data(), batch.size(), 4);
+	for (size_t i = 0; i < sealed.size(); i++) {
+		ASSERT_EQ(testUnsealingKey.unseal(sealed.data(i), sealed.length(i), "").toUtf8String(), message);
+	}
+}
+
+TEST(UnsealingKey, UnsealsMessagesSealedForManyRecipients) {
+	const std::string unsealingInstructions = "{}";
+	std::vector<UnsealingKey> unsealingKeys;
+	std::vector<SealingKey> recipients;
+	for (const std::string seed : {"recipient one", "recipient two", "recipient three"}) {
+		unsealingKeys.push_back(UnsealingKey::deriveFromSeed(seed, defaultTestPublicRecipeJson));
+		recipients.push_back(unsealingKeys.back().getSealingKey());
+	}
+	const UnsealingKey outsider = UnsealingKey::deriveFromSeed("outsider", defaultTestPublicRecipeJson);
+	const std::string message = "yoto mofo";
+	std::vector<unsigned char> envelope = SealingKey::sealForRecipients(
+		recipients, (const unsigned char*) message.data(), message.size(), unsealingInstructions
+	);
+	ASSERT_EQ(envelope.size(), SealingKey::sealedForRecipientsLength(recipients.size(), message.size()));
+	for (const UnsealingKey& unsealingKey : unsealingKeys) {
+		ASSERT_EQ(unsealingKey.unsealForRecipient(envelope, unsealingInstructions).toUtf8String(), message);
+		ASSERT_EQ(
+			unsealingKey.tryUnsealForRecipient(envelope.data(), envelope.size(), "").error().code,
+			SeededErrorCode::CryptographicVerificationFailure
+		);
+	}
+	ASSERT_THROW(outsider.unsealForRecipient(envelope, unsealingInstructions), CryptographicVerificationFailureException);
+	ASSERT_EQ(
+		unsealingKeys[0].tryUnsealForRecipient(envelope.data(), 20).error().code,
+		SeededErrorCode::CryptographicVerificationFailure
+	);
+	envelope.back() ^= 1;
+	ASSERT_THROW(unsealingKeys[1].unsealForRecipient(envelope, unsealingInstructions), CryptographicVerificationFailureException);
+	ASSERT_THROW(SealingKey::sealForRecipients({}, (const unsigned char*) message.data(), message.size()), std::invalid_argument);
+}
+
+TEST(UnsealingKey, SealsAndUnsealsStreams) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const UnsealingKey otherUnsealingKey("other seed", defaultTestPublicRecipeJson);
+	const std::string unsealingInstructions = "{}";
+	std::vector<unsigned char> plaintext(200);
+	randombytes_buf(plaintext.data(), plaintext.size());
+	const auto collect = [](std::vector<unsigned char>& into) {
+		return [&into](const unsigned char* data, const size_t length) { into.insert(into.end(), data, data + length); };
+	};
+
+	std::vector<unsigned char> sealed;
+	SealingKeyStreamSealer sealer(testSealingKey, unsealingInstructions, collect(sealed), 64);
+	sealer.init();
+	sealer.update(plaintext.data(), 100);
+	sealer.update(plaintext.data() + 100, 100);
+	sealer.final();
+	ASSERT_EQ(sealed.size(), SealingKeyStream::sealedLength(plaintext.size(), 64));
+
+	const auto unseal = [&](const UnsealingKey& key, const std::vector<unsigned char>& stream, const std::string& instructions, const size_t updateSize) {
+		std::vector<unsigned char> unsealed;
+		UnsealingKeyStreamUnsealer unsealer(key, instructions, collect(unsealed));
+		for (size_t offset = 0; offset < stream.size(); offset += updateSize) {
+			unsealer.update(stream.data() + offset, std::min(updateSize, stream.size() - offset));
+		}
+		unsealer.final();
+		return unsealed;
+	};
+	for (const size_t updateSize : {1, 13, 32, 1000}) {
+		ASSERT_EQ(unseal(testUnsealingKey, sealed, unsealingInstructions, updateSize), plaintext);
+	}
+	ASSERT_THROW(unseal(otherUnsealingKey, sealed, unsealingInstructions, 100), CryptographicVerificationFailureException);
+	ASSERT_THROW(unseal(testUnsealingKey, sealed, "", 100), CryptographicVerificationFailureException);
+	const std::vector<unsigned char> truncated(sealed.begin(), sealed.begin() + 20);
+	ASSERT_THROW(unseal(testUnsealingKey, truncated, unsealingInstructions, 100), CryptographicVerificationFailureException);
+	std::vector<unsigned char> modified(sealed);
+	modified[5] ^= 1;
+	ASSERT_THROW(unseal(testUnsealingKey, modified, unsealingInstructions, 100), CryptographicVerificationFailureException);
+}
+
+TEST(UnsealingKey, SealsAndUnsealsIntoCallerBuffers) {
+	const UnsealingKey testUnsealingKey(orderedTestKey, defaultTestPublicRecipeJson);
+	const SealingKey testSealingKey = testUnsealingKey.getSealingKey();
+	const std::string unsealingInstructions = "{}";
+	const std::vector<unsigned char> messageVector = { 'y', 'o', 't', 'o' };
+
+	std::vector<unsigned char> ciphertext(SealingKey::sealedLength(messageVector.size()));
+	ASSERT_EQ(testSealingKey.sealToCiphertextOnly(
+		messageVector.data(), messageVector.size(), ciphertext.data(), ciphertext.size(), unsealingInstructions
+	), ciphertext.size());
+	ASSERT_EQ(testUnsealingKey.unseal(ciphertext, unsealingInstructions).toVector(), messageVector);
+
+	std::vector<unsigned char> plaintext(messageVector.size());
+	ASSERT_EQ(testUnsealingKey.unseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), unsealingInstructions
+	), messageVector.size());
+	ASSERT_EQ(plaintext, messageVector);
+
+	ASSERT_EQ(testUnsealingKey.tryUnseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size() - 1, unsealingInstructions
+	).error().code, SeededErrorCode::InvalidArgument);
+	ASSERT_THROW(testUnsealingKey.unseal(
+		ciphertext.data(), ciphertext.size(), plaintext.data(), plaintext.size(), ""
+	), CryptographicVerificationFailureException);
+}
+
+TEST(SigningKey, SignsAndVerifiesFilesInChunks) {
+	const SigningKey signingKey = SigningKey::deriveFromSeed("yo", defaultTestSigningRecipeJson);
+	const SignatureVerificationKey verificationKey = signingKey.getSignatureVerificationKey();
+	const std::string path = "signing-key-file.plaintext";
+	// Longer than the chunks the file is read in
+	std::vector<unsigned char> contents(3 * 1024 * 1024 + 17);
+	for (size_t i = 0; i < contents.size(); i++) {
+		contents[i] = (unsigned char) (i * 7);
+	}
+	writeTestFile(path, contents);
+
+	const std::vector<unsigned char> signature = signingKey.generateSignatureForFile(path);
+	ASSERT_TRUE(verificationKey.verifyFile(path, signature));
+	ASSERT_FALSE(verificationKey.verify(contents, signature));
+
+	// Streamed in other pieces, the signature is the same
+	SigningKeyStreamSigner signer(signingKey);
+	signer.update(contents.data(), 5);
+	signer.update(contents.data() + 5, contents.size() - 5);
+	ASSERT_EQ(signer.final(), signature);
+	ASSERT_THROW(signer.update(contents.data(), 1), std::logic_error);
+
+	SignatureVerificationKeyStreamVerifier verifier(verificationKey);
+	verifier.update(contents.data(), contents.size() - 1);
+	ASSERT_FALSE(verifier.final(signature));
+
+	contents[1024 * 1024] ^= 1;
+	writeTestFile(path, contents);
+	ASSERT_FALSE(verificationKey.verifyFile(path, signature));
+	std::remove(path.c_str());
+	ASSERT_THROW(signingKey.generateSignatureForFile(path), std::system_error);
+}
+
+TEST(AuthenticatedBox, SealsBetweenPeersWithCachedSharedKeys) {
+	const UnsealingKey alice = UnsealingKey::deriveFromSeed("alice", R"({"type":"UnsealingKey"})");
+	const UnsealingKey bob = UnsealingKey::deriveFromSeed("bob", R"({"type":"UnsealingKey"})");
+	const UnsealingKey carol = UnsealingKey::deriveFromSeed("carol", R"({"type":"UnsealingKey"})");
+	AuthenticatedBox aliceBox(alice, 2);
+	AuthenticatedBox bobBox(bob);
+	const std::string message = "yoto mofo";
+	const std::string unsealingInstructions = "{}";
+
+	const std::vector<unsigned char> sealed = aliceBox.seal(
+		bob.getSealingKey(), (const unsigned char*) message.data(), message.size(), unsealingInstructions
+	);
+	ASSERT_EQ(sealed.size(), AuthenticatedBox::sealedLength(message.size()));
+	const SodiumBuffer unsealed = bobBox.unseal(alice.getSealingKey(), sealed, unsealingInstructions);
+	ASSERT_EQ(std::string((const char*) unsealed.data, unsealed.length), message);
+	ASSERT_EQ(bobBox.unseal(alice.getSealingKey(), sealed, unsealingInstructions).length, message.size());
+
+	ASSERT_THROW(bobBox.unseal(alice.getSealingKey(), sealed), CryptographicVerificationFailureException);
+	ASSERT_THROW(bobBox.unseal(carol.getSealingKey(), sealed, unsealingInstructions), CryptographicVerificationFailureException);
+	// Reflected back to its sender as if from the recipient
+	ASSERT_THROW(aliceBox.unseal(bob.getSealingKey(), sealed, unsealingInstructions), CryptographicVerificationFailureException);
+	ASSERT_FALSE(bobBox.tryUnseal(alice.getSealingKey(), sealed.data(), 3).ok());
+
+	// Beyond its capacity, the cache replaces the least recently used peer
+	aliceBox.seal(carol.getSealingKey(), (const unsigned char*) message.data(), message.size());
+	aliceBox.seal(alice.getSealingKey(), (const unsigned char*) message.data(), message.size());
+	ASSERT_EQ(aliceBox.cachedPeers(), 2);
+	const std::vector<unsigned char> resealed = aliceBox.seal(
+		bob.getSealingKey(), (const unsigned char*) message.data(), message.size()
+	);
+	ASSERT_EQ(bobBox.unseal(alice.getSealingKey(), resealed).length, message.size());
+	ASSERT_EQ(aliceBox.cachedPeers(), 2);
+}
+
+TEST(Keyring, UnsealsWithTheKeyIdentifiedByTheMessage) {
+	Keyring keyring;
+	std::vector<SymmetricKey> symmetricKeys;
+	std::vector<UnsealingKey> unsealingKeys;
+	for (size_t i = 0; i < 20; i++) {
+		symmetricKeys.push_back(SymmetricKey::deriveFromSeed("symmetric " + std::to_string(i), defaultTestSymmetricRecipeJson));
+		unsealingKeys.push_back(UnsealingKey::deriveFromSeed("unsealing " + std::to_string(i), defaultTestPublicRecipeJson));
+		keyring.add(symmetricKeys.back());
+		keyring.add(unsealingKeys.back());
+	}
+	ASSERT_EQ(keyring.size(), 40);
+	ASSERT_EQ(symmetricKeys[7].keyId().size(), PackagedSealedMessage::KeyIdBytes);
+	ASSERT_EQ(unsealingKeys[7].keyId(), unsealingKeys[7].getSealingKey().keyId());
+	ASSERT_EQ(keyring.findSymmetricKey(symmetricKeys[7].keyId())->keyBytes.toHexString(), symmetricKeys[7].keyBytes.toHexString());
+	ASSERT_EQ(keyring.findUnsealingKey(unsealingKeys[7].keyId())->sealingKeyBytes, unsealingKeys[7].sealingKeyBytes);
+	ASSERT_EQ(keyring.findSymmetricKey(unsealingKeys[7].keyId()), (const SymmetricKey*) NULL);
+
+	const std::string message = "yoto mofo";
+	const std::vector<unsigned char> messageVector(message.begin(), message.end());
+	const PackagedSealedMessage symmetricSealed = symmetricKeys[13].sealWithKeyId(messageVector, "{}");
+	ASSERT_EQ(symmetricSealed.keyId, symmetricKeys[13].keyId());
+	const PackagedSealedMessage publicSealed = unsealingKeys[13].getSealingKey().sealWithKeyId(messageVector, "{}");
+	ASSERT_EQ(publicSealed.keyId, unsealingKeys[13].keyId());
+	for (const PackagedSealedMessage& sealed : {symmetricSealed, publicSealed}) {
+		// The key ID survives the JSON form
+		const PackagedSealedMessage fromJson = PackagedSealedMessage::fromJson(sealed.toJson());
+		ASSERT_EQ(fromJson.keyId, sealed.keyId);
+		ASSERT_EQ(keyring.unseal(fromJson).toUtf8String(), message);
+		// Without one, the keyring falls back to trial decryption
+		const PackagedSealedMessage withoutKeyId(sealed.ciphertext, sealed.recipe, sealed.unsealingInstructions);
+		ASSERT_EQ(keyring.unseal(withoutKeyId).toUtf8String(), message);
+		const PackagedSealedMessage wrongKeyId(sealed.ciphertext, sealed.recipe, sealed.unsealingInstructions, symmetricKeys[0].keyId());
+		ASSERT_EQ(keyring.unseal(wrongKeyId).toUtf8String(), message);
+		const PackagedSealedMessage wrongInstructions(sealed.ciphertext, sealed.recipe, "", sealed.keyId);
+		ASSERT_EQ(keyring.tryUnseal(wrongInstructions).error().code, SeededErrorCode::CryptographicVerificationFailure);
+	}
+	ASSERT_THROW(Keyring().unseal(symmetricSealed), CryptographicVerificationFailureException);
+}
+
+TEST(SymmetricKey, TryFromJsonReportsErrorsWithoutThrowing) {
+	const SymmetricKey testSymmetricKey(orderedTestKey, defaultTestSymmetricRecipeJson);
+	const Result<SymmetricKey> copy = SymmetricKey::tryFromJson(testSymmetricKey.toJson());
+	ASSERT_TRUE(copy.ok());
+	ASSERT_EQ(copy.value().keyBytes.toHexString(), testSymmetricKey.keyBytes.toHexString());
+	ASSERT_EQ(copy.value().recipe, testSymmetricKey.recipe);
+
+	ASSERT_EQ(SymmetricKey::tryFromJson("{").error().code, SeededErrorCode::JsonParsing);
+	ASSERT_EQ(SymmetricKey::tryFromJson("[]").error().code, SeededErrorCode::JsonParsing);
+	ASSERT_EQ(SymmetricKey::tryFromJson(R"({"keyBytes": 7})").error().code, SeededErrorCode::JsonParsing);
+	ASSERT_EQ(SymmetricKey::tryFromJson(R"({"keyBytes": "0g"})").error().code, SeededErrorCode::InvalidHexCharacter);
+	ASSERT_EQ(SymmetricKey::tryFromJson(R"({"keyBytes": "00"})").error().code, SeededErrorCode::InvalidArgument);
+	ASSERT_THROW(SymmetricKey::fromJson("{"), JsonParsingException);
+
+	ASSERT_EQ(SealingKey::tryFromJson(R"({"keyBytes": "00"})").error().code, SeededErrorCode::InvalidRecipeValue);
+	ASSERT_EQ(SigningKey::tryFromJson(R"({"recipe": "{}"})").error().code, SeededErrorCode::JsonParsing);
+	ASSERT_EQ(PackagedSealedMessage::tryFromJson(R"({"ciphertext": "abc"})").error().code, SeededErrorCode::InvalidArgument);
+	ASSERT_TRUE(Password::tryFromJson(R"({"password": "yoto"})").ok());
+}
+
 TEST(PackagedSealedMessage, ConvertsToSerializedFormAndBack) {
 	std::vector<unsigned char> testCiphertext({ 42 });
 	PackagedSealedMessage message(testCiphertext, "no", "way");
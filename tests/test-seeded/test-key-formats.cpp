@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 #include <string>
+#include <fstream>
+#include <cstdio>
 #include "../lib-seeded/lib-seeded.hpp"
 #include "../lib-seeded/convert.hpp"
 #include "../lib-seeded/key-formats/Packet.hpp"
@@ -11,6 +13,7 @@
 #include "../lib-seeded/key-formats/OpenSshKey.hpp"
 #include "../lib-seeded/key-formats/OpenPgpKey.hpp"
 #include "../lib-seeded/key-formats/PEM.hpp"
+#include "../lib-seeded/key-formats/Minisign.hpp"
 
 
 struct TestVector {
@@ -205,6 +208,48 @@ TEST(OpenSSH, PrivateKey) {
 
 }
 
+static void writeMinisignTestFile(const std::string& path, const std::string& contents) {
+	std::ofstream file(path, std::ios::binary);
+	file << contents;
+}
+
+TEST(Minisign, SignsAndVerifiesFiles) {
+	const auto privateKey = ByteBuffer::fromHex("05AD7768A6BF76BACF11CD6E958685C2921A2D0A1F7B3313CB66FA71382FCF41");
+	SigningKey sk(SodiumBuffer(privateKey.byteVector), "");
+	SignatureVerificationKey svk = sk.getSignatureVerificationKey();
+	SignatureVerificationKey otherKey = SigningKey(SodiumBuffer(std::vector<unsigned char>(32, 1)), "").getSignatureVerificationKey();
+	const std::string path = "minisign-test-file.txt";
+	writeMinisignTestFile(path, "yoto mofo");
+
+	const std::string minisig = sk.generateMinisignSignatureForFile(path, "yoto mofo");
+	ASSERT_EQ(minisig.find("untrusted comment: "), 0);
+	ASSERT_NE(minisig.find("\ntrusted comment: yoto mofo\n"), std::string::npos);
+	ASSERT_TRUE(svk.verifyMinisignSignatureForFile(path, minisig));
+	ASSERT_FALSE(otherKey.verifyMinisignSignatureForFile(path, minisig));
+
+	std::string alteredComment = minisig;
+	alteredComment.replace(alteredComment.find("yoto mofo"), 9, "yolo mofo");
+	ASSERT_FALSE(svk.verifyMinisignSignatureForFile(path, alteredComment));
+	ASSERT_FALSE(svk.verifyMinisignSignatureForFile(path, "not a signature"));
+
+	const std::string defaultComment = sk.generateMinisignSignatureForFile(path);
+	ASSERT_NE(defaultComment.find("\tfile:minisign-test-file.txt\thashed\n"), std::string::npos);
+	ASSERT_TRUE(svk.verifyMinisignSignatureForFile(path, defaultComment));
+
+	writeMinisignTestFile(path, "yolo mofo");
+	ASSERT_FALSE(svk.verifyMinisignSignatureForFile(path, minisig));
+	std::remove(path.c_str());
+
+	// "Ed", the key ID, and the key
+	std::vector<unsigned char> publicKeyData = {'E', 'd'};
+	const std::vector<unsigned char> keyId = getMinisignKeyId(svk);
+	publicKeyData.insert(publicKeyData.end(), keyId.begin(), keyId.end());
+	publicKeyData.insert(publicKeyData.end(), svk.signatureVerificationKeyBytes.begin(), svk.signatureVerificationKeyBytes.end());
+	const std::string publicKey = svk.toMinisignPublicKey();
+	ASSERT_EQ(publicKey.find("untrusted comment: minisign public key "), 0);
+	ASSERT_EQ(publicKey.substr(publicKey.find('\n') + 1), base64Encode(publicKeyData) + "\n");
+}
+
 /*
 
 class OpenSshHelperUnitTests {
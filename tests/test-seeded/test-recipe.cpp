@@ -19,6 +19,26 @@ TEST(Recipe, GeneratesDefaults) {
 }
 
 
+TEST(Recipe, ReadsNonceType) {
+	ASSERT_EQ(
+		Recipe(R"({"nonceType": "Random"})", RecipeJson::type::SymmetricKey).recipeWithAllOptionalParametersSpecified(),
+		R"({"algorithm":"XSalsa20Poly1305","hashFunction":"BLAKE2b","nonceType":"Random","type":"SymmetricKey"})"
+	);
+	ASSERT_EQ(Recipe("", RecipeJson::type::SymmetricKey).nonceType, RecipeJson::NonceType::Synthetic);
+	// The default nonceType doesn't change the explicit form of existing recipes
+	ASSERT_EQ(
+		Recipe(R"({"type":"SymmetricKey"})").recipeWithAllOptionalParametersSpecified(),
+		R"({"algorithm":"XSalsa20Poly1305","hashFunction":"BLAKE2b","type":"SymmetricKey"})"
+	);
+	ASSERT_EQ(
+		Recipe(R"({"type":"SymmetricKey","nonceType":"Synthetic"})").recipeWithAllOptionalParametersSpecified(),
+		Recipe(R"({"type":"SymmetricKey"})").recipeWithAllOptionalParametersSpecified()
+	);
+	ASSERT_EQ(Recipe(R"({"nonceType": "Random"})", RecipeJson::type::Secret).nonceType, RecipeJson::NonceType::_INVALID_NONCE_TYPE_);
+	ASSERT_THROW(Recipe(R"({"nonceType": "Sometimes"})", RecipeJson::type::SymmetricKey), InvalidRecipeValueException);
+}
+
+
 TEST(Recipe, derivesPrimarySecrets) {
 	const SodiumBuffer seed = Recipe::derivePrimarySecret(
 		"Avocado",
@@ -77,3 +97,110 @@ TEST(Recipe, InitsWithClientPrefixes) {
 })KGO"
 );
 }
+
+TEST(Recipe, TryParseReportsErrorsWithoutThrowing) {
+	const Result<Recipe> parsed = Recipe::tryParse(R"({"type": "SymmetricKey", "purpose": "backups"})");
+	ASSERT_TRUE(parsed.ok());
+	ASSERT_EQ(parsed.value().type, RecipeJson::type::SymmetricKey);
+	ASSERT_EQ(parsed.value().lengthInBytes, 32);
+
+	ASSERT_EQ(Recipe::tryParse("{").error().code, SeededErrorCode::InvalidRecipeJson);
+	ASSERT_EQ(Recipe::tryParse("[]").error().code, SeededErrorCode::InvalidRecipeJson);
+	ASSERT_EQ(
+		Recipe::tryParse(R"({"type": "SigningKey"})", RecipeJson::type::SymmetricKey).error().code,
+		SeededErrorCode::InvalidRecipeValue
+	);
+	ASSERT_EQ(
+		Recipe::tryParse(R"({"type": "UnsealingKey", "lengthInBytes": 16})").error().code,
+		SeededErrorCode::InvalidRecipeValue
+	);
+	ASSERT_EQ(Recipe::tryParse(R"({"lengthInBytes": "16"})").error().code, SeededErrorCode::InvalidRecipeValue);
+	ASSERT_THROW(Recipe(R"({"type": "UnsealingKey", "lengthInBytes": 16})"), InvalidRecipeValueException);
+}
+
+TEST(Recipe, ReadsOnlyTopLevelFieldsAndLastValueWins) {
+	const Recipe recipe(R"KGO({
+	"type": "Secret",
+	"lengthInBytes": 16,
+	"nested": {"type": "SigningKey", "lengthInBytes": 99},
+	"list": [{"lengthInBytes": 7}, "SigningKey"],
+	"lengthInBytes": 48
+})KGO");
+	ASSERT_EQ(recipe.type, RecipeJson::type::Secret);
+	ASSERT_EQ(recipe.lengthInBytes, 48);
+	ASSERT_EQ(
+		recipe.recipeWithAllOptionalParametersSpecified(),
+		R"({"hashFunction":"BLAKE2b","lengthInBytes":48,"type":"Secret"})"
+	);
+
+	// As with nlohmann::json::value, booleans are read as numbers for
+	// unsigned int fields but not for size_t fields
+	ASSERT_EQ(Recipe(R"({"lengthInBytes": true})").lengthInBytes, 1);
+	ASSERT_EQ(
+		Recipe::tryParse(R"({"hashFunction": "Argon2id", "hashFunctionMemoryPasses": true})").error().code,
+		SeededErrorCode::InvalidRecipeValue
+	);
+	ASSERT_EQ(Recipe::tryParse(R"({"type": 3})").value().type, RecipeJson::type::_INVALID_TYPE_);
+	ASSERT_EQ(Recipe::tryParse(R"({"lengthInBytes": 32} x)").error().code, SeededErrorCode::InvalidRecipeJson);
+}
+
+TEST(Recipe, ValidatesBatchesInParallel) {
+	std::vector<std::string> recipes;
+	for (int i = 0; i < 1000; i++) {
+		recipes.push_back(
+			i % 3 == 0 ? R"({"type": "SymmetricKey"})" :
+			i % 3 == 1 ? R"({"type": "Password", "lengthInWords": 10})" :
+			R"({"type": "UnsealingKey", "lengthInBytes": 16})"
+		);
+	}
+	const std::vector<RecipeValidation> validations = validateRecipes(recipes, RecipeJson::type::_INVALID_TYPE_, 4);
+	ASSERT_EQ(validations.size(), recipes.size());
+	for (size_t i = 0; i < recipes.size(); i++) {
+		const Result<Recipe> parsed = Recipe::tryParse(recipes[i]);
+		ASSERT_EQ(validations[i].error.code, parsed.error().code);
+		if (parsed.ok()) {
+			ASSERT_EQ(validations[i].type, parsed.value().type);
+			ASSERT_EQ(validations[i].lengthInBytes, parsed.value().lengthInBytes);
+			ASSERT_EQ(
+				validations[i].recipeWithAllOptionalParametersSpecified,
+				parsed.value().recipeWithAllOptionalParametersSpecified()
+			);
+		}
+	}
+	ASSERT_EQ(validations[1].lengthInWords, 10);
+	ASSERT_EQ(validations[2].error.code, SeededErrorCode::InvalidRecipeValue);
+}
+
+TEST(SpecializedRecipe, DerivesSameSymmetricKeySecretAsRecipe) {
+	const std::string recipeJson = R"KGO({"type": "SymmetricKey", "purpose": "backups"})KGO";
+	const SpecializedRecipe<RecipeJson::type::SymmetricKey> fixedRecipe(recipeJson);
+	ASSERT_EQ(fixedRecipe.lengthInBytes(), 32);
+	ASSERT_EQ(
+		fixedRecipe.derivePrimarySecret("Avocado").toHexString(),
+		Recipe::derivePrimarySecret("Avocado", recipeJson, RecipeJson::type::SymmetricKey, 32).toHexString()
+	);
+}
+
+TEST(SpecializedRecipe, DerivesSameSecretAsRecipe) {
+	const std::string recipeJson = R"KGO({"lengthInBytes": 64})KGO";
+	const SpecializedRecipe<RecipeJson::type::Secret, RecipeJson::HashFunction::BLAKE2b, 64> fixedRecipe(recipeJson);
+	ASSERT_EQ(
+		fixedRecipe.derivePrimarySecret("Avocado").toHexString(),
+		Recipe::derivePrimarySecret("Avocado", recipeJson, RecipeJson::type::Secret).toHexString()
+	);
+}
+
+TEST(SpecializedRecipe, RejectsRecipeNotMatchingParameters) {
+	ASSERT_THROW(
+		(SpecializedRecipe<RecipeJson::type::Secret, RecipeJson::HashFunction::BLAKE2b, 64>(R"KGO({"lengthInBytes": 32})KGO")),
+		InvalidRecipeValueException
+	);
+	ASSERT_THROW(
+		(SpecializedRecipe<RecipeJson::type::Secret>(R"KGO({"hashFunction": "Argon2id"})KGO")),
+		InvalidRecipeValueException
+	);
+	ASSERT_THROW(
+		SpecializedRecipe<RecipeJson::type::SymmetricKey>(R"KGO({"type": "UnsealingKey"})KGO"),
+		InvalidRecipeValueException
+	);
+}
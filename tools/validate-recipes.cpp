@@ -0,0 +1,140 @@
+// Validates a catalog of recipes, one JSON recipe per line, by the rules
+// of the Recipe constructor.
+//
+// Usage: validate-recipes [--type=<type>] [--threads=<n>] [--batch=<n>] < recipes > results
+//
+//   --type     The type every recipe is required to have (e.g. SymmetricKey)
+//   --threads  The number of threads to validate with (default: one per core)
+//   --batch    The number of lines to read before validating them (default: 65536)
+//
+// For each input line it writes one line of JSON (with keys in
+// alphabetical order), in input order:
+//   {"line":1,"valid":true,"type":"SymmetricKey","algorithm":"XSalsa20Poly1305",
+//    "hashFunction":"BLAKE2b","lengthInBytes":32,"recipeWithAllOptionalParametersSpecified":"..."}
+//   {"line":2,"valid":false,"error":"InvalidRecipeJson","message":"Invalid JSON key recipe"}
+//
+// Input is read and validated a batch at a time, so memory use is bounded
+// by the batch size rather than by the size of the catalog.
+// The exit status is 0 if every recipe is valid, 1 if any is not,
+// and 2 for a usage error.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "lib-seeded.hpp"
+#include "parallel-for.hpp"
+
+static const char* errorCodeName(const SeededErrorCode code) {
+  switch (code) {
+    case SeededErrorCode::None: return "None";
+    case SeededErrorCode::InvalidArgument: return "InvalidArgument";
+    case SeededErrorCode::CryptographicVerificationFailure: return "CryptographicVerificationFailure";
+    case SeededErrorCode::KeyLength: return "KeyLength";
+    case SeededErrorCode::JsonParsing: return "JsonParsing";
+    case SeededErrorCode::InvalidRecipeJson: return "InvalidRecipeJson";
+    case SeededErrorCode::InvalidRecipeValue: return "InvalidRecipeValue";
+    case SeededErrorCode::InvalidHexCharacter: return "InvalidHexCharacter";
+    case SeededErrorCode::AlgorithmUnavailable: return "AlgorithmUnavailable";
+  }
+  return "Unknown";
+}
+
+static std::string resultLine(const size_t lineNumber, const RecipeValidation& validation) {
+  nlohmann::json result;
+  result["line"] = lineNumber;
+  result["valid"] = validation.ok();
+  if (!validation.ok()) {
+    result["error"] = errorCodeName(validation.error.code);
+    result["message"] = validation.error.message;
+    return result.dump();
+  }
+  if (validation.type != RecipeJson::type::_INVALID_TYPE_) {
+    result[RecipeJson::FieldNames::type] = validation.type;
+  }
+  if (validation.algorithm != RecipeJson::Algorithm::_INVALID_ALGORITHM_) {
+    result[RecipeJson::FieldNames::algorithm] = validation.algorithm;
+  }
+  result[RecipeJson::FieldNames::hashFunction] = validation.hashFunction;
+  result[RecipeJson::FieldNames::lengthInBytes] = validation.lengthInBytes;
+  if (validation.type == RecipeJson::type::Password) {
+    result[RecipeJson::FieldNames::lengthInWords] = validation.lengthInWords;
+    result[RecipeJson::FieldNames::lengthInBits] = validation.lengthInBits;
+  }
+  result["recipeWithAllOptionalParametersSpecified"] = validation.recipeWithAllOptionalParametersSpecified;
+  return result.dump();
+}
+
+static bool readOption(const char* arg, const char* name, std::string& value) {
+  const size_t nameLength = strlen(name);
+  if (strncmp(arg, name, nameLength) != 0 || arg[nameLength] != '=') {
+    return false;
+  }
+  value = arg + nameLength + 1;
+  return true;
+}
+
+static int usage() {
+  std::cerr << "Usage: validate-recipes [--type=<type>] [--threads=<n>] [--batch=<n>] < recipes > results" << std::endl;
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  RecipeJson::type typeRequired = RecipeJson::type::_INVALID_TYPE_;
+  size_t threadCount = 0;
+  size_t batchSize = 65536;
+  for (int i = 1; i < argc; i++) {
+    std::string value;
+    if (readOption(argv[i], "--type", value)) {
+      typeRequired = nlohmann::json(value).get<RecipeJson::type>();
+      if (typeRequired == RecipeJson::type::_INVALID_TYPE_) {
+        std::cerr << "Unknown type: " << value << std::endl;
+        return usage();
+      }
+    } else if (readOption(argv[i], "--threads", value)) {
+      threadCount = strtoul(value.c_str(), NULL, 10);
+    } else if (readOption(argv[i], "--batch", value)) {
+      batchSize = strtoul(value.c_str(), NULL, 10);
+      if (batchSize == 0) {
+        return usage();
+      }
+    } else {
+      return usage();
+    }
+  }
+
+  std::ios::sync_with_stdio(false);
+  std::vector<std::string> recipes;
+  std::vector<std::string> results;
+  std::vector<char> valid;
+  size_t linesRead = 0;
+  bool allValid = true;
+  std::string line;
+  bool moreInput = true;
+  while (moreInput) {
+    recipes.clear();
+    while (recipes.size() < batchSize && (moreInput = (bool) std::getline(std::cin, line))) {
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      recipes.push_back(line);
+    }
+    // Format the results on the worker threads too, so that writing
+    // them is all that's left for this thread.
+    results.resize(recipes.size());
+    valid.resize(recipes.size());
+    parallelFor(recipes.size(), [&](const size_t index) {
+      const RecipeValidation validation = validateRecipe(recipes[index], typeRequired);
+      valid[index] = validation.ok();
+      results[index] = resultLine(linesRead + index + 1, validation);
+    }, threadCount);
+    for (size_t index = 0; index < recipes.size(); index++) {
+      allValid = allValid && valid[index];
+      std::cout << results[index] << '\n';
+    }
+    linesRead += recipes.size();
+  }
+  std::cout.flush();
+  return allValid ? 0 : 1;
+}